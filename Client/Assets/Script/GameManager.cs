@@ -179,8 +179,8 @@ public class GameManager : MonoBehaviour
         _tcp = new TcpClientManager();
         _tcp.OnLine += OnTcpLine;
         bool tok = await _tcp.ConnectAsync(
-            string.IsNullOrEmpty(controlHost) ? s.worldHost : controlHost,
-            controlPort > 0 ? controlPort : 7100,
+            !string.IsNullOrEmpty(controlHost) ? controlHost : (string.IsNullOrEmpty(s.worldTcpHost) ? s.worldHost : s.worldTcpHost),
+            s.worldTcpPort > 0 ? s.worldTcpPort : (controlPort > 0 ? controlPort : 7100),
             s.actorName);
         if (!tok) { Debug.LogError("TCP connect failed"); }
     }
@@ -253,9 +253,31 @@ public class GameManager : MonoBehaviour
                 case "HELLO_OK":
                     {
                         Debug.Log(line);
+                        // κ   ް  ȭ 
+                        _tcp?.SendLine("REQ_ROOM_LIST page=0 subscribe=1");
                         break;
 
                     }
+                case "RES_ROOM_LIST":
+                    {
+                        // ROOM_ITEM ٵ ڵ.   ̾ û
+                        int page = TryI(kv, "page");
+                        int pages = TryI(kv, "pages");
+                        if (page + 1 < pages)
+                            _tcp?.SendLine($"REQ_ROOM_LIST page={page + 1}");
+                        break;
+                    }
+                case "ROOM_ITEM":
+                    {
+                        var rid = kv.GetValueOrDefault("roomId", "");
+                        var master = kv.GetValueOrDefault("master", "");
+                        var title = kv.GetValueOrDefault("title", "");
+                        int free = TryI(kv, "free");
+                        //  ġ UDP   
+                        ExistAvatar(master, Vector3.zero, SessionInfo.I != null && master == SessionInfo.I.actorName);
+                        CreateOrGetSign(rid, master, title, count: 2 - free);
+                        break;
+                    }
                 case "RES_CREATE_ROOM":
                     {
                         var rid = kv.GetValueOrDefault("roomId", "");
@@ -270,6 +292,8 @@ public class GameManager : MonoBehaviour
                         ExistMember(master);
 
                         roomCreateButton.interactable = false;
+                        //  ȿ κ ȭ ʿ  (  ٽ ޴´)
+                        _tcp?.SendLine("REQ_LOBBY_SUBSCRIBE on=0");
                         gameRoomPanel.SetActive(true);
                         gameRoomPanel.transform.Find("RoomMasterPanel").Find("RoomMasterId").GetComponent<Text>().text = master;
                         gameRoomPanel.transform.Find("RoomTitle").GetComponent<Text>().text = title;
@@ -301,6 +325,7 @@ public class GameManager : MonoBehaviour
                         if (_roomState is null)
                         {
                             _roomState = new RoomState();
+                            _tcp?.SendLine("REQ_LOBBY_SUBSCRIBE on=0");
                         }
 
                         gameRoomPanel.SetActive(true);
@@ -533,8 +558,11 @@ public class GameManager : MonoBehaviour
                             ExitRoom();
                         }
 
-                        GameObject.Destroy(_roomSigns[rid]);
-                        _roomSigns.Remove(rid);
+                        if (_roomSigns.TryGetValue(rid, out var sign))
+                        {
+                            GameObject.Destroy(sign);
+                            _roomSigns.Remove(rid);
+                        }
                         Debug.Log("BROADCAST_DELETE_ROOM");
                         break;
                     }
@@ -615,6 +643,12 @@ public class GameManager : MonoBehaviour
         gameRoomPanel.transform.Find("RoomTitle").GetComponent<Text>().text = "";
         gameRoomPanel.transform.Find("GameRule").GetComponent<Text>().text = "";
         gameRoomPanel.SetActive(false);
+
+        // 濡 ִ  ģ κ ȭ    ޴´
+        foreach (var sign in _roomSigns.Values)
+            GameObject.Destroy(sign);
+        _roomSigns.Clear();
+        _tcp?.SendLine("REQ_ROOM_LIST page=0 subscribe=1");
     }
 
     // ǳ ϱ
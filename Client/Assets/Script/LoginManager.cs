@@ -145,6 +145,31 @@ public class LoginManager : MonoBehaviour
                         Debug.Log("ID ߺ");
                         break;
                     }
+                case "ERR_RETRY":
+                    {
+                        //  պ: ˷ ð ڿ   ٽ  û
+                        int ms = TryI(kv, "retry_after_ms", 2000);
+                        Debug.Log($"ENTER_WORLD õ {ms}ms ({kv.GetValueOrDefault("reason", "")})");
+                        await Task.Delay(ms);
+                        OnClickEnterWorld();
+                        break;
+                    }
+                case "ERR":
+                    {
+                        if (kv.GetValueOrDefault("code", "") != "BUSY")
+                        {
+                            Debug.Log($"[TCP] {line}");
+                            break;
+                        }
+                        // Ʈ  :    ˷ ð ڿ ٽ 
+                        int ms = TryI(kv, "retry_after_ms", 2000);
+                        Debug.Log($"Ʈ BUSY, {ms}ms  ");
+                        _tcp?.Close();
+                        await Task.Delay(ms);
+                        if (await _tcp.ConnectAsync(gatewayHost, gatewayPort) && !string.IsNullOrEmpty(_userId))
+                            _tcp.SendLine($"LOGIN id={_userId}");
+                        break;
+                    }
                 case "ENTER_OK":
                     {
                         var udp_token = kv.GetValueOrDefault("udp_token", "");
@@ -158,6 +183,8 @@ public class LoginManager : MonoBehaviour
                         SessionInfo.I.token = udp_token;
                         SessionInfo.I.worldHost = udp_host;
                         SessionInfo.I.worldUdpPort = udp_port;
+                        SessionInfo.I.worldTcpPort = TryI(kv, "tcp_port");
+                        SessionInfo.I.worldTcpHost = kv.GetValueOrDefault("tcp_host", "");
 
                         try { _tcp?.Close(); } catch { }
 
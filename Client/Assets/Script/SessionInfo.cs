@@ -7,6 +7,8 @@ public class SessionInfo : MonoBehaviour
     public string token;   
     public string worldHost;
     public int worldUdpPort;
+    public int worldTcpPort;
+    public string worldTcpHost;
 
     void Awake()
     {
@@ -21,6 +21,12 @@ namespace Net
 
         public event Action<string, float, float> OnActorPos;
 
+        //  ð -  ð ( PING  st + rtt/2  ).   ð 
+        public long ServerClockOffsetMs { get; private set; }
+        public long ServerNowMs => Environment.TickCount64 + ServerClockOffsetMs;
+        //  ֱٿ   Ŷ  ð (SNAP t=)
+        public long LastSnapshotServerMs { get; private set; }
+
         public async Task<bool> ConnectAsync(string host, int port, string token, string actor)
         {
             _cts = new CancellationTokenSource();
@@ -89,7 +95,20 @@ namespace Net
                 string text = Encoding.ASCII.GetString(r.Buffer);
                 foreach (var line in text.Split('\n'))
                 {
-                    if (line.StartsWith("ACTOR_POS"))
+                    if (line.StartsWith("PING"))
+                    {
+                        //  RTT/ս 缭  ֱ⸦ : ٷ PONG
+                        var kv = ParseKv(line);
+                        if (long.TryParse(kv.GetValueOrDefault("st", ""), out var st) && long.TryParse(kv.GetValueOrDefault("rtt", "0"), out var rtt))
+                            ServerClockOffsetMs = st + rtt / 2 - Environment.TickCount64;
+                        _ = SendRawAsync($"PONG seq={kv.GetValueOrDefault("seq", "0")}");
+                    }
+                    else if (line.StartsWith("SNAP"))
+                    {
+                        if (long.TryParse(ParseKv(line).GetValueOrDefault("t", ""), out var t))
+                            LastSnapshotServerMs = t;
+                    }
+                    else if (line.StartsWith("ACTOR_POS"))
                     {
                         var kv = ParseKv(line);
                         if (kv.TryGetValue("id", out var id) &&
@@ -0,0 +1,131 @@
+#pragma once
+#include "common.hpp"
+#include "stats.hpp"
+#include <asio.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+// 접속 폭주(배포 직후 재접속 등) 때 쓰러지지 않고 느려지도록 들어오는 양을 조절한다
+//  - accept: 토큰 버킷만큼만 accept 하고 나머지는 커널 backlog 에서 기다리게 한다
+//  - 동시 연결 상한을 넘으면 "ERR code=BUSY retry_after_ms=.." 를 보내고 끊는다
+//  - 로그인(ENTER_WORLD)도 토큰 버킷. 모자라면 재시도 시각을 알려준다
+namespace net
+{
+    // 초당 rate 개, 최대 burst 개까지 모아 둔다. rate <= 0 이면 제한 없음 (여러 스레드에서 호출 가능)
+    class TokenBucket
+    {
+    public:
+        TokenBucket(double rate = 0, double burst = 0) { configure(rate, burst); }
+
+        void configure(double rate, double burst)
+        {
+            lock_guard<mutex> lk(m_);
+            rate_ = rate;
+            burst_ = max(1.0, burst);
+            tokens_ = burst_;
+            last_ = chrono::steady_clock::now();
+        }
+
+        bool try_take()
+        {
+            if (rate_ <= 0)
+                return true;
+            lock_guard<mutex> lk(m_);
+            refill();
+            if (tokens_ < 1)
+                return false;
+            tokens_ -= 1;
+            return true;
+        }
+
+        // 다음 토큰이 생길 때까지 (있으면 0)
+        chrono::milliseconds wait()
+        {
+            if (rate_ <= 0)
+                return chrono::milliseconds(0);
+            lock_guard<mutex> lk(m_);
+            refill();
+            if (tokens_ >= 1)
+                return chrono::milliseconds(0);
+            return chrono::milliseconds(int64_t((1 - tokens_) / rate_ * 1000) + 1);
+        }
+
+    private:
+        void refill()
+        {
+            auto now = chrono::steady_clock::now();
+            tokens_ = min(burst_, tokens_ + chrono::duration<double>(now - last_).count() * rate_);
+            last_ = now;
+        }
+
+        mutex m_;
+        double rate_ = 0, burst_ = 1, tokens_ = 1;
+        chrono::steady_clock::time_point last_;
+    };
+
+    struct Admission
+    {
+        int max_conns = 0;          // max_conns= 동시 클라이언트 연결 (0 = 제한 없음)
+        TokenBucket accept;         // accept_rate= accept_burst=
+        TokenBucket login;          // login_rate= login_burst= (게이트웨이 ENTER_WORLD)
+        int retry_ms = 2000;        // retry_ms= 과부하 거절 때 알려주는 재시도 간격 (여기에 지터를 더한다)
+        atomic<int> live{ 0 };
+
+        // 연결 하나 받기. 상한이면 false
+        bool enter()
+        {
+            static auto& rejected = stats::counter("adm.rejected_conns");
+            int n = live.fetch_add(1, memory_order_relaxed);
+            if (max_conns > 0 && n >= max_conns)
+            {
+                live.fetch_sub(1, memory_order_relaxed);
+                rejected.add();
+                return false;
+            }
+            return true;
+        }
+        void leave() { live.fetch_sub(1, memory_order_relaxed); }
+
+        // 한꺼번에 다시 몰리지 않게 [base, 2*base) 로 흩는다
+        int retry_after(int base_ms) const
+        {
+            static thread_local mt19937 rng{ random_device{}() };
+            base_ms = max(base_ms, 100);
+            return base_ms + int(rng() % uint32_t(base_ms));
+        }
+    };
+
+    inline Admission& admission()
+    {
+        static Admission a;
+        return a;
+    }
+
+    inline void set_admission(const unordered_map<string, string>& opts, double accept_rate, double login_rate)
+    {
+        auto get = [&](const char* k, double d) { return common::opt_double(opts, k, d); };
+        auto& a = admission();
+        a.max_conns = int(get("max_conns", 0));
+        double ar = get("accept_rate", accept_rate);
+        a.accept.configure(ar, get("accept_burst", ar / 2));
+        double lr = get("login_rate", login_rate);
+        a.login.configure(lr, get("login_burst", lr / 2));
+        a.retry_ms = int(get("retry_ms", 2000));
+    }
+
+    // 상한 초과 연결: 재시도 시각만 알리고 끊는다 (새 소켓이라 송신 버퍼는 비어 있다)
+    inline void reject_busy(asio::ip::tcp::socket& s)
+    {
+        string line = "ERR code=BUSY retry_after_ms=" + to_string(admission().retry_after(admission().retry_ms)) + "\n";
+        error_code ec;
+        asio::write(s, asio::buffer(line), ec);
+        s.close(ec);
+    }
+}
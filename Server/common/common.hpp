@@ -1,9 +1,11 @@
 #pragma once
+#include <charconv>
 #include <chrono>
 #include <format>
 #include <iostream>
 #include <mutex>
 #include <string>
+#include <unordered_map>
 
 using namespace std;
 
@@ -18,8 +20,14 @@ namespace common
         os << format("{:%H:%M:%S}", zoned_time{ current_zone(), tp });
         return os.str();
     }
+    inline bool& log_muted()
+    {
+        static bool muted = false;
+        return muted;
+    }
     inline void log(const char* tag, const string& msg) 
     {
+        if (log_muted()) return;
         static mutex m; lock_guard<mutex> lk(m);
         cout << "[" << now() << "][" << tag << "] " << msg << endl;
     }
@@ -34,5 +42,46 @@ namespace common
             return d; 
         } 
     }
+    // to_int 와 같이 잘못된 값이면 기본값 (옵션 오타로 프로세스가 죽지 않게)
+    inline double to_double(const string& s, double d)
+    {
+        double v = 0;
+        auto r = from_chars(s.data(), s.data() + s.size(), v);
+        return r.ec == errc() && r.ptr == s.data() + s.size() ? v : d;
+    }
+    inline size_t to_size(const string& s, size_t d)
+    {
+        size_t v = 0;
+        auto r = from_chars(s.data(), s.data() + s.size(), v);
+        return r.ec == errc() && r.ptr == s.data() + s.size() ? v : d;
+    }
+    // argv[first..] 중 key=value 형태만 모아서 반환
+    inline unordered_map<string, string> options(int argc, char* argv[], int first)
+    {
+        unordered_map<string, string> m;
+        for (int i = first; i < argc; i++)
+        {
+            string tok = argv[i];
+            auto p = tok.find('=');
+            if (p != string::npos)
+                m[tok.substr(0, p)] = tok.substr(p + 1);
+        }
+        return m;
+    }
+    inline int opt_int(const unordered_map<string, string>& m, const string& key, int d)
+    {
+        auto it = m.find(key);
+        return it == m.end() ? d : to_int(it->second.c_str(), d);
+    }
+    inline double opt_double(const unordered_map<string, string>& m, const string& key, double d)
+    {
+        auto it = m.find(key);
+        return it == m.end() ? d : to_double(it->second, d);
+    }
+    inline size_t opt_size(const unordered_map<string, string>& m, const string& key, size_t d)
+    {
+        auto it = m.find(key);
+        return it == m.end() ? d : to_size(it->second, d);
+    }
     inline void title(const char*) {} 
 }
\ No newline at end of file
@@ -0,0 +1,19 @@
+#pragma once
+#if defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+namespace stats
+{
+    // 프로세스 전체 CPU 시간 (초, user + sys). 리눅스 외에는 0
+    inline double process_cpu_s()
+    {
+#if defined(__linux__)
+        rusage ru{};
+        getrusage(RUSAGE_SELF, &ru);
+        return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+#else
+        return 0.0;
+#endif
+    }
+}
@@ -0,0 +1,257 @@
+#pragma once
+#include "stats.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace net
+{
+    // 스레드별 크기 등급 free-list. asio 핸들러 메모리를 재사용한다
+    // 블록 앞에 만든 스레드를 적어 두고, 다른 스레드에서 해제된 블록은 그 스레드의 remote 스택으로 돌려보낸다
+    // (코어별 모드에서 한 방향으로만 넘어가는 작업도 보낸 쪽 free-list 가 마르지 않는다)
+    // 주인 스레드는 자기 free-list 가 비었을 때 remote 스택을 한 번에 가져온다
+    // HandlerMemory 객체는 스레드마다 하나씩 일부러 남긴다 (스레드가 끝난 뒤에도 다른 스레드가 블록을 돌려주러 온다)
+    //   LSan 에서는 leak:net::HandlerMemory::local 로 억제한다
+    class HandlerMemory
+    {
+    public:
+        static constexpr size_t kMinBlock = 64;
+        static constexpr size_t kClasses = 6;     // 64 .. 2048
+        static constexpr size_t kMaxCached = 256; // 등급당 보관 개수
+
+        static void* allocate(size_t n)
+        {
+            size_t c = size_class(n);
+            if (c >= kClasses)
+            {
+                heap().add();
+                return ::operator new(n);
+            }
+            HandlerMemory* me = local();
+            if (me && me->free_[c].empty())
+                me->collect_remote(c);
+            if (me && !me->free_[c].empty())
+            {
+                Header* h = me->free_[c].back();
+                me->free_[c].pop_back();
+                recycled().add();
+                return h + 1;
+            }
+            heap().add();
+            Header* h = static_cast<Header*>(::operator new(sizeof(Header) + block_size(c)));
+            h->owner = me; // 정리된 스레드에서 만든 블록은 주인이 없다
+            return h + 1;
+        }
+
+        static void deallocate(void* p, size_t n)
+        {
+            size_t c = size_class(n);
+            if (c >= kClasses)
+            {
+                ::operator delete(p);
+                return;
+            }
+            Header* h = static_cast<Header*>(p) - 1;
+            HandlerMemory* me = local();
+            if (!h->owner)
+                ::operator delete(h);
+            else if (h->owner == me)
+                me->cache(c, h);
+            else
+                h->owner->remote_free(c, h);
+        }
+
+        static stats::Counter& heap()
+        {
+            static auto& c = stats::counter("alloc.handler_heap");
+            return c;
+        }
+        static stats::Counter& recycled()
+        {
+            static auto& c = stats::counter("alloc.handler_recycled");
+            return c;
+        }
+
+        static stats::Counter& remote()
+        {
+            static auto& c = stats::counter("alloc.handler_remote_free");
+            return c;
+        }
+
+    private:
+        // 블록 머리. next 는 remote 스택에 있을 때만 쓴다 (크기를 max_align_t 에 맞춰 뒤 블록 정렬 유지)
+        struct alignas(alignof(max_align_t)) Header
+        {
+            HandlerMemory* owner;
+            Header* next;
+        };
+
+        // 스레드 정리가 시작되면 (Retirer 소멸 후) nullptr. 이후 할당은 free-list 없이 힙으로 간다
+        // Slot 은 소멸자가 없어서 다른 thread_local 의 소멸자 안에서 불려도 안전하다
+        static HandlerMemory* local()
+        {
+            struct Slot
+            {
+                HandlerMemory* m = nullptr;
+                bool retired = false;
+            };
+            struct Retirer
+            {
+                Slot& s;
+                ~Retirer()
+                {
+                    s.retired = true;
+                    s.m->retire();
+                    s.m = nullptr;
+                }
+            };
+            thread_local Slot s;
+            if (!s.m && !s.retired)
+            {
+                s.m = new HandlerMemory;
+                thread_local Retirer r{ s };
+            }
+            return s.m;
+        }
+
+        HandlerMemory()
+        {
+            for (auto& v : free_)
+                v.reserve(kMaxCached);
+        }
+
+        void cache(size_t c, Header* h)
+        {
+            if (free_[c].size() < kMaxCached)
+                free_[c].push_back(h);
+            else
+                ::operator delete(h);
+        }
+
+        // 다른 스레드에서 호출. 주인이 끝났으면 (closed) 바로 지운다
+        void remote_free(size_t c, Header* h)
+        {
+            remote().add();
+            Header* head = remote_[c].load(memory_order_relaxed);
+            do
+            {
+                if (head == closed())
+                {
+                    ::operator delete(h);
+                    return;
+                }
+                h->next = head;
+            } while (!remote_[c].compare_exchange_weak(head, h, memory_order_release, memory_order_relaxed));
+        }
+
+        // 통째로 가져오므로 ABA 가 없다
+        void collect_remote(size_t c)
+        {
+            if (!remote_[c].load(memory_order_relaxed))
+                return;
+            Header* h = remote_[c].exchange(nullptr, memory_order_acquire);
+            while (h)
+            {
+                Header* next = h->next;
+                cache(c, h);
+                h = next;
+            }
+        }
+
+        void retire()
+        {
+            for (size_t c = 0; c < kClasses; c++)
+            {
+                Header* h = remote_[c].exchange(closed(), memory_order_acquire);
+                while (h)
+                {
+                    Header* next = h->next;
+                    ::operator delete(h);
+                    h = next;
+                }
+                for (Header* p : free_[c])
+                    ::operator delete(p);
+                free_[c] = {};
+            }
+        }
+
+        static Header* closed()
+        {
+            static Header c{};
+            return &c;
+        }
+
+        static size_t block_size(size_t c) { return kMinBlock << c; }
+        static size_t size_class(size_t n)
+        {
+            size_t c = 0;
+            while (c < kClasses && block_size(c) < n) c++;
+            return c;
+        }
+
+        array<vector<Header*>, kClasses> free_;
+        array<atomic<Header*>, kClasses> remote_{};
+    };
+
+    template <class T>
+    class recycling_allocator
+    {
+    public:
+        using value_type = T;
+
+        recycling_allocator() noexcept = default;
+        template <class U>
+        recycling_allocator(const recycling_allocator<U>&) noexcept {}
+
+        T* allocate(size_t n)
+        {
+            return static_cast<T*>(HandlerMemory::allocate(n * sizeof(T)));
+        }
+        void deallocate(T* p, size_t n)
+        {
+            HandlerMemory::deallocate(p, n * sizeof(T));
+        }
+
+        template <class U>
+        struct rebind { using other = recycling_allocator<U>; };
+
+        template <class U>
+        bool operator==(const recycling_allocator<U>&) const noexcept { return true; }
+        template <class U>
+        bool operator!=(const recycling_allocator<U>&) const noexcept { return false; }
+    };
+
+    // asio associated_allocator 로 recycling_allocator 를 붙인 핸들러
+    // bind_executor 와 같이 쓸 때는 bind_executor(strand, recycled(h)) 순서로 감싼다
+    template <class Handler>
+    class recycled_handler
+    {
+    public:
+        using allocator_type = recycling_allocator<void>;
+
+        explicit recycled_handler(Handler h) : h_(move(h)) {}
+
+        allocator_type get_allocator() const noexcept { return {}; }
+
+        template <class... Args>
+        void operator()(Args&&... args)
+        {
+            h_(forward<Args>(args)...);
+        }
+
+    private:
+        Handler h_;
+    };
+
+    template <class Handler>
+    recycled_handler<decay_t<Handler>> recycled(Handler&& h)
+    {
+        return recycled_handler<decay_t<Handler>>(forward<Handler>(h));
+    }
+}
@@ -0,0 +1,161 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+using namespace std;
+
+namespace crypto
+{
+    // SHA-256 (FIPS 180-4). 외부 라이브러리 없이 토큰 서명용으로만 쓴다
+    class Sha256
+    {
+    public:
+        using Digest = array<uint8_t, 32>;
+
+        Sha256() { reset(); }
+
+        void reset()
+        {
+            h_ = { 0x6a09e667u, 0xbb67ae85u, 0x3c6ef372u, 0xa54ff53au, 0x510e527fu, 0x9b05688cu, 0x1f83d9abu, 0x5be0cd19u };
+            len_ = 0;
+            used_ = 0;
+        }
+
+        void update(const void* data, size_t n)
+        {
+            const uint8_t* p = static_cast<const uint8_t*>(data);
+            len_ += n;
+            while (n > 0)
+            {
+                size_t k = min(n, sizeof(buf_) - used_);
+                memcpy(buf_ + used_, p, k);
+                used_ += k;
+                p += k;
+                n -= k;
+                if (used_ == sizeof(buf_))
+                {
+                    block(buf_);
+                    used_ = 0;
+                }
+            }
+        }
+        void update(const string& s) { update(s.data(), s.size()); }
+
+        Digest finish()
+        {
+            uint64_t bits = len_ * 8;
+            uint8_t pad = 0x80;
+            update(&pad, 1);
+            uint8_t zero = 0;
+            while (used_ != 56)
+                update(&zero, 1);
+            uint8_t be[8];
+            for (int i = 0; i < 8; i++)
+                be[i] = uint8_t(bits >> (56 - 8 * i));
+            update(be, 8);
+
+            Digest d;
+            for (int i = 0; i < 8; i++)
+                for (int j = 0; j < 4; j++)
+                    d[i * 4 + j] = uint8_t(h_[i] >> (24 - 8 * j));
+            return d;
+        }
+
+    private:
+        static uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+        void block(const uint8_t* b)
+        {
+            static const uint32_t k[64] = {
+                0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+                0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+                0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+                0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+                0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+                0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+                0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+                0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+            };
+            uint32_t w[64];
+            for (int i = 0; i < 16; i++)
+                w[i] = uint32_t(b[i * 4]) << 24 | uint32_t(b[i * 4 + 1]) << 16 | uint32_t(b[i * 4 + 2]) << 8 | b[i * 4 + 3];
+            for (int i = 16; i < 64; i++)
+            {
+                uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+            uint32_t a = h_[0], bb = h_[1], c = h_[2], d = h_[3], e = h_[4], f = h_[5], g = h_[6], h = h_[7];
+            for (int i = 0; i < 64; i++)
+            {
+                uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+                uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & bb) ^ (a & c) ^ (bb & c));
+                h = g; g = f; f = e; e = d + t1;
+                d = c; c = bb; bb = a; a = t1 + t2;
+            }
+            h_[0] += a; h_[1] += bb; h_[2] += c; h_[3] += d;
+            h_[4] += e; h_[5] += f; h_[6] += g; h_[7] += h;
+        }
+
+        array<uint32_t, 8> h_{};
+        uint64_t len_ = 0;
+        uint8_t buf_[64]{};
+        size_t used_ = 0;
+    };
+
+    // HMAC-SHA256 (RFC 2104)
+    inline Sha256::Digest hmac_sha256(const string& key, const string& msg)
+    {
+        uint8_t k[64]{};
+        if (key.size() > sizeof(k))
+        {
+            Sha256 kh;
+            kh.update(key);
+            auto d = kh.finish();
+            memcpy(k, d.data(), d.size());
+        }
+        else
+            memcpy(k, key.data(), key.size());
+
+        uint8_t ipad[64], opad[64];
+        for (int i = 0; i < 64; i++)
+        {
+            ipad[i] = k[i] ^ 0x36;
+            opad[i] = k[i] ^ 0x5c;
+        }
+        Sha256 in;
+        in.update(ipad, sizeof(ipad));
+        in.update(msg);
+        auto inner = in.finish();
+        Sha256 out;
+        out.update(opad, sizeof(opad));
+        out.update(inner.data(), inner.size());
+        return out.finish();
+    }
+
+    // 길이만 같으면 내용과 관계없이 같은 시간이 걸리는 비교 (MAC 검증용)
+    inline bool equal_ct(const string& a, const string& b)
+    {
+        if (a.size() != b.size())
+            return false;
+        uint8_t diff = 0;
+        for (size_t i = 0; i < a.size(); i++)
+            diff |= uint8_t(a[i] ^ b[i]);
+        return diff == 0;
+    }
+
+    inline string to_hex(const uint8_t* p, size_t n)
+    {
+        static const char* hex = "0123456789abcdef";
+        string s(n * 2, '0');
+        for (size_t i = 0; i < n; i++)
+        {
+            s[i * 2] = hex[p[i] >> 4];
+            s[i * 2 + 1] = hex[p[i] & 15];
+        }
+        return s;
+    }
+}
@@ -0,0 +1,222 @@
+#pragma once
+#include "mpmc_queue.hpp"
+#include "handler_alloc.hpp"
+#include "stats.hpp"
+#include <asio.hpp>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace std;
+
+namespace net
+{
+    // 코어 사이로 넘기는 작업 하나. 함수 객체를 HandlerMemory 블록에 바로 담는다
+    // (std::function 은 캡처가 크면 힙에서 할당하고, 받은 코어에서 해제하면 보낸 코어로 돌아가지 않았다)
+    class Task
+    {
+    public:
+        // invoke=false 면 실행하지 않고 해제만 (종료 때 남은 작업)
+        virtual void complete(bool invoke) = 0;
+
+        template <class F>
+        static Task* make(F&& f);
+
+    protected:
+        ~Task() = default;
+    };
+
+    template <class F>
+    class TaskOf final : public Task
+    {
+    public:
+        explicit TaskOf(F f) : f_(move(f)) {}
+
+        void complete(bool invoke) override
+        {
+            // asio 처럼 실행 전에 블록을 돌려준다 (실행 중에 다시 post 하면 같은 블록을 쓴다)
+            F f(move(f_));
+            this->~TaskOf();
+            HandlerMemory::deallocate(this, sizeof(TaskOf));
+            if (invoke)
+                f();
+        }
+
+    private:
+        F f_;
+    };
+
+    template <class F>
+    Task* Task::make(F&& f)
+    {
+        using T = TaskOf<decay_t<F>>;
+        static_assert(alignof(T) <= alignof(max_align_t), "over-aligned task");
+        return new (HandlerMemory::allocate(sizeof(T))) T(forward<F>(f));
+    }
+
+    // 다른 코어에서 들어오는 작업 큐. lock-free 큐에 넣고, 비어 있다가 처음 들어올 때만
+    // 대상 io_context 에 drain 을 한 번 post 해서 깨운다
+    class Mailbox
+    {
+    public:
+        explicit Mailbox(asio::io_context& io, size_t capacity = 1 << 16)
+            : io_(io), q_(capacity)
+        {
+        }
+
+        ~Mailbox()
+        {
+            Task* t;
+            while (q_.try_pop(t))
+                t->complete(false);
+        }
+
+        template <class F>
+        void push(F&& f)
+        {
+            static auto& pushed = stats::counter("core.mailbox_pushed");
+            static auto& overflow = stats::counter("core.mailbox_overflow");
+            pushed.add();
+            Task* t = Task::make(forward<F>(f));
+            if (!q_.try_push(t))
+            {
+                // 큐가 가득 차면 asio 큐로 우회 (순서는 보장하지 않음)
+                overflow.add();
+                asio::post(io_, recycled([t] { t->complete(true); }));
+                return;
+            }
+            if (!armed_.exchange(true, memory_order_acq_rel))
+                asio::post(io_, recycled([this] { drain(); }));
+        }
+
+    private:
+        void drain()
+        {
+            Task* t;
+            for (int n = 0; n < kBatch; n++)
+            {
+                if (!q_.try_pop(t))
+                {
+                    armed_.store(false, memory_order_release);
+                    // 내려놓는 사이에 들어온 작업이 있으면 다시 잡는다
+                    if (q_.empty() || armed_.exchange(true, memory_order_acq_rel))
+                        return;
+                    continue;
+                }
+                t->complete(true);
+            }
+            // 배치 한도를 넘기면 다른 핸들러에게 양보
+            asio::post(io_, recycled([this] { drain(); }));
+        }
+
+        static constexpr int kBatch = 256;
+
+        asio::io_context& io_;
+        MpmcQueue<Task*> q_;
+        atomic<bool> armed_{ false };
+    };
+
+    // 코어당 io_context 하나를 각자의 스레드에서 돌린다 (thread-per-core)
+    // 세션은 accept 시점에 한 코어에 배정되고, 코어 간 통신은 Mailbox 로만 한다
+    class IoPool
+    {
+    public:
+        IoPool(int n, bool pin, bool least_load)
+            : pin_(pin), least_load_(least_load)
+        {
+            n = max(1, n);
+            for (int i = 0; i < n; i++)
+                cores_.push_back(make_unique<Core>());
+        }
+
+        int size() const { return (int)cores_.size(); }
+        asio::io_context& io(int i) { return cores_[i]->io; }
+
+        // 새 세션을 받을 코어 (라운드로빈 / 최소 부하)
+        int pick()
+        {
+            if (!least_load_)
+                return (int)(rr_.fetch_add(1, memory_order_relaxed) % cores_.size());
+            int best = 0;
+            for (int i = 1; i < size(); i++)
+                if (cores_[i]->load.load(memory_order_relaxed) < cores_[best]->load.load(memory_order_relaxed))
+                    best = i;
+            return best;
+        }
+        void add_load(int i, int d) { cores_[i]->load.fetch_add(d, memory_order_relaxed); }
+
+        template <class F>
+        void post(int i, F&& f) { cores_[i]->mailbox.push(forward<F>(f)); }
+        bool on_core(int i) const { return current_core() == i; }
+
+        static int& current_core()
+        {
+            thread_local int core = -1;
+            return core;
+        }
+
+        // 모든 코어를 돌리고 끝날 때까지 대기
+        void run()
+        {
+            vector<thread> ths;
+            ths.reserve(cores_.size());
+            for (int i = 0; i < size(); i++)
+            {
+                ths.emplace_back([this, i]
+                    {
+                        current_core() = i;
+                        if (pin_) pin_to_cpu(i);
+                        auto guard = asio::make_work_guard(cores_[i]->io);
+                        cores_[i]->io.run();
+                    });
+            }
+            for (auto& t : ths)
+                t.join();
+        }
+
+        void stop()
+        {
+            for (auto& c : cores_)
+                c->io.stop();
+        }
+
+    private:
+        struct Core
+        {
+            asio::io_context io{ 1 };
+            Mailbox mailbox{ io };
+            atomic<int> load{ 0 };
+        };
+
+        static void pin_to_cpu(int i)
+        {
+            unsigned ncpu = max(1u, thread::hardware_concurrency());
+#if defined(_WIN32)
+            SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << (i % ncpu));
+#elif defined(__linux__)
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(i % ncpu, &set);
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+            (void)i; (void)ncpu;
+#endif
+        }
+
+        vector<unique_ptr<Core>> cores_;
+        atomic<unsigned> rr_{ 0 };
+        bool pin_;
+        bool least_load_;
+    };
+}
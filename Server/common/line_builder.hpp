@@ -0,0 +1,98 @@
+#pragma once
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+namespace proto
+{
+    // 메시지 한 종류의 줄 형식: "CMD k1=v1 k2=v2 ..." 의 CMD 와 키 순서
+    template <size_t N>
+    struct Schema
+    {
+        const char* cmd;
+        array<const char*, N> keys;
+    };
+
+    // 스레드마다 하나씩 미리 잡아 둔 버퍼에 줄을 만든다 (조각마다 임시 string 을 만들지 않는다)
+    // 돌려준 참조는 같은 스레드에서 다음 build 전까지만 유효하다. 세션 큐에 넣을 사본은 copy_line 으로
+    class LineBuilder
+    {
+    public:
+        static LineBuilder& local()
+        {
+            static thread_local LineBuilder b;
+            return b;
+        }
+
+        template <size_t N, class... V>
+        const string& build(const Schema<N>& s, const V&... v)
+        {
+            static_assert(sizeof...(V) == N, "value count must match the schema");
+            buf_.clear();
+            buf_ += s.cmd;
+            size_t i = 0;
+            (field(s.keys[i++], v), ...);
+            return buf_;
+        }
+
+    private:
+        LineBuilder() { buf_.reserve(4096); }
+
+        template <class T>
+        void field(const char* key, const T& v)
+        {
+            buf_ += ' ';
+            buf_ += key;
+            buf_ += '=';
+            value(v);
+        }
+
+        void value(string_view v) { buf_ += v; }
+        void value(const string& v) { buf_ += v; }
+        void value(const char* v) { buf_ += v; }
+        // 클라이언트(C#) bool.Parse 형식
+        void value(bool v) { buf_ += v ? "True" : "False"; }
+
+        template <class T, enable_if_t<is_integral_v<T> && !is_same_v<T, bool>, int> = 0>
+        void value(T v)
+        {
+            char tmp[24];
+            buf_.append(tmp, to_chars(tmp, tmp + sizeof(tmp), v).ptr);
+        }
+
+        // 쉼표로 잇는다 (카드 목록)
+        template <class T>
+        void value(const vector<T>& v)
+        {
+            for (size_t i = 0; i < v.size(); i++)
+            {
+                if (i)
+                    buf_ += ',';
+                value(v[i]);
+            }
+        }
+
+        string buf_;
+    };
+
+    template <size_t N, class... V>
+    const string& build(const Schema<N>& s, const V&... v)
+    {
+        return LineBuilder::local().build(s, v...);
+    }
+
+    // 세션 송신 큐에 넘길 사본. 보낼 때 붙는 '\n' 자리까지 잡아서 다시 할당하지 않는다
+    inline string copy_line(string_view line)
+    {
+        string s;
+        s.reserve(line.size() + 1);
+        s.append(line);
+        return s;
+    }
+}
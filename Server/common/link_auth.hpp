@@ -0,0 +1,25 @@
+#pragma once
+#include "hmac.hpp"
+#include <string>
+
+using namespace std;
+
+// 게이트웨이 링크 인증. 월드의 TCP 포트는 클라이언트에게도 열려 있으므로
+// GW_HELLO 에 udp_key 로 서명한 mac 이 있어야 링크로 본다 (동시 연결 상한/송수신 한도 면제)
+//   mac = HMAC-SHA256(key, "GW_HELLO|" + gw) 앞 128비트
+// gw 는 게이트웨이 프로세스마다 새로 뽑는 값이라 키 없이는 다른 게이트웨이 몫을 만들 수 없다
+namespace linkauth
+{
+    inline constexpr size_t kMacBytes = 16;
+
+    inline string mac(const string& key, const string& gw)
+    {
+        auto d = crypto::hmac_sha256(key, "GW_HELLO|" + gw);
+        return crypto::to_hex(d.data(), kMacBytes);
+    }
+
+    inline bool verify(const string& key, const string& gw, const string& m)
+    {
+        return crypto::equal_ct(m, mac(key, gw));
+    }
+}
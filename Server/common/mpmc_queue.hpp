@@ -0,0 +1,93 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+using namespace std;
+
+namespace net
+{
+    // 고정 크기 lock-free 큐 (Vyukov bounded MPMC). 용량은 2의 거듭제곱으로 올림
+    // try_push 는 성공했을 때만 v 를 move 한다
+    template <class T>
+    class MpmcQueue
+    {
+    public:
+        explicit MpmcQueue(size_t capacity)
+        {
+            size_t cap = 2;
+            while (cap < capacity) cap <<= 1;
+            mask_ = cap - 1;
+            cells_ = make_unique<Cell[]>(cap);
+            for (size_t i = 0; i < cap; i++)
+                cells_[i].seq.store(i, memory_order_relaxed);
+        }
+
+        bool try_push(T& v)
+        {
+            size_t pos = enq_.load(memory_order_relaxed);
+            for (;;)
+            {
+                Cell& c = cells_[pos & mask_];
+                size_t seq = c.seq.load(memory_order_acquire);
+                intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+                if (dif == 0)
+                {
+                    if (enq_.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+                    {
+                        c.data = move(v);
+                        c.seq.store(pos + 1, memory_order_release);
+                        return true;
+                    }
+                }
+                else if (dif < 0)
+                    return false; // full
+                else
+                    pos = enq_.load(memory_order_relaxed);
+            }
+        }
+
+        bool try_pop(T& out)
+        {
+            size_t pos = deq_.load(memory_order_relaxed);
+            for (;;)
+            {
+                Cell& c = cells_[pos & mask_];
+                size_t seq = c.seq.load(memory_order_acquire);
+                intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+                if (dif == 0)
+                {
+                    if (deq_.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+                    {
+                        out = move(c.data);
+                        c.seq.store(pos + mask_ + 1, memory_order_release);
+                        return true;
+                    }
+                }
+                else if (dif < 0)
+                    return false; // empty
+                else
+                    pos = deq_.load(memory_order_relaxed);
+            }
+        }
+
+        bool empty() const
+        {
+            return enq_.load(memory_order_acquire) == deq_.load(memory_order_acquire);
+        }
+
+    private:
+        struct Cell
+        {
+            atomic<size_t> seq{ 0 };
+            T data{};
+        };
+
+        unique_ptr<Cell[]> cells_;
+        size_t mask_ = 0;
+        alignas(64) atomic<size_t> enq_{ 0 };
+        alignas(64) atomic<size_t> deq_{ 0 };
+    };
+}
@@ -1,6 +1,7 @@
 #pragma once
 #define ASIO_STANDALONE
 #include <asio.hpp>
+#include <charconv>
 #include <thread>
 #include <string>
 #include <unordered_map>
@@ -56,4 +57,15 @@ namespace net
 		return { move(cmd), move(kv) };
 	}
 
+	// 클라이언트 줄의 정수 필드. 없거나 전부 숫자가 아니면 false (stoi 처럼 던지지 않는다)
+	inline bool kv_int(const unordered_map<string, string>& kv, const char* key, int& out)
+	{
+		auto it = kv.find(key);
+		if (it == kv.end())
+			return false;
+		const string& v = it->second;
+		auto [end, ec] = from_chars(v.data(), v.data() + v.size(), out);
+		return ec == errc() && end == v.data() + v.size();
+	}
+
 }
\ No newline at end of file
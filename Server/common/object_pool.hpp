@@ -0,0 +1,95 @@
+#pragma once
+#include "handler_alloc.hpp"
+#include "stats.hpp"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace net
+{
+    // 세션 객체 free-list. 마지막 shared_ptr 가 사라지면 delete 대신 풀로 돌아온다
+    // 재사용 시 reuse(T&) 로 상태만 갈아끼우므로 버퍼/큐 용량이 유지된다
+    template <class T>
+    class ObjectPool
+    {
+    public:
+        explicit ObjectPool(const string& name, size_t max_free = 1024)
+            : st_(make_shared<State>(name, max_free))
+        {
+        }
+
+        template <class Make, class Reuse>
+        shared_ptr<T> acquire(Make&& make, Reuse&& reuse)
+        {
+            T* p = nullptr;
+            {
+                lock_guard<mutex> lk(st_->m);
+                if (!st_->free.empty())
+                {
+                    p = st_->free.back();
+                    st_->free.pop_back();
+                }
+            }
+            if (p)
+            {
+                st_->reused.add();
+                reuse(*p);
+            }
+            else
+            {
+                st_->created.add();
+                p = make();
+            }
+            st_->live.add();
+            return shared_ptr<T>(p, Deleter{ st_ }, recycling_allocator<T>());
+        }
+
+    private:
+        struct State
+        {
+            State(const string& name, size_t max_free)
+                : max_free(max_free)
+                , created(stats::counter("pool." + name + ".created"))
+                , reused(stats::counter("pool." + name + ".reused"))
+                , live(stats::counter("pool." + name + ".live"))
+            {
+                free.reserve(max_free);
+            }
+            ~State()
+            {
+                for (T* p : free) delete p;
+            }
+
+            mutex m;
+            vector<T*> free;
+            size_t max_free;
+            stats::Counter& created;
+            stats::Counter& reused;
+            stats::Counter& live;
+        };
+
+        struct Deleter
+        {
+            shared_ptr<State> st;
+
+            void operator()(T* p) const
+            {
+                st->live.sub();
+                {
+                    lock_guard<mutex> lk(st->m);
+                    if (st->free.size() < st->max_free)
+                    {
+                        st->free.push_back(p);
+                        return;
+                    }
+                }
+                delete p;
+            }
+        };
+
+        shared_ptr<State> st_;
+    };
+}
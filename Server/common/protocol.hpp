@@ -1,14 +1,66 @@
 #pragma once
 #include <string>
+#include "line_builder.hpp"
 
 namespace proto
 {
-    inline constexpr const char* GW_REGISTER_UDP_TOKEN = "GW_REGISTER_UDP_TOKEN";
+    // 게이트웨이 -> 월드 링크 첫 줄. UDP 토큰은 HMAC 으로 서명해서 월드가 직접 검증하므로 등록 왕복은 없다
+    inline constexpr const char* GW_HELLO = "GW_HELLO";
+    // 월드 -> 클라이언트 주기 알림. 안 보낸 것이 있으면 새 것은 합쳐서 버려도 된다 (송신 큐가 밀릴 때)
+    inline constexpr const char* HEART_BEAT = "BROADCAST_HEART_BEAT";
+    inline bool coalescable(const std::string& line) { return line.rfind(HEART_BEAT, 0) == 0; }
+    // 프록시 모드: 게이트웨이가 클라이언트 컨트롤 연결이 끊겼음을 월드에 알리는 Client 프레임 라인
+    inline constexpr const char* CLIENT_BYE = "CLIENT_BYE";
 
-    inline string CreateUdpToken(string token, string actor, int ttl_ms)
+    // 메시지별 줄 형식 (proto::build 로 만든다). 키 순서가 곧 보내는 순서
+    namespace msg
     {
-        return string(GW_REGISTER_UDP_TOKEN) + " token=" + token +
-            " actor=" + actor +
-            " ttl=" + to_string(ttl_ms) + "\n";
+        // 월드 -> 클라이언트 (룸/게임 알림)
+        inline constexpr Schema<3> BROADCAST_CREATE_ROOM{ "BROADCAST_CREATE_ROOM", { "roomId", "master", "title" } };
+        inline constexpr Schema<2> BROADCAST_ENTER_ROOM{ "BROADCAST_ENTER_ROOM", { "roomId", "title" } };
+        inline constexpr Schema<2> BROADCAST_DELETE_ROOM{ "BROADCAST_DELETE_ROOM", { "roomId", "master" } };
+        inline constexpr Schema<2> BROADCAST_CHANGE_ROOM_MASTER{ "BROADCAST_CHANGE_ROOM_MASTER", { "roomId", "master" } };
+        inline constexpr Schema<2> BROADCAST_EXIT_ROOM{ "BROADCAST_EXIT_ROOM", { "roomId", "title" } };
+        inline constexpr Schema<6> CAST_ENTER_ROOM{ "CAST_ENTER_ROOM", { "roomId", "master", "challenger", "title", "rows", "cols" } };
+        inline constexpr Schema<2> CAST_CHANGE_READY{ "CAST_CHANGE_READY", { "roomId", "isReady" } };
+        inline constexpr Schema<5> CAST_GAME_START{ "CAST_GAME_START", { "roomId", "cards", "dur", "all_dur", "phase" } };
+        inline constexpr Schema<4> CAST_FIRST_FLIP_END{ "CAST_FIRST_FLIP_END", { "roomId", "turn", "masterScore", "challengerScore" } };
+        inline constexpr Schema<6> CAST_FLIP_RESULT{ "CAST_FLIP_RESULT", { "roomId", "index", "card", "turn", "masterScore", "challengerScore" } };
+        inline constexpr Schema<7> CAST_END_GAME{ "CAST_END_GAME", { "roomId", "index", "card", "turn", "masterScore", "challengerScore", "winner" } };
+        inline constexpr Schema<3> CAST_EXIT_ROOM{ "CAST_EXIT_ROOM", { "roomId", "master", "exitActor" } };
+        inline constexpr Schema<3> CAST_CHANGE_RULE{ "CAST_CHANGE_RULE", { "roomId", "cols", "rows" } };
+        inline constexpr Schema<2> CAST_FORCED_END_GAME{ "CAST_FORCED_END_GAME", { "roomId", "phase" } };
+        // 로비 목록: 머리 줄 뒤에 count 개의 ROOM_ITEM 줄 (free = 빈 자리 수)
+        inline constexpr Schema<4> RES_ROOM_LIST{ "RES_ROOM_LIST", { "page", "pages", "total", "count" } };
+        inline constexpr Schema<6> ROOM_ITEM{ "ROOM_ITEM", { "roomId", "title", "master", "challenger", "phase", "free" } };
+        inline constexpr Schema<1> RES_LOBBY_SUBSCRIBE{ "RES_LOBBY_SUBSCRIBE", { "on" } };
+        // 관전 시작 때 룸 상태 한 줄. board 는 카드 값 목록 (아직 안 맞춘 카드는 -1), first 는 지금 뒤집혀 있는 첫 카드
+        inline constexpr Schema<13> RES_WATCH_ROOM{ "RES_WATCH_ROOM", { "roomId", "title", "master", "challenger", "rows", "cols",
+            "phase", "turn", "masterScore", "challengerScore", "board", "first", "watchers" } };
+        inline constexpr Schema<1> RES_UNWATCH_ROOM{ "RES_UNWATCH_ROOM", { "roomId" } };
+        // 보던 룸이 없어졌다
+        inline constexpr Schema<1> CAST_WATCH_END{ "CAST_WATCH_END", { "roomId" } };
+        inline constexpr Schema<1> BROADCAST_EXIT_SERVER{ "BROADCAST_EXIT_SERVER", { "actor" } };
+
+        // 게이트웨이 -> 클라이언트 (로그인/입장 응답)
+        inline constexpr Schema<2> LOGIN_OK{ "LOGIN_OK", { "token", "worldCount" } };
+        inline constexpr Schema<6> ENTER_OK{ "ENTER_OK", { "udp_host", "udp_port", "tcp_port", "world", "udp_token", "actor" } };
+        // 프록시 모드: 컨트롤 연결은 게이트웨이로
+        inline constexpr Schema<7> ENTER_OK_PROXY{ "ENTER_OK", { "udp_host", "udp_port", "tcp_host", "tcp_port", "world", "udp_token", "actor" } };
+        inline constexpr Schema<2> ERR_RETRY{ "ERR_RETRY", { "retry_after_ms", "reason" } };
+        inline constexpr Schema<3> ERR_RETRY_WORLD{ "ERR_RETRY", { "retry_after_ms", "reason", "world" } };
+        inline constexpr Schema<1> ERR_WORLD_UNAVAILABLE{ "ERR_WORLD_UNAVAILABLE", { "world" } };
+        inline constexpr Schema<1> ERR_WORLD_UNAVAILABLE_ACTOR{ "ERR_WORLD_UNAVAILABLE", { "actor" } };
+        inline constexpr Schema<0> ERR_ID_EXSIT{ "ERR_ID_EXSIT ", {} }; // 예전 줄 그대로 (뒤 공백 포함)
+        inline constexpr Schema<1> ERR{ "ERR", { "code" } };
+        inline constexpr Schema<2> ERR_ROOM{ "ERR", { "code", "roomId" } };
+
+        // 게이트웨이 -> 월드
+        inline constexpr Schema<2> ENTER{ "ENTER", { "actor", "gw" } };
+
+        // 월드 -> 게이트웨이 (연결마다 등록, 1초마다 부하, 나간 actor)
+        inline constexpr Schema<5> WORLD_REGISTER{ "WORLD_REGISTER", { "id", "name", "udp_host", "udp_port", "tcp_port" } };
+        inline constexpr Schema<7> WORLD_LOAD{ "WORLD_LOAD", { "id", "actors", "rooms", "overrun", "cpu", "qdepth", "overload" } };
+        inline constexpr Schema<1> EXIT_USER{ "EXIT_USER", { "id" } };
     }
 }
\ No newline at end of file
@@ -0,0 +1,108 @@
+#pragma once
+#include "common.hpp"
+#include "stats.hpp"
+#include <asio.hpp>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+using namespace std;
+
+namespace net
+{
+    // 클라이언트 연결 수신 버퍼 크기 = 한 줄 최대 길이 (max_line=, 기본 4 KiB)
+    // 링크 연결(rpc 프레임)은 최대 프레임이 들어갈 만큼 따로 잡는다
+    inline size_t& max_line()
+    {
+        static size_t n = 4096;
+        return n;
+    }
+
+    inline void set_recv_limits(const unordered_map<string, string>& opts)
+    {
+        max_line() = max<size_t>(256, common::opt_size(opts, "max_line", max_line()));
+    }
+
+    // 고정 크기 수신 버퍼. 늘어나지 않으므로 연결당 메모리가 cap 으로 정해진다
+    //   [begin_, end_) 가 아직 처리 안 한 바이트. prepare() 가 앞을 당겨서 뒤쪽 빈 자리를 준다
+    // 할당한 바이트는 mem.recv_buffers 에 모인다 (프로세스 전체)
+    class RecvBuffer
+    {
+    public:
+        explicit RecvBuffer(size_t cap) { resize(cap); }
+        ~RecvBuffer() { account(-int64_t(cap_)); }
+        RecvBuffer(const RecvBuffer&) = delete;
+        RecvBuffer& operator=(const RecvBuffer&) = delete;
+
+        // 남은 내용은 유지 (새 크기보다 크면 안 된다)
+        void resize(size_t cap)
+        {
+            if (cap == cap_)
+                return;
+            size_t n = size();
+            auto next = make_unique<char[]>(cap);
+            if (n)
+                memcpy(next.get(), data(), n);
+            account(int64_t(cap) - int64_t(cap_));
+            buf_ = move(next);
+            cap_ = cap;
+            begin_ = 0;
+            end_ = n;
+        }
+        size_t capacity() const { return cap_; }
+
+        const char* data() const { return buf_.get() + begin_; }
+        size_t size() const { return end_ - begin_; }
+        bool full() const { return size() == cap_; }
+        void consume(size_t n)
+        {
+            begin_ += n;
+            if (begin_ == end_)
+                begin_ = end_ = 0;
+        }
+        void clear() { begin_ = end_ = 0; }
+
+        // 읽어 넣을 빈 자리 (꽉 찼으면 크기 0)
+        asio::mutable_buffer prepare()
+        {
+            if (begin_ > 0 && end_ == cap_)
+            {
+                memmove(buf_.get(), buf_.get() + begin_, size());
+                end_ -= begin_;
+                begin_ = 0;
+            }
+            return asio::buffer(buf_.get() + end_, cap_ - end_);
+        }
+        void commit(size_t n) { end_ += n; }
+
+        // 완성된 줄 하나를 꺼낸다 ('\n', '\r' 제외). 다음 prepare() 전까지 유효
+        bool next_line(string_view& line)
+        {
+            const char* p = data();
+            auto* nl = static_cast<const char*>(memchr(p, '\n', size()));
+            if (!nl)
+                return false;
+            size_t len = size_t(nl - p);
+            line = string_view(p, len);
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+            consume(len + 1);
+            return true;
+        }
+
+    private:
+        static void account(int64_t d)
+        {
+            static auto& held = stats::counter("mem.recv_buffers");
+            held.add(d);
+        }
+
+        unique_ptr<char[]> buf_;
+        size_t cap_ = 0;
+        size_t begin_ = 0;
+        size_t end_ = 0;
+    };
+}
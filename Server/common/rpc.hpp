@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// 게이트웨이 <-> 월드 링크용 길이 접두 프레임
+//   [u32 len][u8 type][u32 id][payload ...]   (little-endian, len = type 부터 끝까지)
+// payload 는 기존 라인과 같은 "CMD k=v ..." 텍스트. 요청/응답은 id 로 짝을 맞추고,
+// 응답을 기다리지 않고 연달아 보낼 수 있다 (pipelining). 여러 프레임을 한 번에 write 해도 된다
+// 링크는 "GW_HELLO rpc=1\n" 한 줄을 보낸 뒤부터 프레임 모드로 바뀐다
+namespace rpc
+{
+    enum class Type : uint8_t
+    {
+        Request = 1,
+        Response = 2,
+        Event = 3, // 응답 없는 단방향 알림 (EXIT_USER 등)
+        // 게이트웨이 프록시 모드 (id 는 쓰지 않는다)
+        Client = 4, // "<actor> <라인>": 게이트웨이 -> 월드는 클라이언트가 보낸 줄, 월드 -> 게이트웨이는 그 클라이언트에게 보낼 줄
+        Fanout = 5, // "<actor,actor,..|*> <라인>": 월드 -> 게이트웨이. 여러 클라이언트에게 같은 줄 (* = 이 월드의 프록시 클라이언트 전부)
+    };
+
+    inline constexpr size_t kHeader = 4 + 1 + 4;
+    inline constexpr size_t kMaxFrame = 1 << 20;
+    inline constexpr size_t kMaxBuffered = 4 + kMaxFrame; // 링크 수신 버퍼 크기 (가장 큰 프레임 하나)
+
+    struct Frame
+    {
+        Type type = Type::Event;
+        uint32_t id = 0;
+        string_view payload;
+    };
+
+    inline void put_u32(string& out, uint32_t v)
+    {
+        char b[4] = { char(v), char(v >> 8), char(v >> 16), char(v >> 24) };
+        out.append(b, 4);
+    }
+    inline uint32_t get_u32(const char* p)
+    {
+        const auto* u = reinterpret_cast<const unsigned char*>(p);
+        return uint32_t(u[0]) | uint32_t(u[1]) << 8 | uint32_t(u[2]) << 16 | uint32_t(u[3]) << 24;
+    }
+
+    // Client/Fanout payload 를 대상과 라인으로 나눈다 (공백이 없으면 false)
+    inline bool split_target(string_view payload, string_view& target, string_view& line)
+    {
+        auto sp = payload.find(' ');
+        if (sp == string_view::npos)
+            return false;
+        target = payload.substr(0, sp);
+        line = payload.substr(sp + 1);
+        return true;
+    }
+
+    inline void append(string& out, Type t, uint32_t id, string_view payload)
+    {
+        put_u32(out, uint32_t(1 + 4 + payload.size()));
+        out.push_back(char(t));
+        put_u32(out, id);
+        out.append(payload.data(), payload.size());
+    }
+
+    // 완성된 프레임이 있으면 f 를 채우고 소비한 바이트 수, 모자라면 0, 깨졌으면 -1
+    inline long parse(const char* p, size_t n, Frame& f)
+    {
+        if (n < 4) return 0;
+        uint32_t len = get_u32(p);
+        if (len < 5 || len > kMaxFrame) return -1;
+        if (n < 4 + size_t(len)) return 0;
+        f.type = Type(uint8_t(p[4]));
+        f.id = get_u32(p + 5);
+        f.payload = string_view(p + kHeader, len - 5);
+        return long(4 + len);
+    }
+}
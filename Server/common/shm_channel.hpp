@@ -0,0 +1,320 @@
+#pragma once
+#if defined(__linux__)
+#include <asio.hpp>
+#include "stats.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <system_error>
+#include <vector>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+
+// 같은 호스트의 게이트웨이 <-> 월드 링크용 공유 메모리 전송
+//  - memfd 하나에 SPSC 바이트 링 두 개 (링 0: 게이트웨이 -> 월드, 링 1: 월드 -> 게이트웨이)
+//  - 깨우기는 프로세스마다 eventfd 하나. 상대가 자고 있을 때만 (waiting 플래그) 신호를 보낸다
+//  - 연결 수립과 fd 전달(SCM_RIGHTS)은 유닉스 소켓으로 하고, 그 소켓은 상대 생존 확인용으로 열어 둔다
+// 링에는 TCP 링크와 같은 바이트(첫 줄 GW_HELLO + rpc 프레임)가 흐르므로 위쪽 코드는 그대로다
+namespace shm
+{
+    static_assert(atomic<uint64_t>::is_always_lock_free, "shared-memory ring needs lock-free 64-bit atomics");
+
+    struct RingHeader
+    {
+        alignas(64) atomic<uint64_t> head{ 0 }; // 소비자만 쓴다
+        alignas(64) atomic<uint64_t> tail{ 0 }; // 생산자만 쓴다
+        alignas(64) atomic<uint32_t> reader_waiting{ 0 };
+        atomic<uint32_t> writer_waiting{ 0 };
+    };
+
+    // head/tail 은 계속 증가하고 cap(2의 거듭제곱)으로 나머지를 취해 위치를 정한다
+    class Ring
+    {
+    public:
+        Ring() = default;
+        Ring(void* base, size_t cap)
+            : h_(static_cast<RingHeader*>(base)), data_(static_cast<char*>(base) + sizeof(RingHeader)), cap_(cap)
+        {
+        }
+
+        static size_t bytes(size_t cap) { return sizeof(RingHeader) + cap; }
+        RingHeader& header() { return *h_; }
+
+        // 빈 자리만큼 넣고 넣은 바이트 수를 돌려준다
+        size_t write(const char* p, size_t n)
+        {
+            uint64_t t = h_->tail.load(memory_order_relaxed);
+            uint64_t hd = h_->head.load(memory_order_acquire);
+            n = min(n, cap_ - size_t(t - hd));
+            if (n == 0)
+                return 0;
+            size_t off = size_t(t & (cap_ - 1));
+            size_t first = min(n, cap_ - off);
+            memcpy(data_ + off, p, first);
+            memcpy(data_, p + first, n - first);
+            // seq_cst: 뒤따르는 reader_waiting 확인과 순서가 바뀌면 깨우기를 놓친다
+            h_->tail.store(t + n, memory_order_seq_cst);
+            return n;
+        }
+
+        // 있는 것을 최대 max 바이트 p 에 꺼낸다
+        size_t read(char* p, size_t max)
+        {
+            uint64_t hd = h_->head.load(memory_order_relaxed);
+            uint64_t t = h_->tail.load(memory_order_acquire);
+            size_t n = min(size_t(t - hd), max);
+            if (n == 0)
+                return 0;
+            size_t off = size_t(hd & (cap_ - 1));
+            size_t first = min(n, cap_ - off);
+            memcpy(p, data_ + off, first);
+            memcpy(p + first, data_, n - first);
+            h_->head.store(hd + n, memory_order_seq_cst);
+            return n;
+        }
+
+        bool empty() const { return h_->head.load(memory_order_seq_cst) == h_->tail.load(memory_order_seq_cst); }
+        bool full() const { return h_->tail.load(memory_order_seq_cst) - h_->head.load(memory_order_seq_cst) == cap_; }
+
+    private:
+        RingHeader* h_ = nullptr;
+        char* data_ = nullptr;
+        size_t cap_ = 0;
+    };
+
+    inline constexpr size_t kDefaultCap = 1 << 20;
+
+    // 월드(수락 쪽)가 만든다: memfd 와 eventfd 두 개 (fds[0]=memfd, fds[1]=게이트웨이용, fds[2]=월드용)
+    inline bool create_segment(size_t cap, int fds[3])
+    {
+        size_t size = 2 * Ring::bytes(cap);
+        int mfd = memfd_create("cardflip-link", MFD_CLOEXEC);
+        if (mfd < 0)
+            return false;
+        if (ftruncate(mfd, off_t(size)) != 0)
+        {
+            ::close(mfd);
+            return false;
+        }
+        void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, mfd, 0);
+        if (base == MAP_FAILED)
+        {
+            ::close(mfd);
+            return false;
+        }
+        new (base) RingHeader();
+        new (static_cast<char*>(base) + Ring::bytes(cap)) RingHeader();
+        munmap(base, size);
+        fds[0] = mfd;
+        fds[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        fds[2] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        return fds[1] >= 0 && fds[2] >= 0;
+    }
+
+    // 유닉스 소켓으로 fd 세 개와 링 크기를 넘긴다
+    inline bool send_fds(int sock, const int fds[3], uint32_t cap)
+    {
+        char ctrl[CMSG_SPACE(3 * sizeof(int))]{};
+        iovec iov{ &cap, sizeof(cap) };
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = ctrl;
+        msg.msg_controllen = sizeof(ctrl);
+        cmsghdr* c = CMSG_FIRSTHDR(&msg);
+        c->cmsg_level = SOL_SOCKET;
+        c->cmsg_type = SCM_RIGHTS;
+        c->cmsg_len = CMSG_LEN(3 * sizeof(int));
+        memcpy(CMSG_DATA(c), fds, 3 * sizeof(int));
+        return ::sendmsg(sock, &msg, MSG_NOSIGNAL) == ssize_t(sizeof(cap));
+    }
+
+    inline bool recv_fds(int sock, int fds[3], uint32_t& cap)
+    {
+        char ctrl[CMSG_SPACE(3 * sizeof(int))]{};
+        iovec iov{ &cap, sizeof(cap) };
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = ctrl;
+        msg.msg_controllen = sizeof(ctrl);
+        if (::recvmsg(sock, &msg, MSG_CMSG_CLOEXEC) != ssize_t(sizeof(cap)))
+            return false;
+        cmsghdr* c = CMSG_FIRSTHDR(&msg);
+        if (!c || c->cmsg_type != SCM_RIGHTS || c->cmsg_len != CMSG_LEN(3 * sizeof(int)))
+            return false;
+        memcpy(fds, CMSG_DATA(c), 3 * sizeof(int));
+        return true;
+    }
+
+    // 링 한 쌍 위의 양방향 바이트 스트림. 모든 코루틴/호출은 ex(strand) 하나에서
+    class Channel
+    {
+    public:
+        using local = asio::local::stream_protocol;
+
+        // side 0 = 게이트웨이 (링 0 송신, 링 1 수신, fds[1] 로 깨어남), side 1 = 월드. fd 소유권을 넘겨받는다
+        Channel(asio::any_io_executor ex, const int fds[3], size_t cap, int side, local::socket peer)
+            : cap_(cap)
+            , my_efd_(ex, fds[side == 0 ? 1 : 2])
+            , peer_efd_(fds[side == 0 ? 2 : 1])
+            , peer_(move(peer))
+            , data_signal_(ex, asio::steady_timer::time_point::max())
+            , space_signal_(ex, asio::steady_timer::time_point::max())
+        {
+            size_ = 2 * Ring::bytes(cap);
+            base_ = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+            ::close(fds[0]);
+            if (base_ == MAP_FAILED)
+                throw system_error(errno, generic_category(), "mmap");
+            Ring r0(base_, cap), r1(static_cast<char*>(base_) + Ring::bytes(cap), cap);
+            tx_ = side == 0 ? r0 : r1;
+            rx_ = side == 0 ? r1 : r0;
+        }
+
+        ~Channel()
+        {
+            close();
+            if (base_ && base_ != MAP_FAILED)
+                munmap(base_, size_);
+            ::close(peer_efd_);
+        }
+
+        // 깨우기/생존 확인 코루틴 기동 (owner 가 끝날 때까지 Channel 을 잡고 있어야 한다)
+        void start(shared_ptr<Channel> self)
+        {
+            asio::co_spawn(data_signal_.get_executor(), pump(self), asio::detached);
+            asio::co_spawn(data_signal_.get_executor(), watch(self), asio::detached);
+        }
+
+        // 들어온 바이트를 dst 에 (최대 dst 크기). 없으면 기다린다. 상대가 끊기면 ec = eof
+        asio::awaitable<size_t> read(asio::mutable_buffer dst, error_code& ec)
+        {
+            ec = {};
+            auto& h = rx_.header();
+            for (;;)
+            {
+                if (closed_)
+                {
+                    ec = asio::error::eof;
+                    co_return 0;
+                }
+                size_t n = rx_.read(static_cast<char*>(dst.data()), dst.size());
+                if (n > 0)
+                {
+                    if (h.writer_waiting.exchange(0))
+                        notify();
+                    co_return n;
+                }
+                h.reader_waiting.store(1, memory_order_seq_cst);
+                if (!rx_.empty())
+                {
+                    h.reader_waiting.store(0, memory_order_relaxed);
+                    continue;
+                }
+                error_code ignore;
+                co_await data_signal_.async_wait(asio::redirect_error(asio::use_awaitable, ignore));
+            }
+        }
+
+        // 전부 링에 넣을 때까지 (꽉 차면 상대가 비워 줄 때까지 기다린다)
+        asio::awaitable<void> write(const vector<asio::const_buffer>& bufs, error_code& ec)
+        {
+            ec = {};
+            auto& h = tx_.header();
+            for (const auto& b : bufs)
+            {
+                const char* p = static_cast<const char*>(b.data());
+                size_t n = b.size();
+                while (n > 0)
+                {
+                    if (closed_)
+                    {
+                        ec = asio::error::eof;
+                        co_return;
+                    }
+                    size_t k = tx_.write(p, n);
+                    p += k;
+                    n -= k;
+                    if (k > 0 && h.reader_waiting.exchange(0))
+                        notify();
+                    if (n == 0)
+                        break;
+                    h.writer_waiting.store(1, memory_order_seq_cst);
+                    if (!tx_.full())
+                    {
+                        h.writer_waiting.store(0, memory_order_relaxed);
+                        continue;
+                    }
+                    error_code ignore;
+                    co_await space_signal_.async_wait(asio::redirect_error(asio::use_awaitable, ignore));
+                }
+            }
+        }
+
+        void close()
+        {
+            if (closed_)
+                return;
+            closed_ = true;
+            error_code ignore;
+            my_efd_.close(ignore);
+            peer_.close(ignore);
+            data_signal_.cancel();
+            space_signal_.cancel();
+        }
+        bool closed() const { return closed_; }
+
+    private:
+        void notify()
+        {
+            static auto& wakeups = stats::counter("shm.wakeups");
+            uint64_t one = 1;
+            if (::write(peer_efd_, &one, sizeof(one)) == ssize_t(sizeof(one)))
+                wakeups.add();
+        }
+
+        asio::awaitable<void> pump([[maybe_unused]] shared_ptr<Channel> self)
+        {
+            error_code ec;
+            while (!closed_)
+            {
+                co_await my_efd_.async_read_some(asio::buffer(&efd_val_, sizeof(efd_val_)), asio::redirect_error(asio::use_awaitable, ec));
+                if (ec && ec != asio::error::would_block)
+                    break;
+                data_signal_.cancel();
+                space_signal_.cancel();
+            }
+        }
+
+        // 유닉스 소켓은 수립 후 아무것도 오가지 않는다. 읽히면(EOF) 상대가 죽은 것
+        asio::awaitable<void> watch([[maybe_unused]] shared_ptr<Channel> self)
+        {
+            char b;
+            error_code ec;
+            co_await peer_.async_read_some(asio::buffer(&b, 1), asio::redirect_error(asio::use_awaitable, ec));
+            close();
+        }
+
+        size_t cap_;
+        size_t size_ = 0;
+        void* base_ = nullptr;
+        Ring tx_, rx_;
+        asio::posix::stream_descriptor my_efd_;
+        int peer_efd_;
+        local::socket peer_;
+        uint64_t efd_val_ = 0;
+        asio::steady_timer data_signal_;
+        asio::steady_timer space_signal_;
+        bool closed_ = false;
+    };
+}
+#endif
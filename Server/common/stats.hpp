@@ -0,0 +1,126 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+namespace stats
+{
+    // 프로세스 전체 카운터. 이름으로 한 번 찾아서 참조를 들고 쓴다
+    //   static auto& c = stats::counter("tcp.dropped_bytes"); c.add(n);
+    struct Counter
+    {
+        atomic<int64_t> v{ 0 };
+
+        void add(int64_t n = 1) { v.fetch_add(n, memory_order_relaxed); }
+        void sub(int64_t n = 1) { v.fetch_sub(n, memory_order_relaxed); }
+        void set(int64_t n) { v.store(n, memory_order_relaxed); }
+        int64_t get() const { return v.load(memory_order_relaxed); }
+    };
+
+    // 지연 분포 (마이크로초, 2의 거듭제곱 버킷). 백분위는 버킷 상한으로 근사
+    struct Histogram
+    {
+        static constexpr int kBuckets = 32;
+
+        array<atomic<int64_t>, kBuckets> buckets{};
+        atomic<int64_t> count{ 0 };
+        atomic<int64_t> sum{ 0 };
+
+        void record(int64_t us)
+        {
+            int b = 0;
+            while (b < kBuckets - 1 && (int64_t(1) << b) < us) b++;
+            buckets[b].fetch_add(1, memory_order_relaxed);
+            count.fetch_add(1, memory_order_relaxed);
+            sum.fetch_add(us, memory_order_relaxed);
+        }
+        void record_since(chrono::steady_clock::time_point t0)
+        {
+            record(chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - t0).count());
+        }
+        int64_t percentile(double p) const
+        {
+            int64_t n = count.load(memory_order_relaxed);
+            if (n == 0) return 0;
+            int64_t want = int64_t(n * p), seen = 0;
+            for (int b = 0; b < kBuckets; b++)
+            {
+                seen += buckets[b].load(memory_order_relaxed);
+                if (seen > want) return int64_t(1) << b;
+            }
+            return int64_t(1) << (kBuckets - 1);
+        }
+    };
+
+    class Registry
+    {
+    public:
+        Counter& counter(const string& name)
+        {
+            lock_guard<mutex> lk(m_);
+            for (auto& [n, c] : items_)
+                if (n == name) return c;
+            items_.emplace_back(piecewise_construct, forward_as_tuple(name), forward_as_tuple());
+            return items_.back().second;
+        }
+
+        Histogram& histogram(const string& name)
+        {
+            lock_guard<mutex> lk(m_);
+            for (auto& [n, h] : hists_)
+                if (n == name) return h;
+            hists_.emplace_back(piecewise_construct, forward_as_tuple(name), forward_as_tuple());
+            return hists_.back().second;
+        }
+
+        // "name=value name=value ..." (라인 프로토콜과 같은 형식)
+        string dump() const
+        {
+            lock_guard<mutex> lk(m_);
+            string out;
+            for (const auto& [n, c] : items_)
+            {
+                if (!out.empty()) out += ' ';
+                out += n + "=" + to_string(c.get());
+            }
+            for (const auto& [n, h] : hists_)
+            {
+                if (!out.empty()) out += ' ';
+                out += n + ".n=" + to_string(h.count.load(memory_order_relaxed))
+                    + " " + n + ".p50=" + to_string(h.percentile(0.50))
+                    + " " + n + ".p99=" + to_string(h.percentile(0.99));
+            }
+            return out;
+        }
+
+    private:
+        mutable mutex m_;
+        deque<pair<string, Counter>> items_; // deque: 참조 안정성
+        deque<pair<string, Histogram>> hists_;
+    };
+
+    inline Registry& registry()
+    {
+        static Registry r;
+        return r;
+    }
+    inline Counter& counter(const string& name)
+    {
+        return registry().counter(name);
+    }
+    inline Histogram& histogram(const string& name)
+    {
+        return registry().histogram(name);
+    }
+    inline string dump()
+    {
+        return registry().dump();
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+using namespace std;
+
+namespace net
+{
+    // 쓰는 쪽 하나, 읽는 쪽 하나 사이의 최신 값 전달 (잠금/할당 없음)
+    // 버퍼 셋을 돌려 쓴다: 쓰는 쪽은 back() 을 채우고 publish(), 읽는 쪽은 acquire() 후 front() 를 읽는다
+    // 읽는 쪽이 느리면 중간 값은 건너뛰고 가장 최근 것만 받는다. 버퍼는 다시 쓰므로 안의 vector 용량이 유지된다
+    template <class T>
+    class TripleBuffer
+    {
+    public:
+        T& back() { return bufs_[back_]; }
+
+        // back 을 내놓고 다른 버퍼를 새 back 으로. 읽히지 않은 이전 값을 덮었으면 true
+        bool publish()
+        {
+            uint8_t prev = mid_.exchange(uint8_t(back_ | kFresh), memory_order_acq_rel);
+            back_ = uint8_t(prev & kIndex);
+            return (prev & kFresh) != 0;
+        }
+
+        // 새로 publish 된 값이 있으면 front 로 가져온다
+        bool acquire()
+        {
+            if ((mid_.load(memory_order_relaxed) & kFresh) == 0)
+                return false;
+            uint8_t prev = mid_.exchange(front_, memory_order_acq_rel);
+            front_ = uint8_t(prev & kIndex);
+            return true;
+        }
+
+        const T& front() const { return bufs_[front_]; }
+
+    private:
+        static constexpr uint8_t kIndex = 3;
+        static constexpr uint8_t kFresh = 4;
+
+        array<T, 3> bufs_{};
+        uint8_t back_ = 0;          // 쓰는 쪽만
+        uint8_t front_ = 1;         // 읽는 쪽만
+        atomic<uint8_t> mid_{ 2 };  // 주고받는 자리 (+ 새 값 표시)
+    };
+}
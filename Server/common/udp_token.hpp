@@ -0,0 +1,58 @@
+#pragma once
+#include "hmac.hpp"
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+// 게이트웨이가 발급하고 월드가 상태 없이 검증하는 UDP 입장 토큰
+//   token = <expiry_unix_ms>.<nonce_hex>.<mac_hex>
+//   mac   = HMAC-SHA256(key, actor|world|expiry|nonce) 앞 128비트
+// 두 서버가 같은 키(udp_key=)만 공유하면 되고, 월드 쪽 토큰 테이블/등록 왕복이 필요 없다
+namespace udptoken
+{
+    inline constexpr const char* kDevKey = "cardflip-dev-udp-key"; // world sim 전용 (서버는 udp_key= 없이 뜨지 않는다)
+    inline constexpr size_t kMacBytes = 16;
+
+    enum class Check { Ok, Malformed, BadMac, Expired };
+
+    inline int64_t unix_ms()
+    {
+        return chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    inline string mac(const string& key, const string& actor, int world, const string& expiry, const string& nonce)
+    {
+        auto d = crypto::hmac_sha256(key, actor + '|' + to_string(world) + '|' + expiry + '|' + nonce);
+        return crypto::to_hex(d.data(), kMacBytes);
+    }
+
+    inline string mint(const string& key, const string& actor, int world, int64_t expiry_ms, uint64_t nonce)
+    {
+        char hex[17];
+        auto r = to_chars(hex, hex + sizeof(hex), nonce, 16);
+        string e = to_string(expiry_ms), n(hex, r.ptr);
+        return e + '.' + n + '.' + mac(key, actor, world, e, n);
+    }
+
+    inline Check verify(const string& key, const string& token, const string& actor, int world, int64_t now_ms)
+    {
+        auto p1 = token.find('.');
+        auto p2 = p1 == string::npos ? string::npos : token.find('.', p1 + 1);
+        if (p2 == string::npos || p1 == 0 || p2 == p1 + 1)
+            return Check::Malformed;
+        string e = token.substr(0, p1), n = token.substr(p1 + 1, p2 - p1 - 1);
+        int64_t expiry = 0;
+        auto r = from_chars(e.data(), e.data() + e.size(), expiry);
+        if (r.ec != errc() || r.ptr != e.data() + e.size())
+            return Check::Malformed;
+        // MAC 먼저, 만료는 그 다음 (위조 토큰에 만료 여부를 알려주지 않는다)
+        if (!crypto::equal_ct(token.substr(p2 + 1), mac(key, actor, world, e, n)))
+            return Check::BadMac;
+        if (expiry < now_ms)
+            return Check::Expired;
+        return Check::Ok;
+    }
+}
@@ -0,0 +1,177 @@
+#pragma once
+#include "common.hpp"
+#include "stats.hpp"
+#include <asio.hpp>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+namespace net
+{
+    // 클라이언트 세션 송신 큐 한도 (프로세스 전체 공통, 시작할 때 옵션으로 정한다)
+    //  - soft 를 넘으면 느린 소비자: 합칠 수 있는 알림(heartbeat)은 버린다
+    //  - hard 바이트나 메시지 수를 넘으면 세션을 끊는다
+    struct WriteLimits
+    {
+        size_t soft_bytes = 64 * 1024;
+        size_t hard_bytes = 1024 * 1024;
+        size_t hard_msgs = 8192;
+    };
+
+    inline WriteLimits& write_limits()
+    {
+        static WriteLimits l;
+        return l;
+    }
+
+    // wq_soft= wq_hard= (바이트), wq_msgs=
+    inline void set_write_limits(const unordered_map<string, string>& opts)
+    {
+        auto& l = write_limits();
+        l.soft_bytes = common::opt_size(opts, "wq_soft", l.soft_bytes);
+        l.hard_bytes = common::opt_size(opts, "wq_hard", l.hard_bytes);
+        l.hard_msgs = common::opt_size(opts, "wq_msgs", l.hard_msgs);
+    }
+
+    // 세션 하나의 송신 큐. 세션 스레드(strand/코어) 하나에서만 만진다
+    // writer 가 gather 로 앞부분을 가져가 쓰는 동안(in-flight) 그 항목은 건드리지 않는다
+    class WriteQueue
+    {
+    public:
+        enum class Push
+        {
+            Queued,
+            Dropped,  // 합쳐졌거나 느린 소비자라 버림
+            Overflow, // hard 한도 초과: 호출자가 세션을 끊는다
+        };
+
+        WriteQueue() = default;
+        WriteQueue(const WriteQueue&) = delete;
+        WriteQueue& operator=(const WriteQueue&) = delete;
+        ~WriteQueue() { account(-int64_t(bytes_)); }
+
+        // coalesce: 아직 안 보낸 같은 종류가 있으면 합쳐도 되는 줄 (heartbeat)
+        // limits 가 nullptr 이면 한도 없음 (게이트웨이 링크처럼 끊으면 안 되는 연결)
+        Push push(string bytes, bool coalesce, const WriteLimits* limits)
+        {
+            return push_item(Item{ move(bytes), nullptr, chrono::steady_clock::now(), coalesce }, limits);
+        }
+
+        // 여러 세션이 같이 쓰는 버퍼 (관전 fan-out). 복사하지 않고 참조만 든다
+        Push push_shared(shared_ptr<const string> bytes, const WriteLimits* limits)
+        {
+            return push_item(Item{ string(), move(bytes), chrono::steady_clock::now(), false }, limits);
+        }
+
+        bool empty() const { return q_.size() == inflight_; }
+
+        // 아직 안 보낸 앞부분을 최대 max 개 batch 에 담는다 (pop 전까지 in-flight)
+        size_t gather(vector<asio::const_buffer>& batch, size_t max)
+        {
+            batch.clear();
+            for (size_t i = inflight_; i < q_.size() && batch.size() < max; i++)
+            {
+                batch.push_back(asio::buffer(q_[i].data()));
+                if (q_[i].coalesce)
+                    coalesce_queued_ = false; // 큐에 합칠 수 있는 항목은 하나뿐이다
+            }
+            inflight_ += batch.size();
+            return batch.size();
+        }
+
+        // 다 쓴 in-flight 항목 제거
+        void pop(stats::Histogram& lat)
+        {
+            for (; inflight_ > 0; inflight_--)
+            {
+                lat.record_since(q_.front().queued);
+                bytes_ -= q_.front().data().size();
+                account(-int64_t(q_.front().data().size()));
+                q_.pop_front();
+            }
+        }
+
+        void clear()
+        {
+            account(-int64_t(bytes_));
+            q_.clear();
+            bytes_ = 0;
+            inflight_ = 0;
+            coalesce_queued_ = false;
+            slow_ = false;
+        }
+
+    private:
+        struct Item
+        {
+            string bytes;
+            shared_ptr<const string> shared; // 있으면 bytes 대신
+            chrono::steady_clock::time_point queued;
+            bool coalesce = false;
+
+            const string& data() const { return shared ? *shared : bytes; }
+        };
+
+        Push push_item(Item it, const WriteLimits* limits)
+        {
+            static auto& coalesced = stats::counter("wq.coalesced");
+            static auto& dropped_bytes = stats::counter("wq.dropped_bytes");
+            static auto& slow = stats::counter("wq.slow_consumers");
+            static auto& kicked = stats::counter("wq.kicked");
+            bool coalesce = it.coalesce;
+            size_t n = it.data().size();
+            if (coalesce && coalesce_queued_)
+            {
+                coalesced.add();
+                return Push::Dropped;
+            }
+            if (limits)
+            {
+                if (bytes_ + n > limits->hard_bytes || q_.size() >= limits->hard_msgs)
+                {
+                    kicked.add();
+                    dropped_bytes.add(int64_t(bytes_ + n));
+                    return Push::Overflow;
+                }
+                if (bytes_ > limits->soft_bytes)
+                {
+                    if (!slow_)
+                    {
+                        slow_ = true;
+                        slow.add();
+                    }
+                    if (coalesce)
+                    {
+                        dropped_bytes.add(int64_t(n));
+                        return Push::Dropped;
+                    }
+                }
+                else if (slow_ && bytes_ <= limits->soft_bytes / 2)
+                    slow_ = false;
+            }
+            bytes_ += n;
+            account(int64_t(n));
+            coalesce_queued_ = coalesce_queued_ || coalesce;
+            q_.push_back(move(it));
+            return Push::Queued;
+        }
+
+        // 모든 세션 송신 큐에 쌓인 바이트 합 (mem.send_queued)
+        static void account(int64_t d)
+        {
+            static auto& held = stats::counter("mem.send_queued");
+            held.add(d);
+        }
+
+        deque<Item> q_;
+        size_t bytes_ = 0;    // 큐 전체 (in-flight 포함)
+        size_t inflight_ = 0; // 앞에서부터 writer 가 쓰고 있는 항목 수
+        bool coalesce_queued_ = false;
+        bool slow_ = false;
+    };
+}
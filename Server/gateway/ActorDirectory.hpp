@@ -0,0 +1,169 @@
+#pragma once
+#include "../common/stats.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+class Session;
+
+// 게이트웨이 전체의 actor -> (월드, 세션) 디렉터리. 중복 입장 검사용
+// 샤드마다 불변 맵을 atomic<shared_ptr> 로 들고 있다
+//  - 쓰기(claim/release): 샤드 락 안에서 맵을 복사해 고친 뒤 교체 (copy-on-write), 버전 증가
+//  - 읽기(find): 락 없음. 스레드마다 샤드별 (버전, 맵) 을 캐시해 두고 버전이 같으면 그대로 쓴다
+//    -> 평소에는 atomic load 하나 (shared_ptr 참조 카운트를 건드리지 않아 코어 간 캐시 라인 경합이 없다)
+// 입장/퇴장은 조회보다 훨씬 드물고 샤드 하나는 작게 유지되므로 복사 비용은 작다
+class ActorDirectory
+{
+public:
+    struct Entry
+    {
+        int world = 0;
+        weak_ptr<Session> session;
+        uint64_t epoch = 0; // claim 때 월드의 등록 세대 (WorldDirectory::World::epoch)
+        chrono::steady_clock::time_point since; // claim/rebind 시각
+    };
+
+    ActorDirectory()
+    {
+        for (auto& s : shards_)
+            s.map.store(make_shared<const Map>());
+    }
+    ~ActorDirectory()
+    {
+        // 다른 스레드의 캐시는 그 스레드가 다른 인스턴스를 볼 때 비워진다
+        Tls& t = tls();
+        if (t.owner == id_)
+            t = {};
+    }
+
+    // 비어 있으면 차지하고 true, 이미 누가 있으면 false (check-and-claim 이 한 번에 일어난다)
+    // 있던 항목이 stale 이면 (EXIT_USER 를 못 받고 남은 자리) 새로 차지한다
+    bool claim(const string& actor, int world, weak_ptr<Session> session, uint64_t epoch = 0, const function<bool(const Entry&)>& stale = {})
+    {
+        static auto& lost = stats::counter("dir.claim_conflicts");
+        static auto& reclaimed = stats::counter("dir.stale_reclaimed");
+        Shard& s = shard(actor);
+        lock_guard<mutex> lk(s.m);
+        auto cur = s.map.load(memory_order_acquire);
+        auto it = cur->find(actor);
+        bool replace = it != cur->end();
+        if (replace && !(stale && stale(it->second)))
+        {
+            lost.add();
+            return false;
+        }
+        auto next = make_shared<Map>(*cur);
+        (*next)[actor] = Entry{ world, move(session), epoch, chrono::steady_clock::now() };
+        s.map.store(move(next), memory_order_release);
+        s.version.fetch_add(1, memory_order_release);
+        if (replace)
+            reclaimed.add();
+        else
+            count_.fetch_add(1, memory_order_relaxed);
+        return true;
+    }
+
+    // 같은 world 에 있을 때만 세션을 바꾼다 (프록시 모드: 로그인 연결 대신 클라이언트 컨트롤 연결)
+    bool rebind(const string& actor, int world, weak_ptr<Session> session)
+    {
+        Shard& s = shard(actor);
+        lock_guard<mutex> lk(s.m);
+        auto cur = s.map.load(memory_order_acquire);
+        auto it = cur->find(actor);
+        if (it == cur->end() || it->second.world != world)
+            return false;
+        auto next = make_shared<Map>(*cur);
+        (*next)[actor] = Entry{ world, move(session), it->second.epoch, chrono::steady_clock::now() };
+        s.map.store(move(next), memory_order_release);
+        s.version.fetch_add(1, memory_order_release);
+        return true;
+    }
+
+    // world 가 맞을 때만 지운다 (다른 월드에 다시 들어간 뒤 늦게 온 EXIT_USER 무시). world < 0 이면 무조건
+    bool release(const string& actor, int world = -1)
+    {
+        Shard& s = shard(actor);
+        lock_guard<mutex> lk(s.m);
+        auto cur = s.map.load(memory_order_acquire);
+        auto it = cur->find(actor);
+        if (it == cur->end() || (world >= 0 && it->second.world != world))
+            return false;
+        auto next = make_shared<Map>(*cur);
+        next->erase(actor);
+        s.map.store(move(next), memory_order_release);
+        s.version.fetch_add(1, memory_order_release);
+        count_.fetch_sub(1, memory_order_relaxed);
+        return true;
+    }
+
+    optional<Entry> find(const string& actor) const
+    {
+        size_t i = index(actor);
+        const Shard& s = shards_[i];
+        // 캐시는 디렉터리 인스턴스별 (다른 인스턴스를 보면 비운다)
+        // 주소로 비교하면 해제된 인스턴스 자리에 새로 만든 것이 옛 (버전, 맵) 을 물려받으므로 id 로 본다
+        Tls& t = tls();
+        if (t.owner != id_)
+        {
+            t.cache = {};
+            t.owner = id_;
+        }
+        Cached& c = t.cache[i];
+        uint64_t v = s.version.load(memory_order_acquire);
+        if (!c.map || c.version != v)
+        {
+            // 버전을 먼저 읽었으므로 여기서 읽은 맵은 최소한 v 시점 이후의 것
+            c.map = s.map.load(memory_order_acquire);
+            c.version = v;
+        }
+        auto it = c.map->find(actor);
+        if (it == c.map->end())
+            return nullopt;
+        return it->second;
+    }
+
+    size_t size() const { return size_t(count_.load(memory_order_relaxed)); }
+
+private:
+    using Map = unordered_map<string, Entry>;
+    static constexpr size_t kShards = 256;
+
+    struct alignas(64) Shard
+    {
+        mutex m; // 쓰기끼리만 막는다
+        atomic<shared_ptr<const Map>> map;
+        atomic<uint64_t> version{ 0 };
+    };
+    struct Cached
+    {
+        uint64_t version = 0;
+        shared_ptr<const Map> map;
+    };
+    struct Tls
+    {
+        uint64_t owner = 0; // 캐시를 채운 인스턴스의 id_ (0 은 없음)
+        array<Cached, kShards> cache;
+    };
+
+    static Tls& tls()
+    {
+        thread_local Tls t;
+        return t;
+    }
+
+    static size_t index(const string& actor) { return hash<string>{}(actor) % kShards; }
+    Shard& shard(const string& actor) { return shards_[index(actor)]; }
+
+    static inline atomic<uint64_t> next_id_{ 1 };
+    const uint64_t id_ = next_id_.fetch_add(1, memory_order_relaxed);
+    array<Shard, kShards> shards_;
+    atomic<int64_t> count_{ 0 };
+};
@@ -0,0 +1,124 @@
+#include "DirBench.hpp"
+#include "ActorDirectory.hpp"
+#include "../common/common.hpp"
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+	// 비교 기준: 예전처럼 맵 하나를 락 하나로 보호
+	class GlobalDirectory
+	{
+	public:
+		bool claim(const string& actor, int world, weak_ptr<Session> session)
+		{
+			lock_guard<mutex> lk(m_);
+			return map_.emplace(actor, ActorDirectory::Entry{ world, move(session), 0, chrono::steady_clock::now() }).second;
+		}
+		bool release(const string& actor, int)
+		{
+			lock_guard<mutex> lk(m_);
+			return map_.erase(actor) > 0;
+		}
+		optional<ActorDirectory::Entry> find(const string& actor) const
+		{
+			lock_guard<mutex> lk(m_);
+			auto it = map_.find(actor);
+			if (it == map_.end()) return nullopt;
+			return it->second;
+		}
+
+	private:
+		mutable mutex m_;
+		unordered_map<string, ActorDirectory::Entry> map_;
+	};
+
+	template <class Dir>
+	bool bench(const char* name, int threads, int actors, int rounds, int reads)
+	{
+		Dir dir;
+		vector<string> names;
+		names.reserve(actors);
+		for (int i = 0; i < actors; i++)
+			names.push_back("actor" + to_string(i));
+
+		atomic<int64_t> wins{ 0 }, finds{ 0 }, releases{ 0 };
+		atomic<bool> ok{ true };
+		barrier sync(threads, []() noexcept {});
+
+		auto t0 = chrono::steady_clock::now();
+		vector<thread> ts;
+		for (int t = 0; t < threads; t++)
+		{
+			ts.emplace_back([&, t]
+				{
+					uint64_t x = 0x9e3779b97f4a7c15ull * (t + 1);
+					int64_t my_wins = 0, my_finds = 0, my_rel = 0;
+					vector<int> mine;
+					for (int r = 0; r < rounds; r++)
+					{
+						mine.clear();
+						// 스레드마다 다른 시작점/보폭으로 같은 이름들을 경쟁한다
+						for (int i = 0; i < actors; i++)
+						{
+							int a = int((size_t(i) * (2 * t + 1) + size_t(t) * 7919) % actors);
+							for (int k = 0; k < reads; k++)
+							{
+								x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+								if (dir.find(names[x % actors])) my_finds++;
+							}
+							if (dir.claim(names[a], 1, {}))
+								mine.push_back(a);
+						}
+						my_wins += mine.size();
+						sync.arrive_and_wait();
+						// 모든 actor 가 정확히 한 번씩 차지됐어야 한다
+						if (t == 0 && dir.find(names[actors - 1]) == nullopt)
+							ok = false;
+						sync.arrive_and_wait();
+						for (int a : mine)
+							if (dir.release(names[a], 1)) my_rel++;
+						sync.arrive_and_wait();
+					}
+					wins += my_wins;
+					finds += my_finds;
+					releases += my_rel;
+				});
+		}
+		for (auto& th : ts) th.join();
+		double sec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+		int64_t claims = int64_t(threads) * actors * rounds;
+		int64_t lookups = claims * reads;
+		if (wins != int64_t(actors) * rounds || releases != wins)
+			ok = false;
+		common::log("DIRBENCH", string(name) + " threads=" + to_string(threads) + " actors=" + to_string(actors)
+			+ " rounds=" + to_string(rounds) + " sec=" + to_string(sec)
+			+ " claims/ms=" + to_string(int64_t(claims / sec / 1000))
+			+ " finds/ms=" + to_string(int64_t(lookups / sec / 1000))
+			+ " hits=" + to_string(finds.load())
+			+ " wins=" + to_string(wins.load()) + (ok ? " OK" : " MISMATCH"));
+		return ok;
+	}
+}
+
+DirBench::DirBench(const unordered_map<string, string>& opts)
+	: threads_(max(1, common::opt_int(opts, "threads", 8)))
+	, actors_(max(1, common::opt_int(opts, "actors", 5000)))
+	, rounds_(max(1, common::opt_int(opts, "rounds", 20)))
+	, reads_(max(0, common::opt_int(opts, "reads", 8)))
+{
+}
+
+int DirBench::run()
+{
+	bool ok = bench<ActorDirectory>("sharded", threads_, actors_, rounds_, reads_);
+	ok = bench<GlobalDirectory>("global", threads_, actors_, rounds_, reads_) && ok;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+// ActorDirectory 동시 로그인 부하 측정
+// 스레드마다 같은 actor 집합을 서로 다른 순서로 claim 하고 (actor 하나당 승자는 정확히 1),
+// claim 사이사이 find 로 중복 입장 검사를 흉내낸 뒤 release 한다. 이를 rounds 번 반복
+// 비교용으로 전역 mutex 하나짜리 맵(mode=global)도 같은 부하로 돌린다
+// 사용: gateway_server dirbench threads=8 actors=5000 rounds=20 reads=8
+class DirBench
+{
+public:
+    explicit DirBench(const unordered_map<string, string>& opts);
+
+    int run();
+
+private:
+    int threads_;
+    int actors_;
+    int rounds_;
+    int reads_; // claim 한 번당 find 횟수
+};
@@ -0,0 +1,102 @@
+#include "LinkBench.hpp"
+#include "WorldLinkPool.hpp"
+#include "../common/common.hpp"
+#include "../common/protocol.hpp"
+#include "../common/stats.hpp"
+#include "../common/cpu_time.hpp"
+#include "../common/link_auth.hpp"
+#include <asio.hpp>
+#include <chrono>
+#include <memory>
+
+using namespace std;
+
+LinkBench::LinkBench(const unordered_map<string, string>& opts)
+	: opts_(opts)
+	, seconds_(max(1, common::opt_int(opts, "seconds", 5)))
+	, window_(max(1, common::opt_int(opts, "window", 32)))
+{
+}
+
+int LinkBench::run()
+{
+	// 월드는 udp_key 로 서명된 GW_HELLO 만 링크로 받는다
+	if (opts_["udp_key"].empty())
+	{
+		common::log("LINKBENCH", "udp_key= is required (same value as the world)");
+		return 1;
+	}
+	bool ok = true;
+	if (opts_.count("tcp"))
+	{
+		const string& addr = opts_["tcp"];
+		auto colon = addr.rfind(':');
+		string host = colon == string::npos ? addr : addr.substr(0, colon);
+		int port = colon == string::npos ? 7100 : common::to_int(addr.c_str() + colon + 1, 7100);
+		ok = bench("tcp", host, static_cast<unsigned short>(port)) && ok;
+	}
+	if (opts_.count("shm"))
+		ok = bench("shm", "shm:" + opts_["shm"], 0) && ok;
+	return ok ? 0 : 1;
+}
+
+bool LinkBench::bench(const string& name, const string& host, unsigned short port)
+{
+	asio::io_context io;
+	string gw = "linkbench-" + name;
+	string hello = string(proto::GW_HELLO) + " rpc=1 gw=" + gw + " mac=" + linkauth::mac(opts_["udp_key"], gw) + "\n";
+	auto link = make_shared<WorldLinkPool>(io, host, port, hello, 1, 1000);
+	link->start();
+
+	auto& lat = stats::histogram("bench." + name + "_rtt_us");
+	auto warm_end = chrono::steady_clock::now() + chrono::milliseconds(500);
+	auto end = warm_end + chrono::seconds(seconds_);
+	int64_t calls = 0, errors = 0;
+	int inflight = 0;
+	double cpu0 = 0;
+	bool measuring = false;
+
+	// 응답이 오면 바로 다음 요청 (window 개를 계속 띄워 둔다)
+	function<void()> issue = [&]
+		{
+			inflight++;
+			auto t0 = chrono::steady_clock::now();
+			link->call("PING", chrono::milliseconds(2000), [&, t0](bool, const string& resp)
+				{
+					inflight--;
+					auto now = chrono::steady_clock::now();
+					if (!measuring && now >= warm_end)
+					{
+						measuring = true;
+						cpu0 = stats::process_cpu_s();
+					}
+					if (measuring)
+					{
+						lat.record_since(t0);
+						calls++;
+						if (resp != "PONG")
+							errors++;
+					}
+					if (now < end)
+						issue();
+					else if (inflight == 0)
+						io.stop();
+				});
+		};
+	for (int i = 0; i < window_; i++)
+		issue();
+
+	// 월드가 없으면 영영 안 끝나므로 상한을 둔다
+	asio::steady_timer guard(io, end + chrono::seconds(3));
+	guard.async_wait([&](error_code) { io.stop(); });
+	io.run();
+
+	double cpu = stats::process_cpu_s() - cpu0;
+	double sec = seconds_;
+	common::log("LINKBENCH", name + " window=" + to_string(window_) + " calls=" + to_string(calls)
+		+ " calls/s=" + to_string(int64_t(calls / sec))
+		+ " p50_us=" + to_string(lat.percentile(0.50)) + " p99_us=" + to_string(lat.percentile(0.99))
+		+ " cpu_us/call=" + to_string(calls ? cpu * 1e6 / calls : 0.0)
+		+ " errors=" + to_string(errors));
+	return calls > 0 && errors == 0;
+}
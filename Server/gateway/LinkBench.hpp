@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+// 게이트웨이 <-> 월드 링크 왕복 측정 (루프백 TCP vs 공유 메모리)
+// 실행 중인 월드에 링크 연결 하나를 붙이고 window 개의 PING 요청을 계속 띄워 둔 채로
+// 응답 지연 분포와 초당 왕복, 게이트웨이 쪽 CPU 를 잰다
+// 사용: gateway_server linkbench tcp=127.0.0.1:7100 shm=/tmp/cardflip-7100.sock udp_key=<키> seconds=5 window=32
+//       (월드는 world_server 7100 9001 shm=/tmp/cardflip-7100.sock udp_key=<키>)
+class LinkBench
+{
+public:
+    explicit LinkBench(const unordered_map<string, string>& opts);
+
+    int run();
+
+private:
+    bool bench(const string& name, const string& host, unsigned short port);
+
+    unordered_map<string, string> opts_;
+    int seconds_;
+    int window_;
+};
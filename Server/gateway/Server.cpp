@@ -1,26 +1,94 @@
 #include "Server.hpp"
 #include "Session.hpp" 
-#include "WorldServerLinker.hpp"
+#include "WorldLinkPool.hpp"
+#include "../common/stats.hpp"
+#include "../common/protocol.hpp"
+#include "../common/admission.hpp"
+#include "../common/link_auth.hpp"
 #include <asio.hpp>
 #include <memory>
 
-Server::Server(asio::io_context& io_, unsigned short port)
-	: io(io_), acc(io_, tcp::endpoint(tcp::v4(), port))
+Server::Server(asio::io_context& io_, unsigned short port, const vector<string>& world_addrs, net::IoPool* pool,
+	string udp_key_, int links_per_world, int hb_ms)
+	: io(io_), acc(io_, tcp::endpoint(tcp::v4(), port)), io_pool(pool), stats_timer(io_), accept_pace(io_), udp_key(move(udp_key_))
 {
-	worlds.emplace(1, WorldInfo{ 1, "Test1", "127.0.0.1", 9001,	make_shared<WorldServerLink>(io, "127.0.0.1", 7100) });
+	gw_id = Session::rand_token();
+	int n = io_pool ? io_pool->size() : 1;
+	for (int i = 0; i < n; i++)
+		session_pools.emplace_back("gw_session");
+	for (const auto& addr : world_addrs)
+	{
+		// "shm:<경로>" 는 공유 메모리 링크 (포트 없음)
+		auto colon = addr.rfind("shm:", 0) == 0 ? string::npos : addr.rfind(':');
+		string host = colon == string::npos ? addr : addr.substr(0, colon);
+		int wport = colon == string::npos ? 0 : common::to_int(addr.c_str() + colon + 1, 7100);
+		string hello = string(proto::GW_HELLO) + " rpc=1 gw=" + gw_id + " mac=" + linkauth::mac(udp_key, gw_id) + "\n";
+		auto link = make_shared<WorldLinkPool>(io, host, static_cast<unsigned short>(wport), hello, links_per_world, hb_ms);
+		link->use_io_pool(io_pool, 0);
+		link->use_directories(&actors, &worlds);
+		links.push_back(move(link));
+	}
 	accept();
-	for (auto& [id, w] : worlds) w.link->start();
+	for (auto& link : links) link->start();
+	schedule_stats();
 }
 
 void Server::accept()
 {
-	acc.async_accept([this](error_code ec, tcp::socket s)
+	// 초당 accept 수 제한: 토큰이 없으면 받지 않고 커널 backlog 에 둔다
+	static auto& paced = stats::counter("adm.accept_paced");
+	auto wait = net::admission().accept.wait();
+	if (wait.count() > 0)
+	{
+		paced.add();
+		accept_pace.expires_after(wait);
+		accept_pace.async_wait([this](error_code) { accept(); });
+		return;
+	}
+	net::admission().accept.try_take();
+
+	if (!io_pool)
+	{
+		acc.async_accept([this](error_code ec, tcp::socket s)
+			{
+				// 동시 연결 상한이면 재시도 시각만 알리고 끊는다
+				if (!ec && !net::admission().enter())
+					net::reject_busy(s);
+				else if (!ec)
+				{
+					auto sp = session_pools[0].acquire(
+						[&] { return new Session(move(s), *this); },
+						[&](Session& t) { t.reset(move(s)); });
+					sp->start();
+				}
+				accept();
+			});
+		return;
+	}
+
+	int core = io_pool->pick();
+	acc.async_accept(io_pool->io(core), [this, core](error_code ec, tcp::socket s)
 		{
-			if (!ec)
+			if (!ec && !net::admission().enter())
+				net::reject_busy(s);
+			else if (!ec)
 			{
-				auto sp = make_shared<Session>(move(s), *this); 
+				auto sp = session_pools[core].acquire(
+					[&] { return new Session(move(s), *this, core); },
+					[&](Session& t) { t.reset(move(s)); });
 				sp->start();
 			}
 			accept();
 		});
+}
+
+void Server::schedule_stats()
+{
+	stats_timer.expires_after(chrono::seconds(30));
+	stats_timer.async_wait([this](error_code ec)
+		{
+			if (ec) return;
+			common::log("GATEWAY", "stats " + stats::dump());
+			schedule_stats();
+		});
 }
\ No newline at end of file
@@ -1,6 +1,11 @@
 #pragma once
 #include "../common/common.hpp"
 #include "../common/net.hpp"
+#include "../common/object_pool.hpp"
+#include "../common/io_pool.hpp"
+#include "../common/udp_token.hpp"
+#include "ActorDirectory.hpp"
+#include "WorldDirectory.hpp"
 #include <unordered_map>
 #include <memory>
 #include <random>
@@ -11,16 +16,7 @@ using  asio::ip::tcp;
 using namespace std;
 
 class Session;
-class WorldServerLink;
-
-struct WorldInfo
-{
-	int id;
-	string name;
-	string udp_host;
-	int udp_port;
-	shared_ptr<WorldServerLink> link; 
-};
+class WorldLinkPool;
 
 class Server
 {
@@ -28,11 +24,25 @@ public:
 	asio::io_context& io;
 	tcp::acceptor acc;
 
-	shared_ptr<WorldServerLink> world_; 
-
-	unordered_map<int, WorldInfo> worlds;
-
-	Server(asio::io_context& io_, unsigned short port);
+	vector<shared_ptr<WorldLinkPool>> links; // 월드 제어 주소마다 하나 (등록은 연결 후 월드가 한다)
+	WorldDirectory worlds;
+	ActorDirectory actors; // 입장 중인 actor (모든 세션/링크 스레드가 같이 본다)
+	net::IoPool* io_pool;
+	vector<net::ObjectPool<Session>> session_pools; // 코어별 (공유 모드는 1개)
+	asio::steady_timer stats_timer;
+	asio::steady_timer accept_pace; // accept 토큰이 없을 때 다음 토큰까지 기다린다
+	string udp_key; // 월드와 공유하는 UDP 토큰 서명 키
+	string gw_id;   // 이 게이트웨이 인스턴스 id (월드가 같은 게이트웨이의 연결들을 묶는 데 쓴다)
+	// 프록시 모드: 클라이언트 컨트롤 연결도 게이트웨이가 받아 월드 링크로 다중화한다
+	// (월드는 클라이언트마다 소켓을 들지 않고, 룸/전체 알림을 게이트웨이당 프레임 하나로 보낸다)
+	bool proxy = false;
+	string proxy_host = "127.0.0.1"; // ENTER_OK 의 tcp_host (클라이언트가 다시 붙을 이 게이트웨이 주소)
+
+	// pool 이 있으면 thread-per-core 모드: accept 한 소켓을 코어별 io_context 로 나눠준다
+	// world_addrs: "host:port" 월드 제어 주소 목록, links: 월드당 연결 수, hb_ms: 링크 heartbeat 주기
+	Server(asio::io_context& io_, unsigned short port, const vector<string>& world_addrs, net::IoPool* pool,
+		string udp_key_, int links = 2, int hb_ms = 500);
 
 	void accept();
+	void schedule_stats();
 };
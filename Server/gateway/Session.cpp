@@ -1,20 +1,53 @@
 #include "../common/common.hpp"
 #include "../common/net.hpp"
+#include "../common/handler_alloc.hpp"
+#include "../common/stats.hpp"
+#include "../common/udp_token.hpp"
+#include "../common/protocol.hpp"
+#include "../common/admission.hpp"
 #include "Session.hpp"
 #include "Server.hpp"
-#include "WorldServerLinker.hpp"
+#include "WorldLinkPool.hpp"
 #include <asio.hpp>
 #include <memory>
 
-Session::Session(tcp::socket s, Server& svr)
+Session::Session(tcp::socket s, Server& svr, int core_)
 	: socket(move(s)),
+	buf(net::max_line()),
 	strand_state(asio::make_strand(socket.get_executor())),
-	server(svr)
+	write_signal(strand_state, asio::steady_timer::time_point::max()),
+	server(svr),
+	core(core_)
 {
 }
+
+// 풀에서 재사용: 소켓/상태만 교체하고 버퍼와 큐 용량은 유지
+void Session::reset(tcp::socket s)
+{
+	socket = move(s);
+	buf.clear();
+	uid.clear();
+	login_token.clear();
+	outq_.clear();
+	proxy.reset();
+	closed = false;
+}
 void Session::start()
 {
-	read_line();
+	if (server.io_pool && core >= 0)
+	{
+		server.io_pool->add_load(core, 1);
+		counted = true;
+	}
+	auto self = shared_from_this();
+	// 핸들러가 던지면 co_spawn 이 예외를 넘겨준다. detached 로 버리면 on_close 없이 끝나 연결/슬롯이 샌다
+	auto done = [self](exception_ptr e)
+		{
+			if (e)
+				self->on_close(make_error_code(errc::bad_message));
+		};
+	asio::co_spawn(strand_state, reader(self), done);
+	asio::co_spawn(strand_state, writer(self), done);
 }
 
 string Session::rand_token()
@@ -27,120 +60,240 @@ string Session::rand_token()
 	return t;
 }
 
-void Session::read_line()
+asio::awaitable<void> Session::reader([[maybe_unused]] shared_ptr<Session> self)
 {
-	auto self = shared_from_this();
-	asio::async_read_until(socket, buf, '\n',
-		asio::bind_executor(strand_state, [this, self](error_code ec, size_t)
-			{
-				if (ec)
-				{
-					on_close(ec);
-					common::log("GATEWAY", "client closed");
-					return;
-				}
-				istream is(&buf);
-				string line;
-				getline(is, line);
-				handle_line(line);
-				read_line();
-			}));
+	static auto& too_long = stats::counter("net.input_overflow");
+	error_code ec;
+	for (;;)
+	{
+		string_view line;
+		if (buf.next_line(line))
+		{
+			handle_line(string(line));
+			continue;
+		}
+		if (buf.full())
+		{
+			too_long.add();
+			ec = asio::error::message_size;
+			break;
+		}
+		size_t n = co_await socket.async_read_some(buf.prepare(), asio::redirect_error(asio::use_awaitable, ec));
+		if (ec)
+			break;
+		buf.commit(n);
+	}
+	on_close(ec);
+	common::log("GATEWAY", "client closed");
 }
 
-void Session::send_line(string s)
+asio::awaitable<void> Session::writer([[maybe_unused]] shared_ptr<Session> self)
 {
-	if (s.empty() || s.back() != '\n') 
-		s.push_back('\n');
-	auto msg = make_shared<string>(move(s));
-	auto self = shared_from_this();
-
-	asio::post(strand_state, [this, self, msg]
+	static auto& lat = stats::histogram("lat.gw_write_us");
+	error_code ec;
+	while (!closed)
+	{
+		if (outq_.empty())
 		{
-			outq_.push_back(msg);
-			if (!sending)
-			{
-				sending = true;
-				do_write();
-			}
+			co_await write_signal.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+			continue;
 		}
-	);
+		outq_.gather(batch_, 64);
+		co_await asio::async_write(socket, batch_, asio::redirect_error(asio::use_awaitable, ec));
+		if (ec)
+		{
+			on_close(ec);
+			break;
+		}
+		outq_.pop(lat);
+	}
 }
 
-void Session::do_write()
+void Session::send_line(string s)
 {
+	if (s.empty() || s.back() != '\n') 
+		s.push_back('\n');
 	auto self = shared_from_this();
-	asio::async_write(socket, asio::buffer(*outq_.front()),
-		asio::bind_executor(strand_state, [this, self](error_code ec, size_t)
-			{
-				if (ec)
-				{
-					on_close(ec);
-					return;
-				}
-				outq_.pop_front();
-				if (!outq_.empty())
-				{
-					do_write();
-				}
-				else
-				{
-					sending = false;
-				}
-			}
-		)
+
+	asio::post(strand_state, net::recycled([this, self, s = move(s)]() mutable
+		{
+			if (closed)
+				return;
+			bool coalesce = proto::coalescable(s);
+			auto r = outq_.push(move(s), coalesce, &net::write_limits());
+			if (r == net::WriteQueue::Push::Overflow)
+				on_close(asio::error::no_buffer_space);
+			else if (r == net::WriteQueue::Push::Queued)
+				write_signal.cancel_one();
+		})
 	);
 }
 
 void Session::on_close(error_code ec)
 {
+	if (closed)
+		return;
+	closed = true;
+	net::admission().leave(); // accept 때 enter 한 연결
+	if (counted)
+	{
+		server.io_pool->add_load(core, -1);
+		counted = false;
+	}
 	common::log("GATEWAY", string("client closed: ") + ec.message());
+	if (proxy)
+	{
+		proxy->detach(uid, shared_from_this());
+		proxy.reset();
+	}
 	error_code ignore;
 	socket.shutdown(tcp::socket::shutdown_both, ignore);
 	socket.close(ignore);
+	write_signal.cancel();
+}
+
+void Session::handle_line(const string& raw)
+{
+	string_view line = raw;
+	if (!line.empty() && line.back() == '\r')
+		line.remove_suffix(1);
+	if (line.empty())
+		return;
+	// 프록시 모드로 붙은 뒤에는 REQ_* 만 월드로 (actor 는 HELLO 때 정해지고 바꿀 수 없다)
+	// GW_HELLO 같은 링크 명령을 클라이언트가 월드에 보내지 못하게 나머지는 버린다
+	if (proxy)
+	{
+		static auto& dropped = stats::counter("proxy.dropped_lines");
+		if (line.rfind("REQ_", 0) == 0)
+			proxy->relay(uid, string(line));
+		else
+			dropped.add();
+		return;
+	}
+	if (server.proxy && line.rfind("HELLO", 0) == 0)
+	{
+		attach_proxy(string(line));
+		return;
+	}
+	handle_gateway_line(string(line));
+}
+
+void Session::attach_proxy(const string& line)
+{
+	// 월드의 HELLO 처리와 같이 parse_kv 로 (키 없는 "HELLO" 한 단어도 그냥 BAD_HELLO)
+	auto m = net::parse_kv(line).second;
+	string actor = m["actor"];
+	optional<ActorDirectory::Entry> e;
+	if (!actor.empty())
+		e = server.actors.find(actor);
+	WorldDirectory::World w;
+	if (!e || !server.worlds.find(e->world, w))
+	{
+		send_line(proto::copy_line(proto::build(proto::msg::ERR, "BAD_HELLO")));
+		return;
+	}
+	uid = actor;
+	server.actors.rebind(actor, w.id, weak_from_this());
+	proxy = w.link;
+	proxy->attach(actor, weak_from_this());
+	proxy->relay(actor, line);
+	common::log("GATEWAY", "proxy attach actor=" + actor + " world=" + to_string(w.id));
 }
 
-void Session::handle_line(const string& line)
+void Session::handle_gateway_line(const string& line)
 {
 	if (line.rfind("LOGIN", 0) == 0)
 	{
 		auto m = net::kvparse(line.substr(5));
 		string id = m["id"];
-		string line = "LOGIN_OK token=" + login_token + " worldCount=" + to_string(server.worlds.size());
-		send_line(line);
-		for (const auto& [id, w] : server.worlds)
-		{
-			line.clear();
-			line = "WORLD id=" + to_string(w.id) + " name=" + w.name + " udp_host=" + w.udp_host +
-				" udp_port=" + to_string(w.udp_port);
-			send_line(line);
-		}
-
+		// WORLD 줄들은 월드 목록이 바뀔 때 미리 만들어 둔 것을 그대로 보낸다
+		auto snap = server.worlds.snapshot();
+		send_line(proto::copy_line(proto::build(proto::msg::LOGIN_OK, login_token, snap->login_count)));
+		if (!snap->login_lines.empty())
+			send_line(snap->login_lines);
 	}
 	else if (line.rfind("ENTER_WORLD", 0) == 0)
 	{
-		auto m = net::kvparse(line.substr(12));
-		string udp_token = rand_token();
-		string host = "127.0.0.1";
-		int port = 9001;
+		auto m = net::parse_kv(line).second; // substr(12) 는 인자 없는 "ENTER_WORLD" 에서 던진다
+		static thread_local mt19937_64 rng{ random_device{}() };
+		static auto& shed = stats::counter("adm.login_shed");
 		string actor = m["actor"];
-
-		if (server.worlds.find(stoi(m["world"])) != server.worlds.end())
+		// actor 가 없으면 빈 문자열 actor 를 차지하고 월드에도 ENTER actor= 로 간다
+		if (actor.empty())
+		{
+			send_line(proto::copy_line(proto::build(proto::msg::ERR_WORLD_UNAVAILABLE_ACTOR, actor)));
+			return;
+		}
+		auto& adm = net::admission();
+		// 로그인 폭주: 초당 입장 수를 넘으면 다음 토큰 시각(+지터)에 다시 오라고 한다
+		if (!adm.login.try_take())
 		{
-			if (!server.worlds[stoi(m["world"])].link->check_actor_exist(actor))
+			shed.add();
+			send_line(proto::copy_line(proto::build(proto::msg::ERR_RETRY, adm.retry_after(int(adm.login.wait().count())), "rate")));
+			return;
+		}
+		// world=0 (또는 생략) 이면 가장 한가한 월드에 배치
+		WorldDirectory::World w;
+		if (!server.worlds.pick(common::opt_int(m, "world", 0), w))
+		{
+			send_line(proto::copy_line(proto::build(proto::msg::ERR_WORLD_UNAVAILABLE, m["world"])));
+			return;
+		}
+		// 과부하 월드 (자동 배치면 전부 과부하) 는 진행 중인 게임을 위해 새 입장을 미룬다
+		if (w.load.overload)
+		{
+			shed.add();
+			send_line(proto::copy_line(proto::build(proto::msg::ERR_RETRY_WORLD, adm.retry_after(adm.retry_ms), "overload", w.id)));
+			return;
+		}
+		int world_id = w.id;
+		string udp_token = udptoken::mint(server.udp_key, actor, world_id, udptoken::unix_ms() + 6000, rng());
+		// 검사와 등록이 한 번에 일어나므로 동시에 들어온 같은 actor 는 하나만 통과한다
+		// 남은 자리 정리: 월드가 목록에서 빠졌거나 빠졌다 다시 왔으면(epoch) EXIT_USER 는 오지 않는다
+		// 아직 월드에 세션이 있으면 ENTER 가 ACTOR_EXISTS 로 실패하므로 잘못 풀어도 중복 입장은 되지 않는다
+		// 프록시 모드에서는 이 게이트웨이의 컨트롤 연결이 곧 월드 세션이므로, 끊긴 지 월드 예약 시간(10초)이 지났으면 stale
+		// (직접 연결 모드의 월드 세션은 월드가 EXIT_USER 로 알려 준다. 예약 만료도 포함)
+		auto stale = [this](const ActorDirectory::Entry& e)
 			{
-				string line = "ERR_ID_EXSIT ";
-				send_line(line);
-				return;
-			}
-			server.worlds[stoi(m["world"])].link->registerUdpToken(udp_token, actor, 6000);
+				WorldDirectory::World cur;
+				if (!server.worlds.find(e.world, cur) || cur.epoch != e.epoch)
+					return true;
+				return server.proxy && e.session.expired() && chrono::steady_clock::now() - e.since > chrono::seconds(10);
+			};
+		if (!server.actors.claim(actor, world_id, weak_from_this(), w.epoch, stale))
+		{
+			send_line(proto::copy_line(proto::build(proto::msg::ERR_ID_EXSIT)));
+			return;
 		}
 
-		string line = "ENTER_OK udp_host=" + server.worlds[stoi(m["world"])].udp_host
-			+ " udp_port=" + to_string(server.worlds[stoi(m["world"])].udp_port)
-			+ " udp_token=" + udp_token + " actor=" + actor;
-
-		send_line(line);
-		common::log("GATEWAY", "ENTER actor=" + actor + " udp_token=" + udp_token);
+		// 월드가 actor 자리를 잡아준 뒤에 클라이언트에 ENTER_OK (응답은 링크 스레드에서 온다)
+		// 프록시 모드면 컨트롤 연결은 월드가 아니라 이 게이트웨이로
+		string ok = proto::copy_line(server.proxy
+			? proto::build(proto::msg::ENTER_OK_PROXY, w.udp_host, w.udp_port, server.proxy_host, server.acc.local_endpoint().port(),
+				world_id, udp_token, actor)
+			: proto::build(proto::msg::ENTER_OK, w.udp_host, w.udp_port, w.tcp_port, world_id, udp_token, actor));
+		// gw 가 같으면 월드는 같은 요청의 재전송으로 보고 OK 를 다시 준다
+		w.link->call(string(proto::build(proto::msg::ENTER, actor, server.gw_id)), chrono::milliseconds(2000),
+			[self = shared_from_this(), actor, world_id, ok = move(ok)](bool success, const string& resp)
+			{
+				if (success)
+				{
+					self->send_line(ok);
+					common::log("GATEWAY", "ENTER actor=" + actor);
+					return;
+				}
+				self->server.actors.release(actor, world_id);
+				if (resp.find("ACTOR_EXISTS") != string::npos)
+					self->send_line(proto::copy_line(proto::build(proto::msg::ERR_ID_EXSIT)));
+				else if (resp.find("OVERLOADED") != string::npos)
+				{
+					auto& adm = net::admission();
+					self->send_line(proto::copy_line(proto::build(proto::msg::ERR_RETRY_WORLD, adm.retry_after(adm.retry_ms), "overload", world_id)));
+				}
+				else
+					self->send_line(proto::copy_line(proto::build(proto::msg::ERR_WORLD_UNAVAILABLE_ACTOR, actor)));
+				common::log("GATEWAY", "ENTER failed actor=" + actor + " " + resp);
+			});
 	}
 	else
 	{
@@ -1,11 +1,14 @@
 #pragma once
 #include "../common/common.hpp"
 #include "../common/net.hpp"
+#include "../common/write_queue.hpp"
+#include "../common/recv_buffer.hpp"
 #include <unordered_map>
 #include <memory>
 #include <random>
 #include <string>
 #include <deque>
+#include <chrono>
 #include <asio.hpp>
 
 using  asio::ip::tcp;
@@ -14,32 +17,45 @@ using Exec = asio::any_io_executor;
 
 class Server;
 class WorldServerLink;
+class WorldLinkPool;
 
 class Session : public enable_shared_from_this<Session>
 {
 public:
 	tcp::socket socket;
-	asio::streambuf buf;
+	net::RecvBuffer buf; // 고정 크기 (max_line). 줄바꿈 없이 다 차면 끊는다
 	string uid;
 	string login_token;
 	asio::strand<Exec> strand_state;
-	deque<shared_ptr<string>> outq_;
-	bool sending = false;
+	net::WriteQueue outq_; // 한도를 넘기면 heartbeat 는 버리고, 더 밀리면 연결을 끊는다
+	vector<asio::const_buffer> batch_;
+	asio::steady_timer write_signal; // writer 깨우기 용 (cancel 로 깨운다)
+	bool closed = false;
 	Server& server;
+	int core = -1;       // thread-per-core 모드에서 배정된 코어
+	bool counted = false;
+	shared_ptr<WorldLinkPool> proxy; // 프록시 모드에서 이 컨트롤 연결이 붙은 월드 (uid = actor)
 
-	Session(tcp::socket s, Server& svr);
+	Session(tcp::socket s, Server& svr, int core_ = -1);
+
+	void reset(tcp::socket s);
 
 	void start();
 
 	static string rand_token();
 
-	void read_line();
+	// 연결당 reader/writer 코루틴. 프레임이 self 를 들고 있다
+	asio::awaitable<void> reader(shared_ptr<Session> self);
 
-	void send_line(string s);
+	asio::awaitable<void> writer(shared_ptr<Session> self);
 
-	void do_write();
+	void send_line(string s);
 
 	void on_close(error_code ec);
 
-	void handle_line(const string& line);
+	void handle_line(const string& raw);
+	void handle_gateway_line(const string& line);
+
+	// 프록시 모드 HELLO: 입장한 actor 의 월드에 이 연결을 붙인다
+	void attach_proxy(const string& line);
 };
\ No newline at end of file
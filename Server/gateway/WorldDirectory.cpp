@@ -0,0 +1,130 @@
+#include "WorldDirectory.hpp"
+#include "../common/common.hpp"
+#include "../common/stats.hpp"
+#include <algorithm>
+
+using namespace std;
+
+WorldDirectory::WorldDirectory()
+{
+	snap_.store(make_shared<const Snapshot>());
+}
+
+void WorldDirectory::upsert(int id, string name, string udp_host, int udp_port, int tcp_port, shared_ptr<WorldLinkPool> link)
+{
+	lock_guard<mutex> lk(m_);
+	auto it = find_if(worlds_.begin(), worlds_.end(), [&](const World& w) { return w.id == id; });
+	if (it == worlds_.end())
+	{
+		worlds_.push_back(World{});
+		it = worlds_.end() - 1;
+		it->placed = make_shared<atomic<int>>(0);
+		it->epoch = ++epochs_;
+	}
+	it->id = id;
+	it->name = move(name);
+	it->udp_host = move(udp_host);
+	it->udp_port = udp_port;
+	it->tcp_port = tcp_port;
+	it->link = move(link);
+	sort(worlds_.begin(), worlds_.end(), [](const World& a, const World& b) { return a.id < b.id; });
+	publish();
+	common::log("GATEWAY", "world registered id=" + to_string(id) + " worlds=" + to_string(worlds_.size()));
+}
+
+void WorldDirectory::update_load(int id, const Load& load)
+{
+	lock_guard<mutex> lk(m_);
+	for (auto& w : worlds_)
+	{
+		if (w.id != id)
+			continue;
+		w.load = load;
+		w.placed->store(0, memory_order_relaxed); // 보고된 actors 에 이미 반영됨
+		publish();
+		return;
+	}
+}
+
+void WorldDirectory::remove(int id)
+{
+	lock_guard<mutex> lk(m_);
+	auto it = remove_if(worlds_.begin(), worlds_.end(), [&](const World& w) { return w.id == id; });
+	if (it == worlds_.end())
+		return;
+	worlds_.erase(it, worlds_.end());
+	publish();
+	common::log("GATEWAY", "world removed id=" + to_string(id) + " worlds=" + to_string(worlds_.size()));
+}
+
+int64_t WorldDirectory::score(const World& w)
+{
+	// 인원 기준. tick 이 밀리거나 CPU 가 찬 월드는 사람이 적어도 뒤로 보낸다
+	int64_t s = w.load.actors + w.placed->load(memory_order_relaxed);
+	s += int64_t(w.load.overrun) * 50;
+	if (w.load.cpu >= 90)
+		s += 1000;
+	if (w.load.overload)
+		s += 1000000; // 과부하 아닌 월드가 하나라도 있으면 그쪽으로
+	return s;
+}
+
+bool WorldDirectory::pick(int world, World& out) const
+{
+	static auto& placed = stats::counter("gw.placed_auto");
+	auto snap = snapshot();
+	const World* best = nullptr;
+	for (const auto& w : snap->worlds)
+	{
+		if (world > 0)
+		{
+			if (w.id == world)
+			{
+				best = &w;
+				break;
+			}
+			continue;
+		}
+		if (!best || score(w) < score(*best))
+			best = &w;
+	}
+	if (!best)
+		return false;
+	best->placed->fetch_add(1, memory_order_relaxed);
+	if (world <= 0)
+		placed.add();
+	out = *best;
+	return true;
+}
+
+bool WorldDirectory::find(int world, World& out) const
+{
+	auto snap = snapshot();
+	for (const auto& w : snap->worlds)
+	{
+		if (w.id == world)
+		{
+			out = w;
+			return true;
+		}
+	}
+	return false;
+}
+
+void WorldDirectory::publish()
+{
+	auto s = make_shared<Snapshot>();
+	s->worlds = worlds_;
+	if (worlds_.size() > 1)
+	{
+		s->login_lines += "WORLD id=0 name=Auto udp_host=" + worlds_[0].udp_host + " udp_port=0\n";
+		s->login_count++;
+	}
+	for (const auto& w : worlds_)
+	{
+		s->login_lines += "WORLD id=" + to_string(w.id) + " name=" + w.name + " udp_host=" + w.udp_host +
+			" udp_port=" + to_string(w.udp_port) + " tcp_port=" + to_string(w.tcp_port) + " actors=" + to_string(w.load.actors) + "\n";
+		s->login_count++;
+	}
+	snap_.store(move(s), memory_order_release);
+}
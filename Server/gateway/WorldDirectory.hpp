@@ -0,0 +1,71 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class WorldLinkPool;
+
+// 게이트웨이가 아는 월드 목록 + 부하. 월드가 링크로 WORLD_REGISTER / WORLD_LOAD 를 보내면 갱신된다
+// 읽기(LOGIN, ENTER_WORLD)가 대부분이라 불변 스냅샷을 통째로 교체한다 (ActorDirectory 와 같은 방식)
+// LOGIN 응답의 WORLD 줄들도 스냅샷을 만들 때 미리 만들어 둔다
+class WorldDirectory
+{
+public:
+    struct Load
+    {
+        int actors = 0;
+        int rooms = 0;
+        int overrun = 0; // 직전 보고 구간에서 tick 이 밀린 횟수
+        int cpu = 0;     // 프로세스 CPU 사용률 (%, 코어 수만큼 100 을 넘을 수 있다)
+        int qdepth = 0;  // 월드 state 에 밀려 있던 작업 수
+        int overload = 0; // 월드가 과부하라고 알렸다 (새 입장을 받지 않는다)
+    };
+
+    struct World
+    {
+        int id = 0;
+        string name;
+        string udp_host;
+        int udp_port = 0;
+        int tcp_port = 0;
+        shared_ptr<WorldLinkPool> link;
+        uint64_t epoch = 0; // 목록에 새로 올라올 때마다 바뀐다 (빠졌다 다시 온 월드는 이전 세션이 없을 수 있다)
+        Load load;
+        // 마지막 부하 보고 이후 이 게이트웨이가 배정한 수 (보고 사이 한 월드로 몰리지 않게)
+        shared_ptr<atomic<int>> placed;
+    };
+
+    struct Snapshot
+    {
+        vector<World> worlds; // 등록되어 연결이 살아 있는 월드만
+        string login_lines;   // "WORLD id=.. name=.. udp_host=.. udp_port=..\n" * login_count
+        int login_count = 0;  // 월드가 둘 이상이면 맨 앞에 자동 배치(id=0) 항목이 붙는다
+    };
+
+    WorldDirectory();
+
+    shared_ptr<const Snapshot> snapshot() const { return snap_.load(memory_order_acquire); }
+
+    // 링크 스레드에서 호출
+    void upsert(int id, string name, string udp_host, int udp_port, int tcp_port, shared_ptr<WorldLinkPool> link);
+    void update_load(int id, const Load& load);
+    void remove(int id);
+
+    // world > 0 이면 그 월드 (없으면 false), 0 이면 가장 한가한 월드
+    bool pick(int world, World& out) const;
+    // 배치 없이 조회만 (프록시 모드에서 이미 입장한 actor 의 월드 찾기)
+    bool find(int world, World& out) const;
+
+private:
+    static int64_t score(const World& w);
+    void publish(); // m_ 잡은 상태에서
+
+    mutable mutex m_;
+    vector<World> worlds_; // m_ 보호, 스냅샷 원본
+    uint64_t epochs_ = 0;  // m_ 보호
+    atomic<shared_ptr<const Snapshot>> snap_;
+};
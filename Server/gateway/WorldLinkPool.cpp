@@ -0,0 +1,301 @@
+#include "WorldLinkPool.hpp"
+#include "WorldServerLinker.hpp"
+#include "Session.hpp"
+#include "../common/common.hpp"
+#include "../common/net.hpp"
+#include "../common/handler_alloc.hpp"
+#include "../common/stats.hpp"
+#include "../common/protocol.hpp"
+#include <algorithm>
+
+using namespace std;
+
+WorldLinkPool::WorldLinkPool(asio::io_context& io, string host, unsigned short port, string hello, int links, int hb_ms)
+	: strand_(io.get_executor())
+	, rpc_timer_(io)
+{
+	for (int i = 0; i < max(1, links); i++)
+		links_.push_back(make_shared<WorldServerLink>(io, strand_, host, port, this, i, hello, hb_ms));
+}
+
+void WorldLinkPool::start()
+{
+	for (auto& l : links_)
+		l->start();
+	asio::co_spawn(strand_, expire(shared_from_this()), asio::detached);
+}
+
+template <class F>
+void WorldLinkPool::post_link(F&& f)
+{
+	// 코어별 모드에서는 링크 코어의 mailbox 로, 아니면 링크 strand 로
+	if (pool_)
+		pool_->post(core_, forward<F>(f));
+	else
+		asio::post(strand_, net::recycled(forward<F>(f)));
+}
+
+void WorldLinkPool::call(string payload, chrono::milliseconds timeout, Callback cb)
+{
+	post_link([this, self = shared_from_this(), payload = move(payload), timeout, cb = move(cb)]() mutable
+		{
+			uint32_t id = next_id_++;
+			if (id == 0)
+				id = next_id_++;
+			auto now = chrono::steady_clock::now();
+			auto& p = pending_.emplace(id, Pending{ move(payload), move(cb), now, now + timeout }).first->second;
+			dispatch(id, p);
+		});
+}
+
+WorldServerLink* WorldLinkPool::pick()
+{
+	for (size_t i = 0; i < links_.size(); i++)
+	{
+		auto& l = links_[(rr_ + i) % links_.size()];
+		if (l->healthy())
+		{
+			rr_ = (rr_ + i + 1) % links_.size();
+			return l.get();
+		}
+	}
+	return nullptr;
+}
+
+// 같은 actor 의 줄은 늘 같은 연결로 (월드에서 연결마다 따로 처리되므로 순서가 섞이지 않게)
+WorldServerLink* WorldLinkPool::pick_for(const string& actor)
+{
+	size_t h = hash<string>{}(actor);
+	for (size_t i = 0; i < links_.size(); i++)
+	{
+		auto& l = links_[(h + i) % links_.size()];
+		if (l->healthy())
+			return l.get();
+	}
+	return nullptr;
+}
+
+void WorldLinkPool::attach(const string& actor, weak_ptr<Session> s)
+{
+	post_link([this, self = shared_from_this(), actor, s = move(s)]() mutable
+		{
+			clients_[actor] = move(s);
+		});
+}
+
+void WorldLinkPool::detach(const string& actor, shared_ptr<Session> s)
+{
+	post_link([this, self = shared_from_this(), actor, s = move(s)]
+		{
+			auto it = clients_.find(actor);
+			if (it == clients_.end() || it->second.lock() != s)
+				return;
+			clients_.erase(it);
+			send_client(actor, proto::CLIENT_BYE);
+		});
+}
+
+void WorldLinkPool::relay(const string& actor, string line)
+{
+	post_link([this, self = shared_from_this(), actor, line = move(line)]
+		{
+			send_client(actor, line);
+		});
+}
+
+void WorldLinkPool::send_client(const string& actor, string_view line)
+{
+	static auto& dropped = stats::counter("proxy.dropped");
+	auto* l = pick_for(actor);
+	if (!l)
+	{
+		// 요청과 달리 재전송하지 않는다 (클라이언트 줄은 직접 연결일 때도 끊기면 사라진다)
+		dropped.add();
+		return;
+	}
+	string payload = actor + " ";
+	payload.append(line.data(), line.size());
+	string frame;
+	frame.reserve(rpc::kHeader + payload.size());
+	rpc::append(frame, rpc::Type::Client, 0, payload);
+	l->send(move(frame));
+}
+
+void WorldLinkPool::dispatch(uint32_t id, Pending& p)
+{
+	auto* l = pick();
+	if (!l)
+	{
+		p.link = -1; // 건강한 연결이 생기면 보낸다
+		return;
+	}
+	string frame;
+	frame.reserve(rpc::kHeader + p.payload.size());
+	rpc::append(frame, rpc::Type::Request, id, p.payload);
+	l->send(move(frame));
+	p.link = l->index();
+}
+
+void WorldLinkPool::redispatch(int from)
+{
+	static auto& replayed = stats::counter("link.replayed");
+	// id 순서대로 다시 보낸다 (같은 actor 요청의 순서 유지)
+	vector<uint32_t> ids;
+	for (auto& [id, p] : pending_)
+		if (p.link == from)
+			ids.push_back(id);
+	sort(ids.begin(), ids.end());
+	for (auto id : ids)
+	{
+		auto& p = pending_[id];
+		dispatch(id, p);
+		if (p.link >= 0 && from >= 0)
+			replayed.add();
+	}
+}
+
+void WorldLinkPool::on_link_state(int index)
+{
+	auto& l = links_[index];
+	if (!l->up())
+		redispatch(index); // 끊긴 연결에 실려 있던 요청
+	else if (l->healthy())
+		redispatch(-1);    // 기다리던 요청
+	update_directory();
+}
+
+void WorldLinkPool::update_directory()
+{
+	if (!worlds_ || world_id_ <= 0)
+		return;
+	bool any = any_of(links_.begin(), links_.end(), [](const shared_ptr<WorldServerLink>& l) { return l->healthy(); });
+	if (any == listed_)
+		return;
+	listed_ = any;
+	if (any)
+		worlds_->upsert(world_id_, name_, udp_host_, udp_port_, tcp_port_, shared_from_this());
+	else
+		worlds_->remove(world_id_);
+}
+
+asio::awaitable<void> WorldLinkPool::expire([[maybe_unused]] shared_ptr<WorldLinkPool> self)
+{
+	static auto& timeouts = stats::counter("rpc.timeouts");
+	error_code ec;
+	for (;;)
+	{
+		rpc_timer_.expires_after(chrono::milliseconds(100));
+		co_await rpc_timer_.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+		auto now = chrono::steady_clock::now();
+		for (auto it = pending_.begin(); it != pending_.end(); )
+		{
+			if (it->second.deadline > now)
+			{
+				++it;
+				continue;
+			}
+			auto cb = move(it->second.cb);
+			it = pending_.erase(it);
+			timeouts.add();
+			cb(false, "ERR code=TIMEOUT");
+		}
+	}
+}
+
+void WorldLinkPool::on_frame(const rpc::Frame& f)
+{
+	static auto& lat = stats::histogram("lat.rpc_us");
+	static auto& expanded = stats::counter("proxy.fanout_lines");
+	if (f.type == rpc::Type::Event)
+	{
+		handle_line(string(f.payload));
+		return;
+	}
+	if (f.type == rpc::Type::Client || f.type == rpc::Type::Fanout)
+	{
+		string_view target, line;
+		if (!rpc::split_target(f.payload, target, line))
+			return;
+		string text(line);
+		auto deliver = [&](const weak_ptr<Session>& w)
+			{
+				if (auto s = w.lock())
+				{
+					s->send_line(text);
+					expanded.add();
+				}
+			};
+		if (target == "*")
+		{
+			for (auto& [actor, w] : clients_)
+				deliver(w);
+			return;
+		}
+		// 대상은 actor 하나 또는 "a,b,..."
+		while (!target.empty())
+		{
+			auto comma = target.find(',');
+			auto it = clients_.find(string(target.substr(0, comma)));
+			if (it != clients_.end())
+				deliver(it->second);
+			target = comma == string_view::npos ? string_view{} : target.substr(comma + 1);
+		}
+		return;
+	}
+	if (f.type != rpc::Type::Response)
+		return;
+	auto it = pending_.find(f.id);
+	if (it == pending_.end())
+		return; // 이미 타임아웃 처리됐거나, 재전송한 요청의 두 번째 응답
+	auto cb = move(it->second.cb);
+	lat.record_since(it->second.sent);
+	pending_.erase(it);
+	string resp(f.payload);
+	cb(resp.rfind("OK", 0) == 0, resp);
+}
+
+void WorldLinkPool::handle_line(string line)
+{
+	if (line.empty()) return;
+
+	if (line.rfind("EXIT_USER", 0) == 0)
+	{
+		auto m = net::kvparse(line.substr(5));
+		string id = m["id"];
+		if (actors_) actors_->release(id, world_id_);
+		common::log("WorldServerLinker", "Delete Id = " + id);
+	}
+	else if (line.rfind("WORLD_LOAD", 0) == 0)
+	{
+		auto m = net::kvparse(line.substr(11));
+		WorldDirectory::Load load;
+		load.actors = common::opt_int(m, "actors", 0);
+		load.rooms = common::opt_int(m, "rooms", 0);
+		load.overrun = common::opt_int(m, "overrun", 0);
+		load.cpu = common::opt_int(m, "cpu", 0);
+		load.qdepth = common::opt_int(m, "qdepth", 0);
+		load.overload = common::opt_int(m, "overload", 0);
+		if (worlds_ && listed_)
+			worlds_->update_load(world_id_, load);
+	}
+	else if (line.rfind("WORLD_REGISTER", 0) == 0)
+	{
+		// 연결마다 한 번씩 온다. 처음 것만 반영하고 나머지는 같은 내용
+		auto m = net::kvparse(line.substr(15));
+		int id = common::opt_int(m, "id", 0);
+		if (id <= 0)
+			return;
+		bool changed = id != world_id_;
+		if (changed && listed_ && worlds_)
+		{
+			worlds_->remove(world_id_);
+			listed_ = false;
+		}
+		world_id_ = id;
+		name_ = m["name"];
+		udp_host_ = m["udp_host"];
+		udp_port_ = common::opt_int(m, "udp_port", 0);
+		tcp_port_ = common::opt_int(m, "tcp_port", 0);
+		update_directory();
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <asio.hpp>
+#include "../common/io_pool.hpp"
+#include "../common/rpc.hpp"
+#include "ActorDirectory.hpp"
+#include "WorldDirectory.hpp"
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+class WorldServerLink;
+class Session;
+
+// 월드 하나로 가는 링크 연결 묶음
+//  - 요청은 건강한 연결에 돌아가며 싣고, 응답은 id 로 짝을 맞춘다
+//  - 연결이 끊기면 응답 못 받은 요청을 다른 연결로 (없으면 재접속 후) 다시 보낸다. 기한이 지나면 TIMEOUT
+//  - 건강한 연결이 하나도 없으면 월드 목록에서 빼서 배치 대상에서 제외한다
+// 모든 연결과 풀 상태는 strand 하나(코어별 모드에서는 링크 코어)에서만 만진다
+class WorldLinkPool : public enable_shared_from_this<WorldLinkPool>
+{
+public:
+    using Executor = asio::io_context::executor_type;
+    // 응답 콜백 (링크 스레드에서 불린다). ok 는 응답이 "OK" 로 시작했는지, 타임아웃이면 false
+    using Callback = function<void(bool ok, const string& resp)>;
+
+    // hello: 연결마다 처음 보내는 라인, links: 연결 수, hb_ms: heartbeat 주기
+    WorldLinkPool(asio::io_context& io, string host, unsigned short port, string hello, int links, int hb_ms);
+
+    void start();
+    void use_io_pool(net::IoPool* pool, int core) { pool_ = pool; core_ = core; }
+    // 월드가 WORLD_REGISTER / WORLD_LOAD 를 보내면 worlds 를 갱신, EXIT_USER 면 actors 에서 지운다
+    void use_directories(ActorDirectory* actors, WorldDirectory* worlds) { actors_ = actors; worlds_ = worlds; }
+
+    // 월드에 요청 프레임을 보내고 같은 id 의 응답을 기다린다 (스레드 무관하게 호출 가능)
+    void call(string payload, chrono::milliseconds timeout, Callback cb);
+
+    // 프록시 모드: 클라이언트 컨트롤 연결을 이 월드에 붙이고 그 줄을 Client 프레임으로 넘긴다
+    // 월드가 보낸 Client/Fanout 프레임은 붙어 있는 클라이언트에게 펼쳐 보낸다 (스레드 무관하게 호출 가능)
+    void attach(const string& actor, weak_ptr<Session> s);
+    void detach(const string& actor, shared_ptr<Session> s); // 붙어 있던 세션이면 월드에 CLIENT_BYE
+    void relay(const string& actor, string line);
+
+    // WorldServerLink 가 링크 strand 위에서 부른다
+    void on_link_state(int index);
+    void on_frame(const rpc::Frame& f);
+
+private:
+    struct Pending
+    {
+        string payload;
+        Callback cb;
+        chrono::steady_clock::time_point sent;
+        chrono::steady_clock::time_point deadline;
+        int link = -1; // 실려 있는 연결 (-1: 보낼 연결 대기)
+    };
+
+    // 응답이 안 온 요청을 주기적으로 타임아웃 처리
+    asio::awaitable<void> expire(shared_ptr<WorldLinkPool> self);
+    WorldServerLink* pick();
+    WorldServerLink* pick_for(const string& actor);
+    void send_client(const string& actor, string_view line);
+    void dispatch(uint32_t id, Pending& p);
+    void redispatch(int from);
+    void handle_line(string line);
+    void update_directory();
+    template <class F> void post_link(F&& f);
+
+private:
+    asio::strand<Executor> strand_;
+    asio::steady_timer rpc_timer_;
+    vector<shared_ptr<WorldServerLink>> links_;
+    size_t rr_ = 0;
+    unordered_map<uint32_t, Pending> pending_; // 요청 id -> 응답 대기 (id 0 은 heartbeat 용)
+    unordered_map<string, weak_ptr<Session>> clients_; // 프록시 모드로 붙은 클라이언트 (actor)
+    uint32_t next_id_ = 1;
+    bool listed_ = false; // 월드 목록에 올라가 있는지
+
+    // WORLD_REGISTER 로 알게 된 월드 정보 (0 = 아직 등록 전)
+    int world_id_ = 0;
+    string name_, udp_host_;
+    int udp_port_ = 0, tcp_port_ = 0;
+
+    ActorDirectory* actors_ = nullptr;
+    WorldDirectory* worlds_ = nullptr;
+    net::IoPool* pool_ = nullptr;
+    int core_ = 0;
+};
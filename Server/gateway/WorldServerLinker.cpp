@@ -1,153 +1,260 @@
 #include "WorldServerLinker.hpp"
+#include "WorldLinkPool.hpp"
 #include "../common/common.hpp"
-#include "../common/protocol.hpp"
 #include "../common/net.hpp"
+#include "../common/handler_alloc.hpp"
+#include "../common/stats.hpp"
 
 using namespace std;
 using asio::ip::tcp;
 
-WorldServerLink::WorldServerLink(asio::io_context& io, string host, unsigned short port)
+WorldServerLink::WorldServerLink(asio::io_context& io, asio::strand<Executor> strand, string host, unsigned short port,
+	WorldLinkPool* owner, int index, string hello, int hb_ms)
 	: socket_(io)
 	, resolver_(io)
-	, strand_(io.get_executor())
+	, strand_(move(strand))
 	, reconnect_timer_(io)
 	, hb_timer_(io)
+	, write_signal_(io, asio::steady_timer::time_point::max())
+	, writer_done_(io)
 	, host_(move(host))
 	, port_(port)
+	, owner_(owner)
+	, index_(index)
+	, hello_(move(hello))
+	, hb_ms_(hb_ms)
 {
+#if defined(__linux__)
+	if (host_.rfind("shm:", 0) == 0)
+		shm_path_ = host_.substr(4);
+#endif
 }
 
 void WorldServerLink::start()
 {
-	connect();
+	asio::co_spawn(strand_, run(shared_from_this()), asio::detached);
 }
 
-void WorldServerLink::connect()
+void WorldServerLink::send(string frame)
 {
-	auto self = shared_from_this();
-
-	resolver_.async_resolve(host_, to_string(port_),
-		asio::bind_executor(strand_, [this, self](error_code ec, tcp::resolver::results_type results)
-			{
-				if (ec)
-				{
-					common::log("GATEWAY", "world resolve fail: " + ec.message());
-					schedule_reconnect();
-					return;
-				}
-				asio::async_connect(socket_, results,
-					asio::bind_executor(strand_, [this, self](error_code ec2, const tcp::endpoint&)
-						{
-							if (ec2)
-							{
-								common::log("GATEWAY", "world connect fail: " + ec2.message());
-								schedule_reconnect();
-								return;
-							}
-							backoff_ms_ = 500;
-							common::log("GATEWAY", "world connected");
-							start_read();
-						}
-					));
-			}
-		));
+	outq_.push_back(move(frame));
+	write_signal_.cancel_one();
 }
-void WorldServerLink::start_read()
+
+asio::awaitable<void> WorldServerLink::run(shared_ptr<WorldServerLink> self)
 {
-	auto self = shared_from_this();
-	asio::async_read_until(socket_, asio::dynamic_string_buffer(recv_buf_), '\n',
-		asio::bind_executor(strand_, [this, self](error_code ec, size_t n)
+	error_code ec;
+	for (;;)
+	{
+		co_await connect(ec);
+		if (ec)
+			common::log("GATEWAY", "world connect fail: " + ec.message());
+		else
+		{
+			backoff_ms_ = 100;
+			common::log("GATEWAY", "world connected " + host_ + ":" + to_string(port_) + " #" + to_string(index_));
+			recv_buf_.clear();
+			// 지난 연결의 쓰기가 아직 안 끝났으면 (취소된 쓰기는 IOCP 에서 늦게 끝난다) 버퍼를 치우기 전에 기다린다
+			if (writing_)
 			{
-				if (ec)
-				{
-					on_close(ec);
-					return;
-				}
-				size_t pos = 0;
-				while (true)
-				{
-					auto eol = recv_buf_.find('\n', pos);
-					if (eol == string::npos) break;
-
-					string line = recv_buf_.substr(pos, eol - pos);
-					if (!line.empty() && line.back() == '\r') line.pop_back();
+				writer_done_.expires_at(asio::steady_timer::time_point::max());
+				co_await writer_done_.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+			}
+			outq_.clear();
+			// 첫 줄만 라인, 이후 프레임
+			outq_.push_back(hello_);
+			ping_sent_ = {};
+			up_ = true;
+			unsigned gen = ++gen_;
+			asio::co_spawn(strand_, writer(self, gen), asio::detached);
+			asio::co_spawn(strand_, heartbeat(self, gen), asio::detached);
+			set_healthy(true);
+			co_await reader();
+		}
+		close();
 
-					handle_line(move(line));
-					pos = eol + 1;
-				}
-				recv_buf_.erase(0, pos);
-				start_read();
-			}));
+		// 죽은 월드는 heartbeat 로 빨리 빠지므로 재접속은 짧게 (최대 2초)
+		reconnect_timer_.expires_after(chrono::milliseconds(backoff_ms_));
+		co_await reconnect_timer_.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+		backoff_ms_ = min(backoff_ms_ * 2, 2000);
+	}
 }
-void WorldServerLink::handle_line(string line)
-{
-	if (line.empty()) return;
 
-	if (line.rfind("EXIT_USER", 0) == 0)
+asio::awaitable<void> WorldServerLink::connect(error_code& ec)
+{
+#if defined(__linux__)
+	if (!shm_path_.empty())
 	{
-		auto m = net::kvparse(line.substr(5));
-		string id = m["id"];
-		enter_actors_.erase(id);
-		common::log("WorldServerLinker", "Delete Id = " + id);
+		// 유닉스 소켓으로 붙어서 월드가 만든 링(memfd)과 eventfd 를 받는다
+		asio::local::stream_protocol::socket s(strand_);
+		co_await s.async_connect(asio::local::stream_protocol::endpoint(shm_path_), asio::redirect_error(asio::use_awaitable, ec));
+		if (ec)
+			co_return;
+		co_await s.async_wait(asio::socket_base::wait_read, asio::redirect_error(asio::use_awaitable, ec));
+		int fds[3];
+		uint32_t cap = 0;
+		if (ec || !shm::recv_fds(s.native_handle(), fds, cap))
+		{
+			if (!ec)
+				ec = asio::error::connection_refused;
+			co_return;
+		}
+		chan_ = make_shared<shm::Channel>(strand_, fds, cap, 0, move(s));
+		chan_->start(chan_);
+		co_return;
 	}
+#endif
+	auto results = co_await resolver_.async_resolve(host_, to_string(port_), asio::redirect_error(asio::use_awaitable, ec));
+	if (ec)
+		co_return;
+	co_await asio::async_connect(socket_, results, asio::redirect_error(asio::use_awaitable, ec));
+	if (!ec)
+		socket_.set_option(tcp::no_delay(true), ec);
 }
-void WorldServerLink::schedule_reconnect()
+
+asio::awaitable<void> WorldServerLink::reader()
 {
-	backoff_ms_ = min(backoff_ms_ * 2, 5000);
-	reconnect_timer_.expires_after(chrono::milliseconds(backoff_ms_));
-	reconnect_timer_.async_wait(asio::bind_executor(strand_, [this](error_code)
+	static auto& rtt = stats::histogram("lat.link_rtt_us");
+	error_code ec;
+	for (;;)
+	{
+		size_t n = 0;
+#if defined(__linux__)
+		if (auto ch = chan_)
+			n = co_await ch->read(recv_buf_.prepare(), ec);
+		else
+#endif
+		n = co_await socket_.async_read_some(recv_buf_.prepare(), asio::redirect_error(asio::use_awaitable, ec));
+		if (ec)
+		{
+			common::log("GATEWAY", "world link closed: " + ec.message());
+			co_return;
+		}
+		recv_buf_.commit(n);
+		size_t pos = 0;
+		rpc::Frame f;
+		long used;
+		while ((used = rpc::parse(recv_buf_.data() + pos, recv_buf_.size() - pos, f)) > 0)
 		{
-			asio::error_code ignore;
-			socket_.close(ignore);
-			connect();
-		}));
+			pos += size_t(used);
+			// id 0 은 이 연결의 heartbeat
+			if (f.type == rpc::Type::Response && f.id == 0)
+			{
+				if (ping_sent_ != chrono::steady_clock::time_point{})
+				{
+					rtt_us_ = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - ping_sent_).count();
+					rtt.record(rtt_us_);
+					ping_sent_ = {};
+				}
+				set_healthy(true);
+				continue;
+			}
+			owner_->on_frame(f);
+		}
+		if (used < 0)
+		{
+			common::log("GATEWAY", "world link: bad frame");
+			co_return;
+		}
+		recv_buf_.consume(pos);
+	}
 }
 
-
-void WorldServerLink::registerUdpToken(const string& token, string actor, int ttl_ms)
+asio::awaitable<void> WorldServerLink::writer([[maybe_unused]] shared_ptr<WorldServerLink> self, unsigned gen)
 {
-	string line = proto::CreateUdpToken(token, actor, ttl_ms);
-	enter_actors_.insert(actor);
-	auto self = shared_from_this();
-	asio::post(strand_, [this, self, line = move(line)]
+	error_code ec;
+	while (gen == gen_)
+	{
+		if (outq_.empty())
 		{
-			outq_.push_back(line);
-			if (!sending_)
-			{
-				sending_ = true;
-				do_write();
-			}
-		});
+			co_await write_signal_.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+			continue;
+		}
+		// 쌓인 요청을 한 번에 (batching)
+		batch_.clear();
+		for (size_t i = 0; i < outq_.size() && i < 64; i++)
+			batch_.push_back(asio::buffer(outq_[i]));
+		size_t n = batch_.size();
+		writing_ = true;
+#if defined(__linux__)
+		if (auto ch = chan_)
+			co_await ch->write(batch_, ec);
+		else
+#endif
+		co_await asio::async_write(socket_, batch_, asio::redirect_error(asio::use_awaitable, ec));
+		writing_ = false;
+		if (gen != gen_)
+		{
+			writer_done_.cancel();
+			co_return;
+		}
+		if (ec)
+		{
+			// 소켓을 닫으면 reader 가 빠지고 run 이 재접속한다
+			close();
+			co_return;
+		}
+		outq_.erase(outq_.begin(), outq_.begin() + n);
+	}
 }
 
-void WorldServerLink::do_write()
+asio::awaitable<void> WorldServerLink::heartbeat([[maybe_unused]] shared_ptr<WorldServerLink> self, unsigned gen)
 {
-	auto self = shared_from_this();
-	asio::async_write(socket_, asio::buffer(outq_.front()),
-		asio::bind_executor(strand_, [this, self](error_code ec, size_t)
-			{
-				if (ec)
-				{
-					on_close(ec);
-					return;
-				}
-				outq_.pop_front();
-				if (!outq_.empty())
-					do_write();
-				else
-					sending_ = false;
-			}));
+	static auto& dead = stats::counter("link.hb_dead");
+	error_code ec;
+	while (gen == gen_)
+	{
+		hb_timer_.expires_after(chrono::milliseconds(hb_ms_));
+		co_await hb_timer_.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+		if (gen != gen_)
+			co_return;
+		auto now = chrono::steady_clock::now();
+		if (ping_sent_ == chrono::steady_clock::time_point{})
+		{
+			string frame;
+			rpc::append(frame, rpc::Type::Request, 0, "PING");
+			send(move(frame));
+			ping_sent_ = now;
+			continue;
+		}
+		// 한 주기 안에 PONG 이 없으면 배치에서 빼고, 세 주기면 끊고 재접속
+		auto waited = now - ping_sent_;
+		if (waited >= chrono::milliseconds(hb_ms_))
+			set_healthy(false);
+		if (waited >= chrono::milliseconds(hb_ms_ * 3))
+		{
+			dead.add();
+			common::log("GATEWAY", "world link heartbeat timeout #" + to_string(index_));
+			close();
+			co_return;
+		}
+	}
 }
 
-bool WorldServerLink::check_actor_exist(const string& actor)
+void WorldServerLink::set_healthy(bool h)
 {
-	return !(enter_actors_.find(actor) != enter_actors_.end());
+	if (healthy_ == h)
+		return;
+	healthy_ = h;
+	owner_->on_link_state(index_);
 }
 
-void WorldServerLink::on_close(error_code ec)
+void WorldServerLink::close()
 {
-	common::log("GATEWAY", "world link closed: " + ec.message());
 	asio::error_code ignore;
 	socket_.close(ignore);
-	schedule_reconnect();
+#if defined(__linux__)
+	if (chan_)
+		chan_->close();
+#endif
+	gen_++;
+	// outq_ 는 여기서 비우지 않는다: writer 가 아직 batch_ 로 쓰는 중일 수 있다 (다음 연결을 열 때 run 이 비운다)
+	write_signal_.cancel();
+	hb_timer_.cancel();
+	bool was_up = up_;
+	up_ = false;
+	healthy_ = false;
+	// 이 연결에 걸려 있던 요청은 풀이 다른 연결(또는 재접속 후)로 다시 보낸다
+	if (was_up)
+		owner_->on_link_state(index_);
 }
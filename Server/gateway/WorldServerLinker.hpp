@@ -1,28 +1,45 @@
 #pragma once
 #include <asio.hpp>
+#include "../common/rpc.hpp"
+#include "../common/shm_channel.hpp"
+#include "../common/recv_buffer.hpp"
+#include <chrono>
 #include <deque>
 #include <memory>
 #include <string>
-#include <unordered_set>
+#include <vector>
 using namespace std;
 
+class WorldLinkPool;
+
+// 월드 제어 포트로 가는 연결 하나. 요청/응답 짝 맞추기와 재전송은 WorldLinkPool 이 하고,
+// 여기서는 연결 유지(재접속), 프레임 송수신, heartbeat(PING/PONG, RTT) 만 한다
+// host 가 "shm:<경로>" 면 같은 호스트 월드와 TCP 대신 공유 메모리 링으로 붙는다 (리눅스)
 class WorldServerLink : public enable_shared_from_this<WorldServerLink>
 {
 public:
     using Executor = asio::io_context::executor_type;
-    WorldServerLink(asio::io_context& io, string host, unsigned short port);
+    WorldServerLink(asio::io_context& io, asio::strand<Executor> strand, string host, unsigned short port,
+        WorldLinkPool* owner, int index, string hello, int hb_ms);
 
     void start();
-    void registerUdpToken(const string& token, string actor, int ttl_ms);
-    bool check_actor_exist(const string& actor);
+    // 링크 strand 위에서만 호출
+    void send(string frame);
+    bool up() const { return up_; }           // 연결되어 hello 를 보냈다
+    bool healthy() const { return healthy_; } // 연결됨 + heartbeat 응답이 밀리지 않음
+    int64_t rtt_us() const { return rtt_us_; }
+    int index() const { return index_; }
 
 private:
-    void connect();
-    void schedule_reconnect();
-    void do_write();
-    void on_close(asio::error_code ec);
-    void start_read();
-    void handle_line(string line);
+    // 연결 수명 전체를 도는 코루틴: resolve -> connect -> (writer/heartbeat 기동) -> 읽기 루프 -> backoff 후 재접속
+    asio::awaitable<void> run(shared_ptr<WorldServerLink> self);
+    asio::awaitable<void> connect(error_code& ec);
+    asio::awaitable<void> reader();
+    // gen 이 바뀌면(재접속) 이전 연결의 writer/heartbeat 는 빠진다
+    asio::awaitable<void> writer(shared_ptr<WorldServerLink> self, unsigned gen);
+    asio::awaitable<void> heartbeat(shared_ptr<WorldServerLink> self, unsigned gen);
+    void close();
+    void set_healthy(bool h);
 
 private:
     asio::ip::tcp::socket socket_;
@@ -30,11 +47,26 @@ private:
     asio::strand<Executor> strand_;
     asio::steady_timer reconnect_timer_;
     asio::steady_timer hb_timer_;
+    asio::steady_timer write_signal_;
+    asio::steady_timer writer_done_; // 끊긴 연결의 writer 가 쓰기를 마치면 깨운다
     string host_;
     unsigned short port_;
-    deque<string> outq_;
-    bool sending_ = false;
-    int backoff_ms_ = 500;
-    unordered_set<string> enter_actors_;
-    string recv_buf_;
+    WorldLinkPool* owner_;
+    int index_;
+    string hello_; // 접속 직후 보내는 라인 ("GW_HELLO rpc=1 gw=..")
+    int hb_ms_;
+    deque<string> outq_; // 현재 연결에 보낼 프레임. 끊기면 버리고 풀이 미응답 요청을 다시 보낸다
+    vector<asio::const_buffer> batch_;
+    bool writing_ = false; // batch_ 가 outq_ 를 가리키는 쓰기가 진행 중 (끝날 때까지 outq_ 를 비우지 않는다)
+    unsigned gen_ = 0;
+    int backoff_ms_ = 100;
+    bool up_ = false;
+    bool healthy_ = false;
+    chrono::steady_clock::time_point ping_sent_{}; // 응답 대기 중인 PING (없으면 기본값)
+    int64_t rtt_us_ = 0;
+    net::RecvBuffer recv_buf_{ rpc::kMaxBuffered };
+#if defined(__linux__)
+    string shm_path_;
+    shared_ptr<shm::Channel> chan_; // shm 모드 현재 연결 (다음 연결 때 교체)
+#endif
 };
@@ -1,12 +1,19 @@
 ﻿#include "../common/common.hpp"
 #include "../common/net.hpp"
+#include "../common/udp_token.hpp"
+#include "../common/write_queue.hpp"
+#include "../common/recv_buffer.hpp"
+#include "../common/admission.hpp"
 #include "Server.hpp"
 #include "Session.hpp"
+#include "DirBench.hpp"
+#include "LinkBench.hpp"
 #include <unordered_map>
 #include <memory>
 #include <random>
 #include <string>
 #include <deque>
+#include <sstream>
 
 using  asio::ip::tcp;
 using namespace std;
@@ -17,12 +24,52 @@ using Exec = asio::any_io_executor;
 int main(int argc, char* argv[])
 {
 	common::title("GATEWAY");
+	if (argc > 1 && string(argv[1]) == "dirbench")
+		return DirBench(common::options(argc, argv, 2)).run();
+	if (argc > 1 && string(argv[1]) == "linkbench")
+		return LinkBench(common::options(argc, argv, 2)).run();
 	int port = common::to_int(argc > 1 ? argv[1] : nullptr, 7000);
 
-	asio::io_context io;
-	Server s(io, static_cast<unsigned short>(port));
+	auto opts = common::options(argc, argv, 1);
+	int n = common::opt_int(opts, "threads", max(1u, thread::hardware_concurrency()));
+	// UDP 토큰 서명 키는 월드와 같은 값을 명시해야 한다 (소스에 있는 개발용 키로는 누구나 토큰을 만들 수 있다)
+	if (opts["udp_key"].empty())
+	{
+		common::log("GATEWAY", "udp_key= is required (same value as the worlds)");
+		return 1;
+	}
+	string udp_key = opts["udp_key"];
+	// worlds=127.0.0.1:7100,127.0.0.1:7101 (월드 제어 주소, 월드 정보는 연결 후 월드가 등록한다)
+	vector<string> world_addrs;
+	{
+		stringstream ss(opts.count("worlds") ? opts["worlds"] : "127.0.0.1:7100");
+		string addr;
+		while (getline(ss, addr, ','))
+			if (!addr.empty()) world_addrs.push_back(addr);
+	}
+	net::set_write_limits(opts); // 클라이언트 송신 큐 한도 (wq_soft/wq_hard/wq_msgs)
+	net::set_recv_limits(opts);  // 클라이언트 수신 버퍼 = 한 줄 최대 길이 (max_line)
+	net::set_admission(opts, 2000, 500); // max_conns, accept_rate/burst, login_rate/burst, retry_ms
+	int links = common::opt_int(opts, "links", 2);   // 월드당 링크 연결 수
+	int hb_ms = common::opt_int(opts, "hb_ms", 500); // 링크 heartbeat 주기
+	bool proxy = common::opt_int(opts, "proxy", 0) != 0; // proxy=1 이면 클라이언트 컨트롤 연결을 게이트웨이가 받는다
+	string proxy_host = opts.count("public_host") ? opts["public_host"] : "127.0.0.1";
+	if (opts["io"] == "percore")
+	{
+		// 코어당 io_context: 코어 0 이 accept/월드 링크, 세션은 accept 시 코어에 배정
+		net::IoPool pool(n, common::opt_int(opts, "pin", 0) != 0, opts["place"] == "least");
+		Server s(pool.io(0), static_cast<unsigned short>(port), world_addrs, &pool, udp_key, links, hb_ms);
+		s.proxy = proxy;
+		s.proxy_host = proxy_host;
+		common::log("GATEWAY", "io=percore cores=" + to_string(pool.size()));
+		pool.run();
+		return 0;
+	}
 
-	int n = max(1u, thread::hardware_concurrency());
+	asio::io_context io;
+	Server s(io, static_cast<unsigned short>(port), world_addrs, nullptr, udp_key, links, hb_ms);
+	s.proxy = proxy;
+	s.proxy_host = proxy_host;
 	net::run_io_threads(io, n);
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include "ActorStore.hpp"
+#include <cstring>
+
+using namespace std;
+
+uint32_t ActorStore::add(const string& name)
+{
+    auto it = index_.find(name);
+    if (it != index_.end())
+        return it->second;
+
+    uint32_t s;
+    if (!free_.empty())
+    {
+        s = free_.back();
+        free_.pop_back();
+        gen_[s]++; // 빈 slot 일 때 찍힌 스냅샷과도 구분
+    }
+    else
+    {
+        s = uint32_t(x_.size());
+        x_.push_back(0.f);
+        y_.push_back(0.f);
+        seq_.push_back(0);
+        gen_.push_back(1);
+        ver_.push_back(0);
+        live_.push_back(0);
+        names_.emplace_back();
+    }
+    x_[s] = y_[s] = 0.f;
+    seq_[s] = 0;
+    ver_[s]++;
+    epoch_++;
+    live_[s] = 1;
+    names_[s] = name;
+    index_.emplace(name, s);
+    return s;
+}
+
+void ActorStore::remove(uint32_t s)
+{
+    if (s >= live_.size() || !live_[s])
+        return;
+    index_.erase(names_[s]);
+    live_[s] = 0;
+    gen_[s]++;
+    epoch_++;
+    names_[s].clear();
+    free_.push_back(s);
+}
+
+bool ActorStore::find(const string& name, uint32_t& slot) const
+{
+    auto it = index_.find(name);
+    if (it == index_.end())
+        return false;
+    slot = it->second;
+    return true;
+}
+
+void ActorStore::snapshot(ActorSnapshot& out) const
+{
+    size_t n = x_.size();
+    out.slots = n;
+    out.x.resize(n);
+    out.y.resize(n);
+    out.live.resize(n);
+    out.gen.resize(n, 0);
+    out.ver.resize(n);
+    out.names.resize(n);
+    out.epoch = epoch_;
+
+    // 이름은 slot 주인이 바뀐 곳만 (다시 쓰는 버퍼면 대부분 건너뛴다)
+    for (size_t s = 0; s < n; s++)
+        if (out.gen[s] != gen_[s])
+            out.names[s] = names_[s];
+
+    if (n)
+    {
+        memcpy(out.x.data(), x_.data(), n * sizeof(float));
+        memcpy(out.y.data(), y_.data(), n * sizeof(float));
+        memcpy(out.live.data(), live_.data(), n);
+        memcpy(out.gen.data(), gen_.data(), n * sizeof(uint32_t));
+        memcpy(out.ver.data(), ver_.data(), n * sizeof(uint32_t));
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// 한 tick 의 actor 위치. slot 으로 인덱스하는 배열 묶음 (빈 slot 포함)
+// x/y 는 연속된 float 배열이라 SnapshotKernels 가 SIMD 로 훑는다
+struct ActorSnapshot
+{
+    size_t slots = 0;
+    vector<float> x, y;
+    vector<uint8_t> live;   // 1 = 이 slot 에 actor 가 있다
+    vector<uint32_t> gen;   // slot 세대 (actor 가 들어오고 나갈 때마다 오른다)
+    vector<uint32_t> ver;   // 위치 버전 (움직일 때마다 오른다. 인코딩 캐시를 이걸로 무효화)
+    uint64_t epoch = 0;     // 저장소 전체 변경 번호 (같으면 아무도 안 움직였고 아무도 안 들어오고 안 나갔다)
+    vector<string> names;   // 같은 버퍼를 다시 채울 때는 gen 이 바뀐 slot 만 복사한다
+};
+
+// UDP 로 붙은 actor 의 위치/시퀀스. 이름 -> slot 은 입장/퇴장 때만 찾고
+// 위치는 slot 인덱스 배열 (배열 구조체) 에 둔다. state strand 에서만 쓴다
+class ActorStore
+{
+public:
+    // 이미 있으면 그 slot
+    uint32_t add(const string& name);
+    void remove(uint32_t slot);
+    bool find(const string& name, uint32_t& slot) const;
+
+    float x(uint32_t s) const { return x_[s]; }
+    float y(uint32_t s) const { return y_[s]; }
+    // 위치를 바꾸고 dirty 표시 (버전과 epoch 를 올린다)
+    void move(uint32_t s, float x, float y)
+    {
+        x_[s] = x;
+        y_[s] = y;
+        ver_[s]++;
+        epoch_++;
+    }
+    uint32_t& seq(uint32_t s) { return seq_[s]; }
+    const string& name(uint32_t s) const { return names_[s]; }
+
+    size_t slots() const { return x_.size(); }
+    size_t size() const { return index_.size(); }
+
+    void snapshot(ActorSnapshot& out) const;
+
+private:
+    unordered_map<string, uint32_t> index_;
+    vector<float> x_, y_;
+    vector<uint32_t> seq_;
+    vector<uint32_t> gen_;
+    vector<uint32_t> ver_;
+    uint64_t epoch_ = 0;
+    vector<uint8_t> live_;
+    vector<string> names_;
+    vector<uint32_t> free_;
+};
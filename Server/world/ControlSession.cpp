@@ -0,0 +1,333 @@
+#include "ControlSession.hpp"
+#include "world.hpp"
+#include "../common/net.hpp"
+#include "../common/protocol.hpp"
+#include "../common/common.hpp"
+#include "../common/handler_alloc.hpp"
+#include "../common/stats.hpp"
+#include <asio.hpp>
+
+using namespace std;
+
+ControlSession::ControlSession(World& w)
+	: world(w)
+{
+}
+
+void ControlSession::handle(const string& line)
+{
+	auto [cmd, kv] = net::parse_kv(line);
+	if (cmd == "HELLO")
+	{
+		auto it = kv.find("actor");
+		if (it == kv.end() || it->second.empty())
+		{
+			write_line("ERR code=BAD_HELLO");
+			return;
+		}
+		actorId_ = it->second;
+		world.post_state([self = shared_from_this(), this]
+			{
+				world.bind_session(actorId_, self);
+				write_line("HELLO_OK actor=" + actorId_);
+			});
+		return;
+	}
+
+	// 게이트웨이 링크가 붙을 때 한 번 보낸다 (EXIT_USER 를 돌려줄 세션 지정)
+	// 서명이 맞지 않으면 보통 클라이언트 연결로 남는다 (링크 면제 없음)
+	if (cmd == proto::GW_HELLO)
+	{
+		if (gateway_ || !world.verify_gateway(kv["gw"], kv["mac"]))
+		{
+			static auto& bad = stats::counter("net.gw_hello_bad");
+			bad.add();
+			write_line("ERR code=BAD_GW_HELLO");
+			return;
+		}
+		gateway_ = true;
+		rpc_ = kv["rpc"] == "1";
+		gw_ = kv["gw"];
+		if (!rpc_)
+			write_line("OK");
+		auto self = shared_from_this();
+		world.bind_gateway_session(self, gw_);
+		return;
+	}
+
+	if (cmd == "REQ_STATS")
+	{
+		write_line("RES_STATS " + stats::dump());
+		return;
+	}
+
+	// 로비 구독 켜고 끄기 (룸에 들어가면 끄고, 나오면 REQ_ROOM_LIST subscribe=1 로 다시 받는다)
+	if (cmd == "REQ_LOBBY_SUBSCRIBE")
+	{
+		bool on = kv["on"] != "0";
+		world.post_state([this, self = shared_from_this(), on]
+			{
+				world.lobby_subscribe(actorId_, on);
+				write_line(proto::copy_line(proto::build(proto::msg::RES_LOBBY_SUBSCRIBE, on ? 1 : 0)));
+			});
+		return;
+	}
+
+	// 룸 목록 한 페이지. subscribe=1 이면 목록을 만든 시점부터 로비 변화를 받는다 (빠지거나 겹치는 변화 없음)
+	if (cmd == "REQ_ROOM_LIST")
+	{
+		int phase = common::opt_int(kv, "phase", -1);
+		int free = min(2, max(0, common::opt_int(kv, "free", 0)));
+		int page = max(0, common::opt_int(kv, "page", 0));
+		int size = min(50, max(1, common::opt_int(kv, "size", 20)));
+		bool subscribe = kv["subscribe"] == "1";
+		world.post_state([this, self = shared_from_this(), phase, free, page, size, subscribe]
+			{
+				if (subscribe)
+					world.lobby_subscribe(actorId_, true);
+				write_line(world.room_list(phase, free, page, size));
+			});
+		return;
+	}
+
+	// 관전 (phase 와 상관없이). 다른 룸을 보던 중이면 그 룸은 그만 본다
+	if (cmd == "REQ_WATCH_ROOM")
+	{
+		string roomId = kv["roomId"];
+		world.post_state([this, self = shared_from_this(), roomId = move(roomId)]
+			{
+				if (!watchRoom_.empty() && watchRoom_ != roomId)
+					world.unwatch_room(watchRoom_, actorId_);
+				string reply;
+				watchRoom_ = world.watch_room(roomId, actorId_, reply) ? roomId : "";
+				write_line(move(reply));
+			});
+		return;
+	}
+	if (cmd == "REQ_UNWATCH_ROOM")
+	{
+		world.post_state([this, self = shared_from_this()]
+			{
+				world.unwatch_room(watchRoom_, actorId_);
+				write_line(proto::copy_line(proto::build(proto::msg::RES_UNWATCH_ROOM, watchRoom_)));
+				watchRoom_ = "";
+			});
+		return;
+	}
+
+	if (cmd == "REQ_CREATE_ROOM")
+	{
+		string title = kv["title"];
+		int rows = 0, cols = 0;
+		if (!net::kv_int(kv, "rows", rows) || !net::kv_int(kv, "cols", cols))
+		{
+			write_line("ERR code=BAD_ARGS");
+			return;
+		}
+		string actor = actorId_;
+
+		world.post_state([this, self = shared_from_this(), title = move(title), rows, cols]()
+			{
+				stop_watching();
+				auto roomId = world.create_room(actorId_, title, rows, cols);
+				write_line("RES_CREATE_ROOM roomId=" + roomId + " master=" + actorId_ + " title=" + title);
+				world.broadcast_create_room(roomId);
+				roomId_ = roomId;
+			});
+		return;
+	}
+
+	if (cmd == "REQ_ENTER_ROOM")
+	{
+		string roomId = kv["roomId"];
+		roomId_ = roomId;
+		world.post_state([this, self = shared_from_this(), roomId = move(roomId)]()
+			{
+				if (!world.join_room(roomId, actorId_))
+				{
+					write_line(proto::copy_line(proto::build(proto::msg::ERR_ROOM, "ROOM_NOT_FOUND", roomId)));
+					return;
+				}
+				stop_watching();
+				auto snap = world.snapshot(roomId);
+				world.cast_enter_room(roomId, snap);
+				world.broadcast_enter_room(roomId, snap.title);
+			});
+		return;
+	}
+	if (cmd == "REQ_CHANGE_READY")
+	{
+		string roomId = kv["roomId"];
+		bool isReady = kv["isReady"] == "True";
+
+		world.post_state([this, self = shared_from_this(), roomId = move(roomId), isReady]()
+			{
+				world.change_ready(roomId, isReady);
+				world.cast_change_ready(roomId, isReady);
+			});
+		return;
+	}
+	if (cmd == "REQ_GAME_START")
+	{
+		string roomId = kv["roomId"];
+		world.post_state([this, self = shared_from_this(), roomId = move(roomId)]()
+			{
+				if (world.check_ready(roomId))
+				{
+					world.game_start(roomId);
+					world.cast_game_start(roomId);
+				}
+			});
+		return;
+	}
+	if (cmd == "REQ_FIRST_FLIP_END")
+	{
+		string roomId = kv["roomId"];
+		string actor = kv["actor"];
+
+		auto self = shared_from_this();
+		world.post_state([this, self, roomId = move(roomId), actor = move(actor)] {
+			if (world.game_peek_end(roomId, actor))
+			{
+				world.cast_game_peek_end(roomId);
+			}
+			});
+		return;
+	}
+	if (cmd == "REQ_FLIP")
+	{
+		string roomId = kv["roomId"];
+		string actor = kv["actor"];
+		int idx = 0;
+		if (!net::kv_int(kv, "index", idx))
+		{
+			write_line("ERR code=BAD_ARGS");
+			return;
+		}
+		world.post_state([this, self = shared_from_this(), roomId = move(roomId), actor, idx]()
+			{
+				world.flip_card(roomId, actor, idx);
+				if (world.check_end_game(roomId))
+					world.cast_end_game(roomId, idx);
+				else
+					world.cast_flip_result(roomId, idx);
+			});
+		return;
+	}
+	if (cmd == "REQ_ROOM_EXIT")
+	{
+		string roomId = kv["roomId"];
+		string actor = kv["actor"];
+		world.post_state([this, self = shared_from_this(), roomId = move(roomId), actor]()
+			{
+				auto snap = world.snapshot(roomId);
+
+				if (snap.phase == 1)
+					world.cast_forced_end_game(roomId);
+
+				world.cast_exit_room(roomId, snap.master, actor);
+				if (world.check_exit_room_master(roomId, actor))
+				{
+					world.change_room_master(roomId);
+					world.broadcast_change_room_master(roomId);
+				}
+				else
+				{
+					world.exit_room_challenger(roomId);
+					world.broadcast_exit_room(roomId);
+				}
+
+				if (world.check_exit_room_count(roomId) == 0)
+				{
+					if (snap.master == actor)
+					{
+						world.delete_room(roomId);
+						world.broadcast_delete_room(roomId, actor);
+					}
+				}
+				roomId_ = "";
+			});
+		return;
+	}
+	if (cmd == "REQ_CHANGE_RULE")
+	{
+		string roomId = kv["roomId"];
+		string master = kv["master"];
+		int cols = 0, rows = 0;
+		if (!net::kv_int(kv, "cols", cols) || !net::kv_int(kv, "rows", rows))
+		{
+			write_line("ERR code=BAD_ARGS");
+			return;
+		}
+		world.post_state([this, self = shared_from_this(), roomId = move(roomId), master = move(master), cols, rows]()
+			{
+				if (world.change_rule(roomId, master, cols, rows))
+					world.cast_change_rule(roomId);
+			});
+		return;
+	}
+	write_line("ERR code=UNKNOWN");
+}
+
+// 게이트웨이 요청. 응답은 같은 id 로 돌려준다
+void ControlSession::handle_frame(const rpc::Frame& f)
+{
+	// 프록시 모드: 게이트웨이가 대신 받은 클라이언트 줄
+	if (f.type == rpc::Type::Client)
+	{
+		string_view actor, line;
+		if (!rpc::split_target(f.payload, actor, line))
+			return;
+		world.post_state([this, self = shared_from_this(), gw = gw_, actor = string(actor), line = string(line)]
+			{
+				world.on_proxy_line(gw, actor, line);
+			});
+		return;
+	}
+	if (f.type != rpc::Type::Request)
+		return;
+	auto [cmd, kv] = net::parse_kv(string(f.payload));
+	uint32_t id = f.id;
+
+	if (cmd == "ENTER")
+	{
+		world.post_state([this, self = shared_from_this(), id, actor = kv["actor"], gw = kv["gw"]]
+			{
+				if (world.overloaded())
+					write_frame(rpc::Type::Response, id, "ERR code=OVERLOADED actor=" + actor);
+				else if (world.reserve_actor(actor, gw))
+					write_frame(rpc::Type::Response, id, "OK actor=" + actor);
+				else
+					write_frame(rpc::Type::Response, id, "ERR code=ACTOR_EXISTS actor=" + actor);
+			});
+		return;
+	}
+	if (cmd == "PING")
+	{
+		write_frame(rpc::Type::Response, id, "PONG");
+		return;
+	}
+	write_frame(rpc::Type::Response, id, "ERR code=UNKNOWN");
+}
+
+void ControlSession::stop_watching()
+{
+	if (watchRoom_.empty())
+		return;
+	world.unwatch_room(watchRoom_, actorId_);
+	watchRoom_ = "";
+}
+
+void ControlSession::on_disconnected()
+{
+	world.post_state([this, self = shared_from_this(), roomId = move(roomId_), actor = move(actorId_)]()
+		{
+			common::log("WORLD", "on_close " + actor);
+			// 풀에서 다시 쓰는 세션이 이전 관전 룸을 들고 가지 않게 여기서 비운다 (reset 은 state 밖이라 안 된다)
+			if (!watchRoom_.empty())
+				world.unwatch_room(watchRoom_, actor);
+			watchRoom_ = "";
+			if (actor != "")
+				world.broadcast_exit_server(actor, roomId, self.get());
+		});
+}
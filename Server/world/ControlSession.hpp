@@ -0,0 +1,50 @@
+#pragma once
+#include "../common/rpc.hpp"
+#include <memory>
+#include <string>
+
+using namespace std;
+
+class World;
+
+// 컨트롤(라인 프로토콜) 세션 공통부. 전송 계층은 파생 클래스가 담당
+class ControlSession : public enable_shared_from_this<ControlSession>
+{
+public:
+    explicit ControlSession(World& w);
+    virtual ~ControlSession() = default;
+
+    virtual void write_line(string s) = 0;
+    // 게이트웨이 RPC 프레임 전송. 프레임을 모르는 전송 계층은 payload 를 라인으로 보낸다
+    virtual void write_frame(rpc::Type t, uint32_t id, string payload) { (void)t; (void)id; write_line(move(payload)); }
+    // 여러 세션에 같은 바이트를 보낼 때 (관전 fan-out). 줄 끝 '\n' 까지 들어 있다
+    // 공유 버퍼를 그대로 큐에 넣을 수 없는 전송 계층은 사본을 라인으로 보낸다
+    virtual void write_shared(shared_ptr<const string> bytes)
+    {
+        string s = *bytes;
+        if (!s.empty() && s.back() == '\n')
+            s.pop_back();
+        write_line(move(s));
+    }
+
+    // 게이트웨이 프록시 모드 클라이언트 (ProxySession) 인지
+    virtual bool proxied() const { return false; }
+    // 링크 연결이면 보낸 게이트웨이, 프록시 클라이언트면 거쳐 온 게이트웨이 id
+    const string& gateway() const { return gw_; }
+
+    string actorId_ = "";
+    string roomId_ = "";
+    string watchRoom_ = ""; // 관전 중인 룸
+
+protected:
+    void handle(const string& line);
+    void handle_frame(const rpc::Frame& f);
+    void on_disconnected();
+    // 룸에 플레이어로 들어가면 보던 룸은 그만 본다 (state 에서)
+    void stop_watching();
+
+    World& world;
+    bool gateway_ = false; // 서명이 맞는 GW_HELLO 를 받았다 (인증된 게이트웨이 링크)
+    bool rpc_ = false; // GW_HELLO rpc=1 이후 프레임 모드 (게이트웨이 링크)
+    string gw_;
+};
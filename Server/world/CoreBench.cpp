@@ -0,0 +1,105 @@
+#include "CoreBench.hpp"
+#include "../common/common.hpp"
+#include "../common/cpu_time.hpp"
+#include "../common/handler_alloc.hpp"
+#include "../common/io_pool.hpp"
+#include "../common/stats.hpp"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+using namespace std;
+
+namespace
+{
+	struct Shared
+	{
+		Shared(net::IoPool& p, stats::Histogram& h) : pool(p), rtt(h) {}
+
+		net::IoPool& pool;
+		stats::Histogram& rtt;
+		atomic<bool> stop{ false };
+		atomic<int64_t> hops{ 0 };
+		atomic<int> inflight{ 0 };
+	};
+
+	// 세션 코어 -> state 코어 -> 세션 코어. 블록은 보낸 코어에서 할당되고 받은 코어에서 해제된다
+	void round_trip(shared_ptr<Shared> s, int core)
+	{
+		auto t0 = chrono::steady_clock::now();
+		auto& pool = s->pool;
+		pool.post(0, [s = move(s), core, t0]() mutable
+			{
+				s->hops.fetch_add(1, memory_order_relaxed);
+				auto& pool = s->pool;
+				pool.post(core, [s = move(s), core, t0]() mutable
+					{
+						s->hops.fetch_add(1, memory_order_relaxed);
+						s->rtt.record_since(t0);
+						if (s->stop.load(memory_order_relaxed))
+						{
+							s->inflight.fetch_sub(1, memory_order_relaxed);
+							return;
+						}
+						round_trip(move(s), core);
+					});
+			});
+	}
+}
+
+CoreBench::CoreBench(const unordered_map<string, string>& opts)
+	: threads_(max(2, common::opt_int(opts, "threads", 4)))
+	, seconds_(max(1, common::opt_int(opts, "seconds", 5)))
+	, window_(max(1, common::opt_int(opts, "window", 32)))
+	, pin_(common::opt_int(opts, "pin", 0) != 0)
+{
+}
+
+int CoreBench::run()
+{
+	net::IoPool pool(threads_, pin_, false);
+	auto s = make_shared<Shared>(pool, stats::histogram("bench.core_rtt_us"));
+	s->inflight = (pool.size() - 1) * window_;
+	for (int c = 1; c < pool.size(); c++)
+		pool.post(c, [s, c, window = window_]
+			{
+				for (int k = 0; k < window; k++)
+					round_trip(s, c);
+			});
+	thread runner([&] { pool.run(); });
+
+	auto& heap = net::HandlerMemory::heap();
+	auto& recycled = net::HandlerMemory::recycled();
+	auto& remote = net::HandlerMemory::remote();
+	auto& overflow = stats::counter("core.mailbox_overflow");
+
+	// 워밍업 동안 각 코어의 free-list 가 찬다. 그 뒤로는 힙 할당이 없어야 한다
+	this_thread::sleep_for(chrono::milliseconds(500));
+	int64_t heap0 = heap.get(), recycled0 = recycled.get(), remote0 = remote.get(), hops0 = s->hops.load();
+	double cpu0 = stats::process_cpu_s();
+	auto t0 = chrono::steady_clock::now();
+	this_thread::sleep_for(chrono::seconds(seconds_));
+	int64_t heap1 = heap.get(), recycled1 = recycled.get(), remote1 = remote.get(), hops1 = s->hops.load();
+	double cpu = stats::process_cpu_s() - cpu0;
+	double wall = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+	s->stop = true;
+	auto until = chrono::steady_clock::now() + chrono::seconds(2);
+	while (s->inflight.load(memory_order_relaxed) > 0 && chrono::steady_clock::now() < until)
+		this_thread::sleep_for(chrono::milliseconds(1));
+	pool.stop();
+	runner.join();
+
+	int64_t hops = hops1 - hops0;
+	common::log("BENCH", "cores=" + to_string(pool.size()) + " window=" + to_string(window_)
+		+ " pin=" + to_string(pin_ ? 1 : 0) + " wall_s=" + to_string(wall));
+	common::log("BENCH", "hops=" + to_string(hops) + " hops/s=" + to_string(int64_t(hops / wall))
+		+ " rtt_us.p50=" + to_string(s->rtt.percentile(0.50)) + " rtt_us.p99=" + to_string(s->rtt.percentile(0.99))
+		+ " cpu_ns/hop=" + to_string(hops ? cpu * 1e9 / hops : 0.0)
+		+ " mailbox_overflow=" + to_string(overflow.get()));
+	common::log("BENCH", "alloc.handler_heap_steady=" + to_string(heap1 - heap0)
+		+ " alloc.handler_recycled_steady=" + to_string(recycled1 - recycled0)
+		+ " alloc.handler_remote_free_steady=" + to_string(remote1 - remote0));
+	return 0;
+}
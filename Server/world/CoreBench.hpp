@@ -0,0 +1,23 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+// 코어별(io=percore) 모드의 코어 간 전달 측정
+// 세션 코어마다 window 개의 작업이 state 코어(0) 를 거쳐 돌아온다 (TcpSession 의 post_state -> post_home 모양)
+// 왕복 지연, 초당 전달 수와 워밍업 이후 alloc.* 증가분 (핸들러 힙 할당이 0 이어야 한다) 을 잰다
+// 사용: world_server corebench threads=4 seconds=5 window=32 pin=0
+class CoreBench
+{
+public:
+    explicit CoreBench(const unordered_map<string, string>& opts);
+
+    int run();
+
+private:
+    int threads_;
+    int seconds_;
+    int window_; // 세션 코어당 동시에 도는 작업 수
+    bool pin_;
+};
@@ -0,0 +1,110 @@
+#include "LinkMonitor.hpp"
+#include "UdpTransport.hpp"
+#include "../common/stats.hpp"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+using namespace std;
+using udp = asio::ip::udp;
+
+void LinkMonitor::tick(const vector<pair<udp::endpoint, uint32_t>>& clients, int64_t now_ms, UdpTransport& udp)
+{
+    static auto& pings = stats::counter("link.pings");
+    static auto& lost = stats::counter("link.lost");
+
+    tick_++;
+    for (const auto& c : clients)
+    {
+        auto& l = links_[c.first];
+        if (l.tick == 0)
+            l.budget = limits_.max_budget;
+        l.tick = tick_;
+        if (now_ms < l.next_ping_ms)
+            continue;
+
+        // 이전 PING 에 아직 답이 없으면 잃은 것으로 친다
+        if (l.waiting && l.sampled)
+        {
+            lost.add();
+            l.loss = l.loss * 0.875f + 0.125f;
+            adapt(l);
+        }
+        l.seq++;
+        l.waiting = true;
+        l.sent_ms = now_ms;
+        l.next_ping_ms = now_ms + limits_.ping_ms;
+        pings.add();
+        udp.send_to(make_shared<const string>("PING seq=" + to_string(l.seq) + " st=" + to_string(now_ms)
+            + " rtt=" + to_string(int(l.srtt))), c.first);
+    }
+
+    for (auto it = links_.begin(); it != links_.end(); )
+        it = (it->second.tick != tick_) ? links_.erase(it) : next(it);
+}
+
+void LinkMonitor::on_pong(const udp::endpoint& ep, uint32_t seq, int64_t now_ms)
+{
+    static auto& rtt_hist = stats::histogram("link.rtt");
+
+    auto it = links_.find(ep);
+    if (it == links_.end())
+        return;
+    auto& l = it->second;
+    if (!l.waiting || seq != l.seq)
+        return; // 늦게 온 PONG (이미 잃은 것으로 셌다)
+    l.waiting = false;
+
+    // RFC 6298 방식의 평활 RTT 와 편차 (편차를 지터로 쓴다)
+    float rtt = float(max<int64_t>(0, now_ms - l.sent_ms));
+    rtt_hist.record(int64_t(rtt) * 1000);
+    if (!l.sampled)
+    {
+        l.srtt = rtt;
+        l.rttvar = rtt / 2;
+        l.sampled = true;
+    }
+    else
+    {
+        l.rttvar = 0.75f * l.rttvar + 0.25f * fabs(l.srtt - rtt);
+        l.srtt = 0.875f * l.srtt + 0.125f * rtt;
+    }
+    l.loss *= 0.875f;
+    adapt(l);
+}
+
+LinkMonitor::Rate LinkMonitor::rate(const udp::endpoint& ep) const
+{
+    auto it = links_.find(ep);
+    if (it == links_.end() || it->second.budget == 0)
+        return { 1, limits_.max_budget };
+    return { it->second.every, it->second.budget };
+}
+
+// 나쁘면 주기 2배/예산 3/4, 좋으면 주기 -1/예산 +1/8 (천천히 회복)
+void LinkMonitor::adapt(Link& l)
+{
+    static auto& degraded = stats::counter("link.degraded");
+    static auto& improved = stats::counter("link.improved");
+
+    bool poor = l.loss > limits_.loss_hi || l.srtt > limits_.rtt_hi || l.rttvar > limits_.jitter_hi;
+    bool good = l.loss < limits_.loss_hi / 4 && l.srtt < limits_.rtt_hi / 2 && l.rttvar < limits_.jitter_hi / 2;
+    if (poor)
+    {
+        int every = min(limits_.max_every, l.every * 2);
+        size_t budget = max(limits_.min_budget, l.budget * 3 / 4);
+        if (every != l.every || budget != l.budget)
+            degraded.add();
+        l.every = every;
+        l.budget = budget;
+    }
+    else if (good)
+    {
+        int every = max(1, l.every - 1);
+        size_t budget = min(limits_.max_budget, l.budget + limits_.max_budget / 8);
+        if (every != l.every || budget != l.budget)
+            improved.add();
+        l.every = every;
+        l.budget = budget;
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <asio.hpp>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "UdpSessionManager.hpp"
+
+using namespace std;
+
+class UdpTransport;
+
+// 클라이언트 UDP 링크 품질 (RTT, 지터, 손실) 을 재고 그에 맞춰 스냅샷 주기/예산을 정한다
+//   서버 -> 클라: "PING seq=N st=<서버 ms> rtt=<srtt ms>"
+//                 클라는 (st + rtt/2 - 받은 시각) 으로 서버 시계와의 차이를 잡아 보간에 쓴다
+//   클라 -> 서버: "PONG seq=N"
+// 나쁜 링크는 주기를 늘리고 예산을 줄여서 (큐가 쌓이기 전에) 덜 보내고, 좋아지면 다시 올린다
+// PONG 을 한 번도 안 보낸 클라이언트는 기본값 (매 tick, 최대 예산) 그대로
+// strand_tx 에서만 호출된다
+class LinkMonitor
+{
+public:
+    struct Limits
+    {
+        int ping_ms = 500;          // ping_ms=
+        int max_every = 5;          // 가장 나쁠 때 몇 tick 에 한 번 보내나 (snap_hz_min= 으로 정한다)
+        size_t min_budget = 1200;   // snap_budget_min=
+        size_t max_budget = 4096;   // snap_budget=
+        int rtt_hi = 250;           // link_rtt_hi=    (ms) 넘으면 나쁨, 절반 아래면 좋음
+        int jitter_hi = 60;         // link_jitter_hi= (ms)
+        float loss_hi = 0.05f;      // link_loss_pct=  (%)
+    };
+
+    struct Rate
+    {
+        int every;     // 몇 tick 에 한 번
+        size_t budget; // 한 번에 보내는 최대 바이트
+    };
+
+    void set_limits(const Limits& l) { limits_ = l; }
+
+    // tick 마다: 때가 된 클라이언트에 PING, 없어진 클라이언트는 잊는다
+    void tick(const vector<pair<asio::ip::udp::endpoint, uint32_t>>& clients, int64_t now_ms, UdpTransport& udp);
+    void on_pong(const asio::ip::udp::endpoint& ep, uint32_t seq, int64_t now_ms);
+    Rate rate(const asio::ip::udp::endpoint& ep) const;
+
+private:
+    struct Link
+    {
+        uint32_t seq = 0;
+        bool waiting = false;   // seq 에 대한 PONG 을 기다리는 중
+        int64_t sent_ms = 0;
+        int64_t next_ping_ms = 0;
+        bool sampled = false;   // PONG 을 한 번이라도 받았다
+        float srtt = 0, rttvar = 0, loss = 0;
+        int every = 1;
+        size_t budget = 0;
+        uint64_t tick = 0;
+    };
+    void adapt(Link& l);
+
+    Limits limits_;
+    uint64_t tick_ = 0;
+    unordered_map<asio::ip::udp::endpoint, Link, UdpEndpointHash> links_;
+};
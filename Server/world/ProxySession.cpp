@@ -0,0 +1,48 @@
+#include "ProxySession.hpp"
+#include "world.hpp"
+#include "../common/net.hpp"
+#include "../common/rpc.hpp"
+#include "../common/stats.hpp"
+
+using namespace std;
+
+ProxySession::ProxySession(World& w, string gw, string actor)
+	: ControlSession(w), target_(move(actor))
+{
+	gw_ = move(gw);
+}
+
+void ProxySession::write_line(string s)
+{
+	if (closed_)
+		return;
+	if (!s.empty() && s.back() == '\n')
+		s.pop_back();
+	world.send_to_client(gw_, target_, s);
+}
+
+// 링크 등록(GW_HELLO), REQ_STATS 는 게이트웨이 링크/직접 연결에서만. gw_ 는 만들 때 받은 값 그대로 둔다
+// HELLO 는 게이트웨이가 attach 하며 넘기는 첫 줄(자기 actor)만 받는다
+void ProxySession::feed(const string& line)
+{
+	static auto& refused = stats::counter("proxy.refused_lines");
+	auto [cmd, kv] = net::parse_kv(line);
+	bool first_hello = cmd == "HELLO" && !hello_ && kv["actor"] == target_;
+	if (first_hello)
+		hello_ = true;
+	else if (cmd.rfind("REQ_", 0) != 0 || cmd == "REQ_STATS")
+	{
+		refused.add();
+		write_line("ERR code=UNKNOWN");
+		return;
+	}
+	handle(line);
+}
+
+void ProxySession::close()
+{
+	if (closed_)
+		return;
+	closed_ = true;
+	on_disconnected();
+}
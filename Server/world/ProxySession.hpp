@@ -0,0 +1,30 @@
+#pragma once
+#include "ControlSession.hpp"
+#include <memory>
+#include <string>
+
+using namespace std;
+
+class World;
+
+// 게이트웨이 프록시 모드로 붙은 클라이언트. 소켓은 게이트웨이가 들고 있고,
+// 클라이언트가 보낸 줄은 링크의 Client 프레임으로 들어와 state 에서 feed 로 처리한다
+// 보내는 줄은 그 게이트웨이 링크로 (state 에서만 호출)
+class ProxySession : public ControlSession
+{
+public:
+    ProxySession(World& w, string gw, string actor);
+
+    void write_line(string s) override;
+    bool proxied() const override { return true; }
+
+    // 게이트웨이가 넘긴 클라이언트 줄. 룸/로비 요청(REQ_*)만 받는다
+    void feed(const string& line);
+    // 게이트웨이가 CLIENT_BYE 를 보냈거나 게이트웨이 링크가 모두 끊겼을 때
+    void close();
+
+private:
+    string target_; // 게이트웨이가 클라이언트를 찾는 키 (actorId_ 는 종료 시 비워진다)
+    bool closed_ = false;
+    bool hello_ = false;
+};
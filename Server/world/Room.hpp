@@ -35,6 +35,12 @@ public:
 	string turn;
 	unordered_map<string, int> score;
 	Phase phase = Phase::READY;
+	// World 룸 목록 색인에 올라간 키 (바뀌면 빼고 다시 넣는다)
+	int listed_phase = -1;
+	int listed_taken = -1;
+	// 관전자 (actor). 룸 이벤트는 tick 마다 watch_batch 에 모았다가 한 번 만든 버퍼를 모두에게 보낸다
+	unordered_set<string> watchers;
+	string watch_batch;
 
 	void create_deck(uint32_t seed);
 	void start_game();
@@ -0,0 +1,55 @@
+#include "ShmAcceptor.hpp"
+#if defined(__linux__)
+#include "ShmSession.hpp"
+#include "world.hpp"
+#include "../common/common.hpp"
+#include <unistd.h>
+
+using namespace std;
+using local = asio::local::stream_protocol;
+
+namespace
+{
+    local::acceptor listen_at(asio::io_context& io, const string& path)
+    {
+        ::unlink(path.c_str()); // 이전 실행이 남긴 소켓 파일
+        return local::acceptor(io, local::endpoint(path));
+    }
+}
+
+ShmAcceptor::ShmAcceptor(asio::io_context& io, const string& path, World& world, size_t cap)
+    : io_(io), acc_(listen_at(io, path)), path_(path), world_(world), cap_(cap)
+{
+    accept();
+    common::log("WORLD", "control listen SHM " + path_);
+}
+
+ShmAcceptor::~ShmAcceptor()
+{
+    ::unlink(path_.c_str());
+}
+
+void ShmAcceptor::accept()
+{
+    acc_.async_accept([this](error_code ec, local::socket s)
+        {
+            if (!ec)
+            {
+                int fds[3] = { -1, -1, -1 };
+                if (shm::create_segment(cap_, fds) && shm::send_fds(s.native_handle(), fds, uint32_t(cap_)))
+                {
+                    auto session = make_shared<ShmSession>(io_, world_);
+                    auto ch = make_shared<shm::Channel>(session->executor(), fds, cap_, 1, move(s));
+                    session->start(move(ch));
+                }
+                else
+                {
+                    common::log("WORLD", "shm link setup failed");
+                    for (int fd : fds)
+                        if (fd >= 0) ::close(fd);
+                }
+            }
+            accept();
+        });
+}
+#endif
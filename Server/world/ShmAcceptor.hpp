@@ -0,0 +1,26 @@
+#pragma once
+#include "../common/shm_channel.hpp"
+#if defined(__linux__)
+#include <asio.hpp>
+#include <string>
+
+class World;
+
+// 같은 호스트 게이트웨이용 링크 수락 (실행 옵션 shm=<유닉스 소켓 경로>)
+// 연결마다 공유 메모리 링 한 쌍을 만들어 fd 를 넘기고 ShmSession 을 띄운다
+class ShmAcceptor
+{
+public:
+    ShmAcceptor(asio::io_context& io, const string& path, World& world, size_t cap = shm::kDefaultCap);
+    ~ShmAcceptor();
+
+private:
+    void accept();
+
+    asio::io_context& io_;
+    asio::local::stream_protocol::acceptor acc_;
+    string path_;
+    World& world_;
+    size_t cap_;
+};
+#endif
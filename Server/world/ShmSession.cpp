@@ -0,0 +1,146 @@
+#include "ShmSession.hpp"
+#if defined(__linux__)
+#include "world.hpp"
+#include "../common/common.hpp"
+#include "../common/handler_alloc.hpp"
+
+using namespace std;
+
+ShmSession::ShmSession(asio::io_context& io, World& w)
+	: ControlSession(w), strand_(asio::make_strand(io.get_executor()))
+	, write_signal_(strand_, asio::steady_timer::time_point::max())
+{
+}
+
+void ShmSession::start(shared_ptr<shm::Channel> ch)
+{
+	ch_ = move(ch);
+	ch_->start(ch_);
+	auto self = static_pointer_cast<ShmSession>(shared_from_this());
+	// 핸들러가 던지면 co_spawn 이 예외를 넘겨준다. detached 로 버리면 on_close 없이 끝나 연결/슬롯이 샌다
+	auto done = [self](exception_ptr e)
+		{
+			if (e)
+				self->on_close();
+		};
+	asio::co_spawn(strand_, reader(self), done);
+	asio::co_spawn(strand_, writer(self), done);
+}
+
+asio::awaitable<void> ShmSession::reader([[maybe_unused]] shared_ptr<ShmSession> self)
+{
+	error_code ec;
+	for (;;)
+	{
+		// 완성된 줄(GW_HELLO) 또는 프레임이 있으면 처리, 없으면 링에서 더 읽는다
+		if (rpc_)
+		{
+			rpc::Frame f;
+			long used = rpc::parse(buf_.data(), buf_.size(), f);
+			if (used < 0)
+				break;
+			if (used > 0)
+			{
+				handle_frame(f);
+				buf_.consume(size_t(used));
+				continue;
+			}
+		}
+		else
+		{
+			string_view line;
+			if (buf_.next_line(line))
+			{
+				if (!line.empty())
+					handle(string(line));
+				continue;
+			}
+		}
+		if (buf_.full())
+			break;
+		size_t n = co_await ch_->read(buf_.prepare(), ec);
+		if (ec)
+			break;
+		buf_.commit(n);
+	}
+	on_close();
+}
+
+asio::awaitable<void> ShmSession::writer([[maybe_unused]] shared_ptr<ShmSession> self)
+{
+	static constexpr size_t kMaxBatch = 64;
+	error_code ec;
+	while (!closed_)
+	{
+		if (writeQueue.empty())
+		{
+			co_await write_signal_.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+			continue;
+		}
+		batch_.clear();
+		for (size_t i = 0; i < writeQueue.size() && i < kMaxBatch; i++)
+			batch_.push_back(asio::buffer(writeQueue[i]));
+		size_t n = batch_.size();
+		ec.clear();
+		co_await ch_->write(batch_, ec);
+		if (ec)
+		{
+			on_close();
+			break;
+		}
+		writeQueue.erase(writeQueue.begin(), writeQueue.begin() + n);
+	}
+}
+
+void ShmSession::write_line(string s)
+{
+	// world(state) 쪽에서 부르면 세션 strand 로 넘겨서 큐를 한 스레드만 만지게 한다
+	if (!strand_.running_in_this_thread())
+	{
+		asio::post(strand_, net::recycled([this, self = shared_from_this(), s = move(s)]() mutable { write_line(move(s)); }));
+		return;
+	}
+	if (rpc_)
+	{
+		if (!s.empty() && s.back() == '\n')
+			s.pop_back();
+		string f;
+		rpc::append(f, rpc::Type::Event, 0, s);
+		enqueue(move(f));
+		return;
+	}
+	s.push_back('\n');
+	enqueue(move(s));
+}
+
+void ShmSession::write_frame(rpc::Type t, uint32_t id, string payload)
+{
+	if (!strand_.running_in_this_thread())
+	{
+		asio::post(strand_, net::recycled([this, self = shared_from_this(), t, id, p = move(payload)]() mutable { write_frame(t, id, move(p)); }));
+		return;
+	}
+	string f;
+	f.reserve(rpc::kHeader + payload.size());
+	rpc::append(f, t, id, payload);
+	enqueue(move(f));
+}
+
+void ShmSession::enqueue(string bytes)
+{
+	if (closed_)
+		return;
+	writeQueue.push_back(move(bytes));
+	write_signal_.cancel_one();
+}
+
+void ShmSession::on_close()
+{
+	if (closed_)
+		return;
+	closed_ = true;
+	on_disconnected();
+	ch_->close();
+	write_signal_.cancel();
+}
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+#include "ControlSession.hpp"
+#include "../common/shm_channel.hpp"
+#include "../common/recv_buffer.hpp"
+#if defined(__linux__)
+#include <asio.hpp>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class World;
+
+// 같은 호스트 게이트웨이의 링크 연결 (공유 메모리 링). 흐르는 바이트와 처리는 TcpSession 과 같다
+class ShmSession : public ControlSession
+{
+public:
+    ShmSession(asio::io_context& io, World& w);
+    asio::any_io_executor executor() const { return strand_; }
+    void start(shared_ptr<shm::Channel> ch);
+    void write_line(string s) override;
+    void write_frame(rpc::Type t, uint32_t id, string payload) override;
+
+private:
+    asio::awaitable<void> reader(shared_ptr<ShmSession> self);
+    asio::awaitable<void> writer(shared_ptr<ShmSession> self);
+    void enqueue(string bytes);
+    void on_close();
+
+private:
+    asio::strand<asio::any_io_executor> strand_;
+    shared_ptr<shm::Channel> ch_;
+    bool closed_ = false;
+    net::RecvBuffer buf_{ rpc::kMaxBuffered };
+    deque<string> writeQueue;
+    vector<asio::const_buffer> batch_;
+    asio::steady_timer write_signal_; // writer 깨우기 용 (만료 없음, cancel 로 깨운다)
+};
+#endif
@@ -0,0 +1,436 @@
+#include "Simulation.hpp"
+#include "world.hpp"
+#include "ControlSession.hpp"
+#include "UdpTransport.hpp"
+#include "WorldClock.hpp"
+#include "../common/common.hpp"
+#include "../common/net.hpp"
+#include "../common/handler_alloc.hpp"
+#include "../common/stats.hpp"
+#include "../common/udp_token.hpp"
+#include "../common/link_auth.hpp"
+#include <asio.hpp>
+#include <deque>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+using asio::ip::udp;
+using namespace std;
+
+namespace
+{
+	struct SimStats
+	{
+		uint64_t lines = 0, line_bytes = 0;
+		uint64_t udp_packets = 0, udp_bytes = 0;
+		uint64_t moves = 0, flips = 0, games = 0;
+		vector<pair<udp::endpoint, string>> pings; // 봇이 답할 서버 PING
+		// 마지막 확인용: 이 actor 의 이 위치가 든 스냅샷을 받은 endpoint 를 모은다 (양자화 오차까지 허용)
+		string probe;               // "ACTOR_POS id=<actor> "
+		float probe_x = 0.f, probe_y = 0.f;
+		set<udp::endpoint> probe_got;
+	};
+
+	// 송신만 집계하는 UDP 전송 (수신은 시뮬레이터가 on_datagram 으로 직접 주입)
+	class SimUdpTransport : public UdpTransport
+	{
+	public:
+		explicit SimUdpTransport(SimStats& st) : st_(st) {}
+
+		void start(asio::strand<Executor>&, RecvHandler) override {}
+		void send_to(shared_ptr<const string> msg, const udp::endpoint& ep) override
+		{
+			st_.udp_packets++;
+			st_.udp_bytes += msg->size();
+			if (msg->rfind("PING", 0) == 0)
+				st_.pings.emplace_back(ep, *msg);
+			else if (!st_.probe.empty())
+				check_probe(*msg, ep);
+		}
+
+	private:
+		void check_probe(const string& msg, const udp::endpoint& ep)
+		{
+			auto at = msg.find(st_.probe);
+			if (at == string::npos)
+				return;
+			auto line = msg.substr(at + st_.probe.size(), msg.find('\n', at) - at - st_.probe.size());
+			auto kv = net::kvparse(line);
+			float x = kv.count("x") ? stof(kv["x"]) : 0.f, y = kv.count("y") ? stof(kv["y"]) : 0.f;
+			if (fabs(x - st_.probe_x) <= 0.5f && fabs(y - st_.probe_y) <= 0.5f)
+				st_.probe_got.insert(ep);
+		}
+
+		SimStats& st_;
+	};
+
+	// 메모리 컨트롤 세션: 서버 -> 클라 라인을 집계하고, 클라 -> 서버 라인은 handle 로 바로 넣는다
+	class SimSession : public ControlSession
+	{
+	public:
+		SimSession(World& w, SimStats& st) : ControlSession(w), st_(st) {}
+
+		void write_line(string s) override
+		{
+			st_.lines++;
+			st_.line_bytes += s.size() + 1;
+			on_line(s);
+		}
+		void send(const string& line) { handle(line); }
+
+	protected:
+		virtual void on_line(const string&) {}
+
+		SimStats& st_;
+	};
+
+	// 방 하나를 두 봇이 반복해서 플레이한다. 틱당 한 줄씩만 보내서 실제 속도를 흉내낸다
+	class SimBot : public SimSession
+	{
+	public:
+		SimBot(World& w, SimStats& st, string id, bool master, int miss_pct, mt19937& rng)
+			: SimSession(w, st), id_(move(id)), master_(master), miss_pct_(miss_pct), rng_(rng)
+		{
+		}
+
+		const string& id() const { return id_; }
+		void set_partner(SimBot* p) { partner_ = p; }
+		void queue(string line) { outbox_.push_back(move(line)); }
+
+		void act()
+		{
+			if (outbox_.empty()) return;
+			string line = move(outbox_.front());
+			outbox_.pop_front();
+			send(line);
+		}
+
+		string next_move()
+		{
+			uniform_real_distribution<float> d(-1.f, 1.f);
+			x_ += d(rng_);
+			y_ += d(rng_);
+			st_.moves++;
+			return "MOVE seq=" + to_string(++seq_) + " x=" + to_string(x_) + " y=" + to_string(y_);
+		}
+		// 지금 위치와 확실히 구분되는 (양자화 단위 1 이어도) 한 걸음. 새 위치를 x, y 에
+		string step(float& x, float& y)
+		{
+			x = x_ += 1.5f;
+			y = y_ -= 1.5f;
+			return "MOVE seq=" + to_string(++seq_) + " x=" + to_string(x_) + " y=" + to_string(y_);
+		}
+
+	protected:
+		void on_line(const string& line) override
+		{
+			auto [cmd, kv] = net::parse_kv(line);
+			if (cmd == "RES_CREATE_ROOM")
+			{
+				room_ = kv["roomId"];
+				if (partner_)
+					partner_->queue("REQ_ENTER_ROOM roomId=" + room_);
+			}
+			else if (cmd == "CAST_ENTER_ROOM")
+			{
+				room_ = kv["roomId"];
+				if (master_ && partner_ && kv["challenger"] == partner_->id())
+				{
+					queue("REQ_CHANGE_READY roomId=" + room_ + " isReady=True");
+					queue("REQ_GAME_START roomId=" + room_);
+				}
+			}
+			else if (cmd == "CAST_GAME_START")
+			{
+				parse_cards(kv["cards"]);
+				queue("REQ_FIRST_FLIP_END roomId=" + room_ + " actor=" + id_);
+			}
+			else if (cmd == "CAST_FIRST_FLIP_END")
+			{
+				if (kv["turn"] == id_)
+					plan_pair();
+			}
+			else if (cmd == "CAST_FLIP_RESULT")
+			{
+				int idx = common::to_int(kv["index"].c_str(), -1);
+				int card = common::to_int(kv["card"].c_str(), -1);
+				if (first_idx_ < 0)
+				{
+					first_idx_ = idx;
+					first_card_ = card;
+					return;
+				}
+				if (card == first_card_ && idx >= 0 && first_idx_ != idx)
+				{
+					matched_[idx] = true;
+					matched_[first_idx_] = true;
+				}
+				first_idx_ = -1;
+				if (kv["turn"] == id_)
+					plan_pair();
+			}
+			else if (cmd == "CAST_END_GAME")
+			{
+				first_idx_ = -1;
+				if (master_)
+				{
+					st_.games++;
+					queue("REQ_GAME_START roomId=" + room_);
+				}
+			}
+		}
+
+	private:
+		void parse_cards(const string& s)
+		{
+			cards_.clear();
+			size_t pos = 0;
+			while (pos <= s.size())
+			{
+				auto comma = s.find(',', pos);
+				if (comma == string::npos) comma = s.size();
+				cards_.push_back(common::to_int(s.substr(pos, comma - pos).c_str(), -1));
+				pos = comma + 1;
+			}
+			matched_.assign(cards_.size(), false);
+			first_idx_ = -1;
+		}
+
+		void plan_pair()
+		{
+			// 남은 짝 중 하나를 고른다. miss_pct_ 확률로 일부러 틀려서 턴을 넘긴다
+			vector<pair<int, int>> open;
+			for (int i = 0; i < (int)cards_.size() && open.size() < 2; i++)
+			{
+				if (matched_[i]) continue;
+				for (int j = i + 1; j < (int)cards_.size(); j++)
+				{
+					if (!matched_[j] && cards_[j] == cards_[i])
+					{
+						open.emplace_back(i, j);
+						break;
+					}
+				}
+			}
+			if (open.empty()) return;
+
+			int a = open[0].first, b = open[0].second;
+			if (open.size() > 1 && (int)(rng_() % 100) < miss_pct_)
+				b = open[1].first;
+
+			queue("REQ_FLIP roomId=" + room_ + " actor=" + id_ + " index=" + to_string(a));
+			queue("REQ_FLIP roomId=" + room_ + " actor=" + id_ + " index=" + to_string(b));
+			st_.flips += 2;
+		}
+
+		string id_;
+		bool master_;
+		int miss_pct_;
+		mt19937& rng_;
+		SimBot* partner_ = nullptr;
+		deque<string> outbox_;
+
+		string room_;
+		vector<int> cards_;
+		vector<bool> matched_;
+		int first_idx_ = -1;
+		int first_card_ = -1;
+
+		uint32_t seq_ = 0;
+		float x_ = 0.f, y_ = 0.f;
+	};
+}
+
+Simulation::Simulation(const unordered_map<string, string>& opts)
+	: actors_(max(2, common::opt_int(opts, "actors", 200)))
+	, seconds_(common::opt_int(opts, "seconds", 3600))
+	, tick_ms_(max(1, common::opt_int(opts, "tick_ms", 100)))
+	, stray_(common::opt_int(opts, "stray", 20))
+	, miss_pct_(common::opt_int(opts, "miss", 20))
+	, lobby_(max(0, common::opt_int(opts, "lobby", 0)))
+	, watchers_(max(0, common::opt_int(opts, "watchers", 0)))
+	, seed_(common::opt_int(opts, "seed", 1))
+	, verbose_(common::opt_int(opts, "log", 0) != 0)
+	, opts_(opts)
+{
+}
+
+int Simulation::run()
+{
+	asio::io_context io;
+	VirtualClock clock;
+	SimStats st;
+	mt19937 rng(seed_);
+
+	World world(io, make_unique<SimUdpTransport>(st), clock, udptoken::kDevKey, 1);
+	world.set_tick_limits(opts_);
+	world.set_watch_limit(common::opt_int(opts_, "room_watchers", 500));
+	world.set_udp_limits(opts_);
+	world.set_snapshot_limits(opts_);
+	common::log_muted() = !verbose_;
+
+	auto pump = [&]
+		{
+			io.restart();
+			io.poll();
+		};
+	auto inject = [&](string msg, const udp::endpoint& ep)
+		{
+			asio::post(world.state_strand(), [&world, msg = move(msg), ep]
+				{
+					world.on_datagram(msg.data(), msg.size(), ep);
+				});
+		};
+
+	auto gateway = make_shared<SimSession>(world, st);
+	vector<shared_ptr<SimBot>> bots;
+	vector<udp::endpoint> eps;
+	bots.reserve(actors_);
+	for (int i = 0; i < actors_; i++)
+	{
+		bots.push_back(make_shared<SimBot>(world, st, "sim" + to_string(i), i % 2 == 0, miss_pct_, rng));
+		eps.emplace_back(asio::ip::address_v4(0x0A000000u + i), static_cast<unsigned short>(20000 + i % 40000));
+	}
+	for (int i = 0; i + 1 < actors_; i += 2)
+	{
+		bots[i]->set_partner(bots[i + 1].get());
+		bots[i + 1]->set_partner(bots[i].get());
+	}
+
+	// 접속: 컨트롤 HELLO -> (게이트웨이가 서명한) 토큰으로 UDP HELLO
+	gateway->send("GW_HELLO mac=" + linkauth::mac(udptoken::kDevKey, ""));
+	for (int i = 0; i < actors_; i++)
+		bots[i]->send("HELLO actor=" + bots[i]->id());
+	pump();
+	for (int i = 0; i < actors_; i++)
+	{
+		string tok = udptoken::mint(udptoken::kDevKey, bots[i]->id(), 1, clock.unix_ms() + 6000, i);
+		inject("HELLO token=" + tok + " actor=" + bots[i]->id(), eps[i]);
+	}
+	pump();
+	for (int i = 0; i < min(lobby_, actors_); i++)
+		bots[i]->queue("REQ_ROOM_LIST subscribe=1");
+	for (int i = 0; i + 1 < actors_; i += 2)
+		bots[i]->queue("REQ_CREATE_ROOM title=sim" + to_string(i / 2) + " rows=4 cols=4");
+	vector<shared_ptr<SimSession>> watchers;
+	for (int i = 0; i < watchers_; i++)
+	{
+		watchers.push_back(make_shared<SimSession>(world, st));
+		watchers.back()->send("HELLO actor=watch" + to_string(i));
+	}
+
+	const int64_t total_ticks = (int64_t)seconds_ * 1000 / tick_ms_;
+	uint64_t stray_seq = 0;
+	int since_sweep = 0;
+	auto wall0 = chrono::steady_clock::now();
+	int64_t heap0 = 0;
+
+	for (int64_t t = 0; t < total_ticks; t++)
+	{
+		clock.advance(chrono::milliseconds(tick_ms_));
+		for (int i = 0; i < actors_; i++)
+		{
+			bots[i]->act();
+			inject(bots[i]->next_move(), eps[i]);
+		}
+		asio::post(world.state_strand(), [&world] { world.tick(); });
+		pump();
+		if (t == 0)
+			for (auto& w : watchers)
+				w->send("REQ_WATCH_ROOM roomId=r000001"); // 첫 REQ_CREATE_ROOM 이 만든 방
+		// PING 에 PONG. 봇 10명 중 1명은 손실 많은 링크 (30% 를 버린다)
+		for (auto& [ep, ping] : st.pings)
+		{
+			uint32_t bot = ep.address().to_v4().to_uint() - 0x0A000000u;
+			if (bot % 10 == 9 && rng() % 100 < 30)
+				continue;
+			inject("PONG seq=" + net::kvparse(ping.substr(5))["seq"], ep);
+		}
+		st.pings.clear();
+
+		since_sweep += tick_ms_;
+		if (since_sweep >= 1000)
+		{
+			since_sweep -= 1000;
+			// 위조 토큰과 만료된 토큰을 번갈아 넣어서 거절 경로를 돌린다
+			for (int k = 0; k < stray_; k++, stray_seq++)
+			{
+				string tok = udptoken::mint(udptoken::kDevKey, "ghost", 1, clock.unix_ms() - 1, stray_seq);
+				if (stray_seq % 2 == 0)
+					tok.back() = tok.back() == '0' ? '1' : '0';
+				udp::endpoint ep(asio::ip::address_v4(0x0B000000u + uint32_t(stray_seq % 65536)), 30000);
+				inject("HELLO token=" + tok + " actor=ghost", ep);
+			}
+			asio::post(world.state_strand(), [&world] { world.sweep(); });
+		}
+		pump();
+		if (t == 100)
+			heap0 = net::HandlerMemory::heap().get(); // 워밍업 이후 기준점
+	}
+
+	double wall = chrono::duration<double>(chrono::steady_clock::now() - wall0).count();
+
+	// 마지막 확인: 한 명만 한 번 움직이고 월드가 멈춘다. 주기가 늘어난 (나쁜 링크) 클라이언트도
+	// 자기 차례가 오면 그 위치를 받아야 한다 (idle tick 에도 due 까지는 간다)
+	string last_move = bots[0]->step(st.probe_x, st.probe_y);
+	st.probe = "ACTOR_POS id=" + bots[0]->id() + " ";
+	for (int k = 0; k < 6000 / tick_ms_; k++)
+	{
+		clock.advance(chrono::milliseconds(tick_ms_));
+		if (k == 0)
+			inject(last_move, eps[0]);
+		asio::post(world.state_strand(), [&world] { world.tick(); });
+		pump();
+		st.pings.clear();
+	}
+	common::log_muted() = false;
+	double sim = (double)total_ticks * tick_ms_ / 1000.0;
+	common::log("SIM", "actors=" + to_string(actors_) + " ticks=" + to_string(total_ticks)
+		+ " sim_s=" + to_string(sim) + " wall_s=" + to_string(wall)
+		+ " speedup=" + to_string(wall > 0 ? sim / wall : 0.0));
+	common::log("SIM", "games=" + to_string(st.games) + " flips=" + to_string(st.flips)
+		+ " moves=" + to_string(st.moves) + " tcp_lines=" + to_string(st.lines)
+		+ " tcp_bytes=" + to_string(st.line_bytes));
+	common::log("SIM", "udp_packets=" + to_string(st.udp_packets) + " udp_bytes=" + to_string(st.udp_bytes)
+		+ " stray_hellos=" + to_string(stray_seq)
+		+ " hello_ok=" + to_string(stats::counter("udp.hello_ok").get())
+		+ " hello_bad=" + to_string(stats::counter("udp.hello_bad").get())
+		+ " hello_expired=" + to_string(stats::counter("udp.hello_expired").get())
+		+ " dropped=" + to_string(stats::counter("udp.drop_unknown").get() + stats::counter("udp.drop_move_rate").get()
+			+ stats::counter("udp.drop_hello_rate").get() + stats::counter("udp.drop_junk").get())
+		+ " snap_deferred=" + to_string(stats::counter("snap.deferred").get())
+		+ " link_lost=" + to_string(stats::counter("link.lost").get())
+		+ " link_degraded=" + to_string(stats::counter("link.degraded").get())
+		+ " link_improved=" + to_string(stats::counter("link.improved").get()));
+	common::log("SIM", "snap_encoded=" + to_string(stats::counter("snap.encoded").get())
+		+ " snap_cached=" + to_string(stats::counter("snap.cached").get())
+		+ " snap_idle_ticks=" + to_string(stats::counter("snap.idle_ticks").get())
+		+ " encode_us.p99=" + to_string(stats::histogram("snap.encode_us").percentile(0.99))
+		+ " tick_bytes.p50=" + to_string(stats::histogram("snap.tick_bytes").percentile(0.50)));
+	common::log("SIM", "lobby_deltas=" + to_string(stats::counter("lobby.deltas").get())
+		+ " lobby_batches=" + to_string(stats::counter("lobby.batches").get())
+		+ " lobby_sent=" + to_string(stats::counter("lobby.sent").get()));
+	common::log("SIM", "watch_joined=" + to_string(stats::counter("watch.joined").get())
+		+ " watch_rejected=" + to_string(stats::counter("watch.rejected").get())
+		+ " watch_batches=" + to_string(stats::counter("watch.batches").get())
+		+ " watch_sent=" + to_string(stats::counter("watch.sent").get())
+		+ " watch_us.p99=" + to_string(stats::histogram("tick.watch_us").percentile(0.99)));
+	common::log("SIM", "tick_work_us.p99=" + to_string(stats::histogram("tick.work_us").percentile(0.99))
+		+ " snapshot_us.p99=" + to_string(stats::histogram("tick.snapshot_us").percentile(0.99))
+		+ " heartbeat_us.p99=" + to_string(stats::histogram("tick.heartbeat_us").percentile(0.99))
+		+ " over_budget=" + to_string(stats::counter("tick.over_budget").get()));
+	common::log("SIM", "handler_heap_steady=" + to_string(net::HandlerMemory::heap().get() - heap0)
+		+ " handler_recycled=" + to_string(net::HandlerMemory::recycled().get()));
+	size_t settled = 0;
+	for (const auto& ep : eps)
+		settled += st.probe_got.count(ep);
+	common::log("SIM", "idle_settle=" + to_string(settled) + "/" + to_string(eps.size()));
+	if (settled != eps.size())
+	{
+		common::log("SIM", "FAIL clients missed the last position after the world went idle");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+// 소켓 없이 World 를 메모리 세션 + 가상 시계로 구동하는 시뮬레이션 하네스
+// 사용: world_server sim actors=200 seconds=3600 tick_ms=100 stray=20 miss=20 lobby=0 watchers=0 log=0
+//       (udp_*, snap_* 는 월드 옵션 그대로 넘긴다)
+//       끝에 한 명만 한 번 움직이고 멈춘 뒤 모두가 그 위치를 받았는지 본다 (idle_settle, 못 받으면 실패 1)
+//       actors=10 snap_repeat=0 snap_hz_min=1 처럼 나쁜 링크 주기가 길 때가 빡빡한 경우
+class Simulation
+{
+public:
+    explicit Simulation(const unordered_map<string, string>& opts);
+
+    int run();
+
+private:
+    int actors_;     // 봇 수 (2명당 방 1개)
+    int seconds_;    // 시뮬레이션할 가상 시간
+    int tick_ms_;
+    int stray_;      // 초당 넣는 위조/만료 토큰 UDP HELLO 수 (거절 경로 검증용)
+    int miss_pct_;   // 짝이 안 맞는 카드를 뒤집을 확률(%)
+    int lobby_;      // 로비도 구독하는 봇 수 (앞에서부터)
+    int watchers_;   // 첫 방을 관전하는 세션 수 (room_watchers 를 넘으면 거절된다)
+    int seed_;
+    bool verbose_;   // 월드 로그 출력 여부 (기본 끔)
+    unordered_map<string, string> opts_; // 월드 옵션
+};
@@ -0,0 +1,134 @@
+#include "SnapshotBench.hpp"
+#include "ActorStore.hpp"
+#include "SnapshotKernels.hpp"
+#include "../common/common.hpp"
+#include <chrono>
+#include <random>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+	struct Timer
+	{
+		chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+		double us() const { return chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count(); }
+	};
+}
+
+SnapshotBench::SnapshotBench(const unordered_map<string, string>& opts)
+	: actors_(opts.count("actors") ? opts.at("actors") : "10000,100000")
+	, ticks_(max(1, common::opt_int(opts, "ticks", 200)))
+	, moving_(min(100, max(0, common::opt_int(opts, "moving", 10))))
+{
+}
+
+int SnapshotBench::run()
+{
+	common::log("BENCH", string("cpu best=") + simd::name(simd::detect()));
+	stringstream ss(actors_);
+	string tok;
+	while (getline(ss, tok, ','))
+		run_one(max(1, common::to_int(tok.c_str(), 10000)));
+	return 0;
+}
+
+void SnapshotBench::run_one(int actors)
+{
+	mt19937 rng(1);
+	uniform_real_distribution<float> pos(-1000.f, 1000.f), step(-1.f, 1.f);
+
+	// 예전 저장소 흉내 (이름 -> 위치 map 을 tick 마다 vector<pair<string, ..>> 로 복사)
+	struct Legacy { float x, y; uint32_t seq; };
+	unordered_map<string, Legacy> legacy;
+	ActorStore store;
+	for (int i = 0; i < actors; i++)
+	{
+		string name = "actor" + to_string(i);
+		uint32_t s = store.add(name);
+		store.move(s, pos(rng), pos(rng));
+		legacy[name] = { store.x(s), store.y(s), 0 };
+	}
+
+	ActorSnapshot reused;
+	vector<pair<string, Legacy>> legacy_out;
+	vector<int32_t> qx, qy, px(actors, 0), py(actors, 0);
+	vector<uint8_t> changed(actors);
+	vector<int32_t> check_qx, check_qy; // 스칼라 결과 (AVX2 와 비교)
+	vector<uint8_t> check_changed;
+
+	double t_legacy = 0, t_fresh = 0, t_reused = 0;
+	double t_quant[2] = { 0, 0 }, t_diff[2] = { 0, 0 };
+	size_t changed_sum = 0;
+	bool mismatch = false;
+	simd::Level levels[2] = { simd::Level::Scalar, simd::detect() };
+	int nlevels = levels[1] == simd::Level::Scalar ? 1 : 2;
+	int n_move = int(int64_t(actors) * moving_ / 100);
+	uniform_int_distribution<int> pick(0, actors - 1);
+
+	for (int t = 0; t < ticks_; t++)
+	{
+		for (int k = 0; k < n_move; k++)
+		{
+			uint32_t s = uint32_t(pick(rng));
+			store.move(s, store.x(s) + step(rng), store.y(s) + step(rng));
+		}
+
+		{
+			Timer tm;
+			legacy_out.clear();
+			legacy_out.reserve(legacy.size());
+			for (const auto& kv : legacy)
+				legacy_out.emplace_back(kv.first, kv.second);
+			t_legacy += tm.us();
+		}
+		{
+			Timer tm;
+			ActorSnapshot fresh;
+			store.snapshot(fresh);
+			t_fresh += tm.us();
+		}
+		{
+			Timer tm;
+			store.snapshot(reused);
+			t_reused += tm.us();
+		}
+
+		for (int li = 0; li < nlevels; li++)
+		{
+			simd::set_level(simd::name(levels[li]));
+			qx.assign(actors, 0);
+			qy.assign(actors, 0);
+			Timer tq;
+			simd::quantize(reused.x.data(), qx.data(), size_t(actors), 10000.f, 100.f);
+			simd::quantize(reused.y.data(), qy.data(), size_t(actors), 10000.f, 100.f);
+			t_quant[li] += tq.us();
+			Timer td;
+			size_t c = simd::diff(qx.data(), qy.data(), px.data(), py.data(), changed.data(), size_t(actors));
+			t_diff[li] += td.us();
+			if (li == 0)
+			{
+				changed_sum += c;
+				check_qx = qx;
+				check_qy = qy;
+				check_changed = changed;
+			}
+			else if (qx != check_qx || qy != check_qy || changed != check_changed)
+				mismatch = true;
+		}
+		swap(px, qx);
+		swap(py, qy);
+	}
+	simd::set_level("auto");
+
+	auto per = [&](double us) { return to_string(us / ticks_); };
+	common::log("BENCH", "actors=" + to_string(actors) + " ticks=" + to_string(ticks_) + " moving=" + to_string(moving_) + "%"
+		+ " changed/tick=" + to_string(changed_sum / size_t(ticks_)));
+	common::log("BENCH", "copy us/tick legacy_map=" + per(t_legacy) + " soa_fresh=" + per(t_fresh) + " soa_reused=" + per(t_reused));
+	for (int li = 0; li < nlevels; li++)
+		common::log("BENCH", string("kernels=") + simd::name(levels[li]) + " us/tick quantize=" + per(t_quant[li]) + " diff=" + per(t_diff[li]));
+	if (nlevels > 1)
+		common::log("BENCH", mismatch ? "MISMATCH scalar != avx2" : "scalar == avx2");
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+// 스냅샷 단계 측정: actor 저장소 복사 (예전 map -> vector<pair<string, ..>> 대비)
+// 와 양자화/비교 커널 (스칼라 vs AVX2). 두 커널 결과가 같은지도 확인한다
+// 사용: world_server snapbench actors=10000,100000 ticks=200 moving=10
+class SnapshotBench
+{
+public:
+    explicit SnapshotBench(const unordered_map<string, string>& opts);
+
+    int run();
+
+private:
+    void run_one(int actors);
+
+    string actors_;  // 쉼표로 나눈 actor 수 목록
+    int ticks_;
+    int moving_;     // tick 마다 움직이는 actor 비율 (%)
+};
@@ -0,0 +1,140 @@
+#include "SnapshotKernels.hpp"
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CF_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define CF_TARGET_AVX2
+#else
+#define CF_TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#endif
+#endif
+
+using namespace std;
+
+namespace simd
+{
+    namespace
+    {
+        Level g_level = detect();
+
+        size_t quantize_scalar(const float* v, int32_t* q, size_t n, float bound, float scale)
+        {
+            size_t clamped = 0;
+            for (size_t i = 0; i < n; i++)
+            {
+                // max(v, -bound) 꼴은 NaN 이면 -bound (AVX2 max/min 과 같은 순서)
+                float c = v[i] > -bound ? v[i] : -bound;
+                c = c < bound ? c : bound;
+                clamped += !(c == v[i]);
+                q[i] = int32_t(lrintf(c * scale));
+            }
+            return clamped;
+        }
+
+        size_t diff_scalar(const int32_t* qx, const int32_t* qy, const int32_t* px, const int32_t* py, uint8_t* changed, size_t n)
+        {
+            size_t count = 0;
+            for (size_t i = 0; i < n; i++)
+            {
+                changed[i] = uint8_t((qx[i] != px[i]) | (qy[i] != py[i]));
+                count += changed[i];
+            }
+            return count;
+        }
+
+#if CF_SIMD_X86
+        CF_TARGET_AVX2 size_t quantize_avx2(const float* v, int32_t* q, size_t n, float bound, float scale)
+        {
+            const __m256 hi = _mm256_set1_ps(bound);
+            const __m256 lo = _mm256_set1_ps(-bound);
+            const __m256 k = _mm256_set1_ps(scale);
+            size_t clamped = 0, i = 0;
+            for (; i + 8 <= n; i += 8)
+            {
+                __m256 x = _mm256_loadu_ps(v + i);
+                // max(x, lo): x 가 NaN 이면 두 번째 인자 lo
+                __m256 c = _mm256_min_ps(_mm256_max_ps(x, lo), hi);
+                clamped += size_t(_mm_popcnt_u32(unsigned(_mm256_movemask_ps(_mm256_cmp_ps(c, x, _CMP_NEQ_UQ)))));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(q + i), _mm256_cvtps_epi32(_mm256_mul_ps(c, k)));
+            }
+            return clamped + quantize_scalar(v + i, q + i, n - i, bound, scale);
+        }
+
+        CF_TARGET_AVX2 size_t diff_avx2(const int32_t* qx, const int32_t* qy, const int32_t* px, const int32_t* py, uint8_t* changed, size_t n)
+        {
+            size_t count = 0, i = 0;
+            for (; i + 8 <= n; i += 8)
+            {
+                __m256i ex = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(qx + i)),
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(px + i)));
+                __m256i ey = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(qy + i)),
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(py + i)));
+                unsigned same = unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(ex, ey))));
+                unsigned diffm = ~same & 0xFFu;
+                count += size_t(_mm_popcnt_u32(diffm));
+                for (int b = 0; b < 8; b++)
+                    changed[i + b] = uint8_t(diffm >> b & 1u);
+            }
+            return count + diff_scalar(qx + i, qy + i, px + i, py + i, changed + i, n - i);
+        }
+#endif
+    }
+
+    Level detect()
+    {
+#if CF_SIMD_X86
+#if defined(_MSC_VER)
+        int r[4];
+        __cpuid(r, 1);
+        bool os_avx = (r[2] & (1 << 27)) && (r[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+        __cpuidex(r, 7, 0);
+        if (os_avx && (r[1] & (1 << 5)))
+            return Level::Avx2;
+#else
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+            return Level::Avx2;
+#endif
+#endif
+        return Level::Scalar;
+    }
+
+    Level level() { return g_level; }
+
+    void set_level(const string& name)
+    {
+        Level best = detect();
+        if (name == "scalar")
+            g_level = Level::Scalar;
+        else if (name == "avx2" && best == Level::Avx2)
+            g_level = Level::Avx2;
+        else
+            g_level = best;
+    }
+
+    const char* name(Level l)
+    {
+        return l == Level::Avx2 ? "avx2" : "scalar";
+    }
+
+    size_t quantize(const float* v, int32_t* q, size_t n, float bound, float scale)
+    {
+#if CF_SIMD_X86
+        if (g_level == Level::Avx2)
+            return quantize_avx2(v, q, n, bound, scale);
+#endif
+        return quantize_scalar(v, q, n, bound, scale);
+    }
+
+    size_t diff(const int32_t* qx, const int32_t* qy, const int32_t* px, const int32_t* py, uint8_t* changed, size_t n)
+    {
+#if CF_SIMD_X86
+        if (g_level == Level::Avx2)
+            return diff_avx2(qx, qy, px, py, changed, n);
+#endif
+        return diff_scalar(qx, qy, px, py, changed, n);
+    }
+}
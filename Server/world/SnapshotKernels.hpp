@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+// 스냅샷 단계의 배열 커널 (양자화 + 범위 자르기, 지난 tick 과 비교)
+// x86 에서 AVX2 가 되면 AVX2, 아니면 스칼라. 시작할 때 CPU 를 보고 정하고 simd= 옵션으로 바꿀 수 있다
+// 두 구현은 결과가 같다 (반올림은 둘 다 가장 가까운 짝수, NaN 은 -bound 로)
+namespace simd
+{
+    enum class Level
+    {
+        Scalar,
+        Avx2,
+    };
+
+    Level detect();
+    Level level();
+    // "scalar" / "avx2" / "auto"(기본). CPU 가 못 하는 수준이면 detect() 결과로
+    void set_level(const string& name);
+    const char* name(Level l);
+
+    // q[i] = round(clamp(v[i], -bound, bound) * scale). 잘린(또는 NaN) 개수를 돌려준다
+    size_t quantize(const float* v, int32_t* q, size_t n, float bound, float scale);
+
+    // changed[i] = (qx, qy) 가 (px, py) 와 다르면 1. 바뀐 개수를 돌려준다
+    size_t diff(const int32_t* qx, const int32_t* qy, const int32_t* px, const int32_t* py, uint8_t* changed, size_t n);
+}
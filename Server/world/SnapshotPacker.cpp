@@ -0,0 +1,223 @@
+#include "SnapshotPacker.hpp"
+#include "SnapshotKernels.hpp"
+#include "UdpTransport.hpp"
+#include "../common/stats.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <memory>
+
+using namespace std;
+using udp = asio::ip::udp;
+
+namespace
+{
+    // 양자화 값 q 를 소수점 아래 자리수 고정으로 (scale 100 -> "-12.05"). scale 은 10 의 거듭제곱 (set_snapshot_limits 에서 맞춘다)
+    void append_fixed(string& out, int32_t q, int32_t scale)
+    {
+        char buf[24];
+        char* p = buf;
+        uint32_t u = q < 0 ? uint32_t(-int64_t(q)) : uint32_t(q);
+        if (q < 0)
+            *p++ = '-';
+        p = to_chars(p, buf + sizeof(buf), u / uint32_t(scale)).ptr;
+        if (scale > 1)
+        {
+            *p++ = '.';
+            uint32_t frac = u % uint32_t(scale);
+            for (uint32_t d = uint32_t(scale) / 10; d > 0; d /= 10)
+            {
+                *p++ = char('0' + frac / d);
+                frac %= d;
+            }
+        }
+        out.append(buf, p);
+    }
+}
+
+void SnapshotPacker::pack(const SnapshotFrame& f, UdpTransport& udp)
+{
+    static auto& idle = stats::counter("snap.idle_ticks");
+    static auto& encode_us = stats::histogram("snap.encode_us");
+    static auto& tick_bytes = stats::histogram("snap.tick_bytes");
+
+    const auto& snap = f.actors;
+    const auto& clients = *f.clients;
+    links_.tick(clients, f.now_ms, udp);
+
+    // 아무도 안 움직였고 들고나지 않았고 더 보낼 게 남은 클라이언트도 없으면 할 일이 없다
+    bool pending = false;
+    for (const auto& kv : views_)
+        pending = pending || kv.second.pending > 0;
+    if (!pending && snap.epoch == epoch_ && f.clients_version == clients_version_)
+    {
+        idle.add();
+        return;
+    }
+    epoch_ = snap.epoch;
+    clients_version_ = f.clients_version;
+
+    auto t0 = chrono::steady_clock::now();
+    tick_++;
+    quantize(snap);
+    encode(snap);
+    header_ = "SNAP t=" + to_string(f.now_ms) + "\n";
+
+    size_t sent = 0;
+    for (const auto& c : clients)
+    {
+        auto& v = views_[c.first];
+        v.tick = tick_;
+        if (tick_ < v.due)
+        {
+            // 이번 변화를 아직 못 받았다. 월드가 멈춰도 due 까지는 tick 을 넘긴다
+            v.pending = max<size_t>(v.pending, 1);
+            continue;
+        }
+        auto r = links_.rate(c.first);
+        v.due = tick_ + uint64_t(r.every);
+        sent += pack_one(v, c.second, snap, r.budget, c.first, udp);
+    }
+
+    // 이번 tick 에 없던 클라이언트는 잊는다
+    for (auto it = views_.begin(); it != views_.end(); )
+        it = (it->second.tick != tick_) ? views_.erase(it) : next(it);
+
+    encode_us.record_since(t0);
+    tick_bytes.record(int64_t(sent));
+}
+
+// 움직였거나 slot 주인이 바뀐 actor 만 ACTOR_POS 줄을 다시 만든다
+void SnapshotPacker::encode(const ActorSnapshot& snap)
+{
+    static auto& encoded = stats::counter("snap.encoded");
+    static auto& cached = stats::counter("snap.cached");
+
+    int32_t scale = int32_t(limits_.scale);
+    line_gen_.resize(snap.slots, 0);
+    line_ver_.resize(snap.slots, 0);
+    size_t n = 0;
+    for (uint32_t s : live_)
+    {
+        if (line_gen_[s] == snap.gen[s] && line_ver_[s] == snap.ver[s])
+            continue;
+        line_gen_[s] = snap.gen[s];
+        line_ver_[s] = snap.ver[s];
+        n++;
+        auto& line = lines_[s];
+        line.clear();
+        line += "ACTOR_POS id=";
+        line += snap.names[s];
+        line += " x=";
+        append_fixed(line, qx_[s], scale);
+        line += " y=";
+        append_fixed(line, qy_[s], scale);
+        line += '\n';
+    }
+    encoded.add(int64_t(n));
+    cached.add(int64_t(live_.size() - n));
+}
+
+// 범위 자르기 + 양자화 + 지난 tick 과 비교 (slot 배열 전체를 SIMD 로)
+void SnapshotPacker::quantize(const ActorSnapshot& snap)
+{
+    static auto& clamped = stats::counter("snap.clamped");
+    static auto& moved = stats::counter("snap.changed");
+
+    size_t n = snap.slots;
+    swap(qx_, px_);
+    swap(qy_, py_);
+    qx_.resize(n);
+    qy_.resize(n);
+    px_.resize(n, 0);
+    py_.resize(n, 0);
+    changed_.resize(n);
+    lines_.resize(n);
+
+    size_t c = simd::quantize(snap.x.data(), qx_.data(), n, limits_.bound, limits_.scale)
+        + simd::quantize(snap.y.data(), qy_.data(), n, limits_.bound, limits_.scale);
+    size_t d = simd::diff(qx_.data(), qy_.data(), px_.data(), py_.data(), changed_.data(), n);
+
+    live_.clear();
+    for (size_t s = 0; s < n; s++)
+        if (snap.live[s])
+            live_.push_back(uint32_t(s));
+    clamped.add(int64_t(c));
+    moved.add(int64_t(d));
+}
+
+size_t SnapshotPacker::pack_one(View& v, uint32_t self, const ActorSnapshot& snap, size_t budget,
+    const udp::endpoint& ep, UdpTransport& udp)
+{
+    static auto& packets = stats::counter("snap.packets");
+    static auto& bytes = stats::counter("snap.bytes");
+    static auto& deferred = stats::counter("snap.deferred");
+
+    if (v.seen.size() < snap.slots)
+        v.seen.resize(snap.slots);
+
+    // 이 클라이언트 actor 의 위치 (아직 없으면 거리는 따지지 않는다)
+    bool has_self = self < snap.slots && snap.live[self];
+    float mx = has_self ? snap.x[self] : 0.f, my = has_self ? snap.y[self] : 0.f;
+
+    order_.clear();
+    for (uint32_t s : live_)
+    {
+        auto& e = v.seen[s];
+        if (e.gen != snap.gen[s])
+            e = Seen{ snap.gen[s] };
+        bool moved = !e.sent || qx_[s] != e.qx || qy_[s] != e.qy;
+        if (!moved && e.repeat == 0)
+            continue; // 이 클라이언트는 이미 지금 위치를 (충분히) 받았다
+        float d = has_self ? hypot(snap.x[s] - mx, snap.y[s] - my) : 0.f;
+        // 기본 1 (안 움직여도 가끔은 다시 보내서 잃은 패킷을 메운다) + 움직임 + 지금 움직이는 중 + 가까움
+        e.prio += 1.f + (moved ? 4.f : 0.f) + (changed_[s] ? 2.f : 0.f) + 8.f / (1.f + d);
+        order_.emplace_back(e.prio, s);
+    }
+    sort(order_.begin(), order_.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    size_t left = budget, total = 0, repeats = 0;
+    string pkt;
+    auto flush = [&]
+        {
+            if (pkt.empty())
+                return;
+            packets.add();
+            bytes.add(int64_t(pkt.size()));
+            total += pkt.size();
+            udp.send_to(make_shared<const string>(move(pkt)), ep);
+            pkt = string();
+        };
+    size_t n = 0;
+    for (; n < order_.size(); n++)
+    {
+        uint32_t s = order_[n].second;
+        const string& line = lines_[s];
+        if (!pkt.empty() && pkt.size() + line.size() > limits_.mtu)
+            flush();
+        size_t need = line.size() + (pkt.empty() ? header_.size() : 0);
+        // 첫 줄은 budget 과 상관없이 보낸다 (가장 급한 actor 는 매 주기 하나씩이라도 따라잡는다)
+        if (need > left && n > 0)
+            break;
+        if (pkt.empty())
+        {
+            pkt.reserve(limits_.mtu);
+            pkt = header_;
+        }
+        pkt += line;
+        left -= min(need, left);
+        auto& e = v.seen[s];
+        bool moved = !e.sent || qx_[s] != e.qx || qy_[s] != e.qy;
+        e.repeat = moved ? uint8_t(limits_.repeat) : uint8_t(e.repeat - 1);
+        repeats += e.repeat > 0;
+        e.prio = 0;
+        e.sent = true;
+        e.qx = qx_[s];
+        e.qy = qy_[s];
+    }
+    flush();
+    deferred.add(int64_t(order_.size() - n));
+    v.pending = order_.size() - n + repeats;
+    return total;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <asio.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ActorStore.hpp"
+#include "LinkMonitor.hpp"
+#include "UdpSessionManager.hpp"
+
+using namespace std;
+
+class UdpTransport;
+
+// state 가 채워서 TripleBuffer 로 넘기는 한 tick (버퍼는 돌려 쓴다)
+struct SnapshotFrame
+{
+    ActorSnapshot actors;
+    // (endpoint, actor slot). 붙고 떨어질 때만 새로 만들고 그 사이에는 같은 목록을 같이 쓴다
+    shared_ptr<const vector<pair<asio::ip::udp::endpoint, uint32_t>>> clients;
+    uint64_t clients_version = 0;
+    int64_t now_ms = 0;
+};
+
+// tick 마다 ACTOR_POS 스냅샷을 클라이언트별 UDP 패킷으로 나눈다
+//  - 위치는 SIMD 커널로 범위를 자르고 1/scale 단위로 양자화해서 지난 tick 과 비교한다
+//  - ACTOR_POS 줄은 slot 마다 캐시해 두고 움직인 (버전이 바뀐) actor 만 다시 만든다
+//  - 클라이언트에게는 지난번 보낸 뒤 바뀐 actor 만 보낸다 (멈춘 뒤 repeat 번 더 보내서 잃은 패킷을 메운다)
+//    아무도 안 움직이고 들고나지 않으면 아무것도 보내지 않는다
+//  - 패킷은 MTU 이하, 줄 단위로 끊으므로 패킷 하나만 받아도 해석된다 (IP 조각 없음)
+//    패킷마다 첫 줄 "SNAP t=<서버 ms>" (PING 으로 맞춘 시계 차이와 함께 보간에 쓴다)
+//  - 클라이언트마다 보내는 주기와 바이트 budget 은 LinkMonitor 가 링크 품질로 정한다
+//    넘치는 actor 는 다음 차례로 미룬다
+//  - 보낼 actor 마다 우선순위를 쌓는다: 가까울수록, 지난번 보낸 뒤 움직였을수록 빨리 쌓이고 보내면 0
+//    그래서 먼 actor 도 굶지 않고 몇 tick 뒤에는 나간다
+// strand_tx 에서만 호출된다
+class SnapshotPacker
+{
+public:
+    struct Limits
+    {
+        size_t mtu = 1200;      // snap_mtu=   패킷 payload 최대 (IP/UDP 헤더와 터널 여유를 뺀 값)
+        float bound = 10000.f;  // snap_bound= 좌표 범위 (넘으면 잘라서 보낸다)
+        float scale = 100.f;    // snap_scale= 양자화 단위의 역수 (100 = 0.01). 10 의 거듭제곱
+        int repeat = 2;         // snap_repeat= 멈춘 actor 의 마지막 위치를 몇 번 더 보내나
+    };
+
+    void set_limits(const Limits& l) { limits_ = l; }
+    LinkMonitor& links() { return links_; }
+
+    void pack(const SnapshotFrame& f, UdpTransport& udp);
+
+private:
+    // 클라이언트가 본 actor 하나 (slot 으로 인덱스)
+    struct Seen
+    {
+        uint32_t gen = 0;   // slot 세대가 다르면 다른 actor 였다
+        bool sent = false;
+        uint8_t repeat = 0; // 같은 위치를 더 보낼 횟수
+        float prio = 0;
+        int32_t qx = 0, qy = 0; // 마지막으로 보낸 (양자화한) 위치
+    };
+    struct View
+    {
+        vector<Seen> seen;
+        uint64_t tick = 0;
+        uint64_t due = 0;   // 다음에 보낼 tick
+        size_t pending = 1; // 지난번에 다 못 보냈거나 더 보낼 게 남은 actor 수
+    };
+
+    void quantize(const ActorSnapshot& snap);
+    void encode(const ActorSnapshot& snap);
+    // 보낸 바이트
+    size_t pack_one(View& v, uint32_t self, const ActorSnapshot& snap, size_t budget,
+        const asio::ip::udp::endpoint& ep, UdpTransport& udp);
+
+    Limits limits_;
+    LinkMonitor links_;
+    uint64_t tick_ = 0;
+    uint64_t epoch_ = ~0ull;            // 마지막으로 처리한 저장소 epoch
+    uint64_t clients_version_ = ~0ull;
+    string header_; // 이번 tick 의 "SNAP t=..\n"
+
+    // slot 인덱스 배열: 이번/지난 tick 양자화 위치, 이번 tick 에 바뀐 slot, ACTOR_POS 줄
+    vector<int32_t> qx_, qy_, px_, py_;
+    vector<uint8_t> changed_;
+    vector<string> lines_;
+    vector<uint32_t> line_gen_, line_ver_; // lines_[s] 를 만든 slot 세대/위치 버전
+    vector<uint32_t> live_;               // 살아 있는 slot 목록
+    vector<pair<float, uint32_t>> order_; // (우선순위, slot)
+
+    unordered_map<asio::ip::udp::endpoint, View, UdpEndpointHash> views_;
+};
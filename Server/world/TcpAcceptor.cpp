@@ -3,6 +3,8 @@
 #include "../common/common.hpp"
 #include "../common/net.hpp"
 #include "../common/protocol.hpp"
+#include "../common/admission.hpp"
+#include "../common/stats.hpp"
 #include "TcpSession.hpp"
 #include <asio.hpp>
 #include <sstream>
@@ -12,19 +14,62 @@
 using asio::ip::tcp;
 using namespace std;
 
-TcpAcceptor::TcpAcceptor(asio::io_context& io, unsigned short port, World& world)
-    : acc_(io, tcp::endpoint(tcp::v4(), port)), world_(world)
+TcpAcceptor::TcpAcceptor(asio::io_context& io, unsigned short port, World& world, net::IoPool* pool)
+    : acc_(io, tcp::endpoint(tcp::v4(), port)), pace_(io), world_(world), io_pool_(pool)
 {
+    int n = io_pool_ ? io_pool_->size() : 1;
+    for (int i = 0; i < n; i++)
+        pools_.emplace_back("tcp_session");
     accept();
     common::log("WORLD", "control listen TCP " + to_string(port));
 }
 
 void TcpAcceptor::accept()
 {
-    acc_.async_accept([this](error_code ec, tcp::socket s)
+    // 초당 accept 수 제한: 토큰이 없으면 받지 않고 커널 backlog 에 둔다
+    static auto& paced = stats::counter("adm.accept_paced");
+    auto wait = net::admission().accept.wait();
+    if (wait.count() > 0)
+    {
+        paced.add();
+        pace_.expires_after(wait);
+        pace_.async_wait([this](error_code) { accept(); });
+        return;
+    }
+    net::admission().accept.try_take();
+
+    if (!io_pool_)
+    {
+        acc_.async_accept([this](error_code ec, tcp::socket s)
+            {
+                // 동시 연결 상한이면 재시도 시각만 알리고 끊는다 (아무것도 안 보내는 연결도 센다)
+                if (!ec && !net::admission().enter())
+                    net::reject_busy(s);
+                else if (!ec)
+                {
+                    pools_[0].acquire(
+                        [&] { return new TcpSession(move(s), world_); },
+                        [&](TcpSession& t) { t.reset(move(s)); }
+                    )->start();
+                }
+                accept();
+            });
+        return;
+    }
+
+    // 소켓을 처음부터 배정된 코어의 io_context 에 만들어서 받는다
+    int core = io_pool_->pick();
+    acc_.async_accept(io_pool_->io(core), [this, core](error_code ec, tcp::socket s)
         {
-            if (!ec) 
-                make_shared<TcpSession>(move(s), world_)->start();
+            if (!ec && !net::admission().enter())
+                net::reject_busy(s);
+            else if (!ec)
+            {
+                pools_[core].acquire(
+                    [&] { return new TcpSession(move(s), world_, io_pool_, core); },
+                    [&](TcpSession& t) { t.reset(move(s)); }
+                )->start();
+            }
             accept();
         });
 }
\ No newline at end of file
@@ -1,17 +1,25 @@
 #pragma once
+#include "../common/object_pool.hpp"
+#include "../common/io_pool.hpp"
 #include <asio.hpp>
 #include <memory>
+#include <vector>
 
-struct World;
+class World;
+class TcpSession;
 
 class TcpAcceptor
 {
 public:
-    TcpAcceptor(asio::io_context& io, unsigned short port, World& world);
+    // pool 이 있으면 accept 한 소켓을 코어별 io_context 로 나눠준다
+    TcpAcceptor(asio::io_context& io, unsigned short port, World& world, net::IoPool* pool = nullptr);
 
 private:
     void accept();
 
     asio::ip::tcp::acceptor acc_;
+    asio::steady_timer pace_; // accept 토큰이 없을 때 다음 토큰까지 기다린다
     World& world_;
-};
\ No newline at end of file
+    net::IoPool* io_pool_;
+    vector<net::ObjectPool<TcpSession>> pools_; // 코어별 (공유 모드는 1개)
+};
@@ -3,6 +3,9 @@
 #include "../common/net.hpp"
 #include "../common/protocol.hpp"
 #include "../common/common.hpp"
+#include "../common/handler_alloc.hpp"
+#include "../common/stats.hpp"
+#include "../common/admission.hpp"
 #include <numeric>
 #include <asio.hpp>
 #include <istream>
@@ -13,261 +16,231 @@
 using asio::ip::tcp;
 using namespace std;
 
-TcpSession::TcpSession(tcp::socket s, World& w)
-	: sock(move(s)), world(w)
+TcpSession::TcpSession(tcp::socket s, World& w, net::IoPool* pool, int core)
+	: ControlSession(w), sock(move(s)), strand_(asio::make_strand(sock.get_executor())), pool_(pool), core_(core)
+	, buf(net::max_line())
+	, write_signal_(strand_, asio::steady_timer::time_point::max())
 {
 }
-void TcpSession::start()
+
+// 풀에서 재사용: 소켓/상태만 교체하고 버퍼와 큐 용량은 유지
+void TcpSession::reset(tcp::socket s)
 {
-	read_line();
+	sock = move(s);
+	buf.clear();
+	buf.resize(net::max_line());
+	writeQueue.clear();
+	actorId_.clear();
+	roomId_.clear();
+	closed_ = false;
+	rpc_ = false;
+	admitted_ = false;
 }
 
-void TcpSession::read_line()
+// accept 에서 동시 연결 수에 넣은 뒤에 부른다
+void TcpSession::start()
 {
-	auto self = shared_from_this();
-	asio::async_read_until(sock, buf, '\n', [this, self](error_code ec, size_t)
+	admitted_ = true;
+	if (pool_)
+	{
+		pool_->add_load(core_, 1);
+		counted_ = true;
+	}
+	auto self = static_pointer_cast<TcpSession>(shared_from_this());
+	// 핸들러가 던지면 co_spawn 이 예외를 넘겨준다. detached 로 버리면 on_close 없이 끝나 연결/슬롯이 샌다
+	auto done = [self](exception_ptr e)
 		{
-			if (ec)
-			{
-				on_close();
-				return;
-			}
-			istream is(&buf);
-			string line;
-			getline(is, line);
-			if (!line.empty() && line.back() == '\r')
-				line.pop_back();
+			if (e)
+				self->on_close();
+		};
+	asio::co_spawn(strand_, reader(self), done);
+	asio::co_spawn(strand_, writer(self), done);
+}
 
-			if (!line.empty())
-				handle(line);
+bool TcpSession::in_home() const
+{
+	return pool_ ? pool_->on_core(core_) : strand_.running_in_this_thread();
+}
 
-			read_line();
-		});
+// 세션 소유 스레드로 작업 전달 (코어별 모드: 코어 mailbox, 공유 모드: 세션 strand)
+template <class F>
+void TcpSession::post_home(F&& f)
+{
+	if (pool_)
+		pool_->post(core_, forward<F>(f));
+	else
+		asio::post(strand_, net::recycled(forward<F>(f)));
 }
 
-void TcpSession::handle(const string& line)
+asio::awaitable<void> TcpSession::reader([[maybe_unused]] shared_ptr<TcpSession> self)
 {
-	auto [cmd, kv] = net::parse_kv(line);
-	if (cmd == "HELLO")
+	static auto& too_long = stats::counter("net.input_overflow");
+	error_code ec;
+	for (;;)
 	{
-		auto it = kv.find("actor");
-		if (it == kv.end() || it->second.empty())
+		// 버퍼에 완성된 줄(게이트웨이 링크면 프레임)이 있으면 처리, 없으면 더 읽는다
+		if (rpc_)
 		{
-			write_line("ERR code=BAD_HELLO");
-			return;
+			rpc::Frame f;
+			long used = rpc::parse(buf.data(), buf.size(), f);
+			if (used < 0)
+				break;
+			if (used > 0)
+			{
+				handle_frame(f);
+				buf.consume(size_t(used));
+				continue;
+			}
 		}
-		actorId_ = it->second;
-		asio::post(world.state_strand(), [self = shared_from_this(), this]
+		else
+		{
+			string_view line;
+			if (buf.next_line(line))
 			{
-				world.bind_session(actorId_, self);
-				write_line("HELLO_OK actor=" + actorId_);
-			});
-		return;
+				if (!line.empty())
+					handle(string(line));
+				// 인증된 게이트웨이 링크는 동시 연결 상한과 무관하다 (accept 때 센 것을 돌려준다)
+				if (admitted_ && gateway_)
+				{
+					net::admission().leave();
+					admitted_ = false;
+				}
+				// GW_HELLO 뒤로는 프레임이 오므로 가장 큰 프레임이 들어갈 만큼 늘린다
+				if (rpc_)
+					buf.resize(rpc::kMaxBuffered);
+				continue;
+			}
+		}
+		if (buf.full())
+		{
+			// 줄바꿈 없이 한도를 채웠다
+			too_long.add();
+			common::log("WORLD", "input line too long, closing actor=" + actorId_);
+			break;
+		}
+		size_t n = co_await sock.async_read_some(buf.prepare(), asio::redirect_error(asio::use_awaitable, ec));
+		if (ec)
+			break;
+		buf.commit(n);
 	}
+	on_close();
+}
 
-	if (cmd == proto::GW_REGISTER_UDP_TOKEN)
+asio::awaitable<void> TcpSession::writer([[maybe_unused]] shared_ptr<TcpSession> self)
+{
+	static auto& lat = stats::histogram("lat.ctrl_write_us");
+	static constexpr size_t kMaxBatch = 64;
+	error_code ec;
+	while (!closed_)
 	{
-		string tok = kv["token"];
-		string actor = kv["actor"];
-		int ttl = kv.count("ttl") ? stoi(kv["ttl"]) : 60000;
-
-		world.register_udp_token_async(move(tok), actor, ttl);
-		static const string ok = "OK\n";
-		asio::async_write(sock, asio::buffer(ok), [](auto, auto) {});
-		auto self = shared_from_this();
-		world.bind_gateway_session(self);
-		return;
+		if (writeQueue.empty())
+		{
+			co_await write_signal_.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+			continue;
+		}
+		writeQueue.gather(batch_, kMaxBatch);
+		co_await asio::async_write(sock, batch_, asio::redirect_error(asio::use_awaitable, ec));
+		if (ec)
+		{
+			on_close();
+			break;
+		}
+		writeQueue.pop(lat);
 	}
+}
 
-	if (cmd == "REQ_CREATE_ROOM")
+void TcpSession::write_line(string s)
+{
+	// world(state) 쪽에서 부르면 세션 스레드로 넘겨서 큐를 한 스레드만 만지게 한다
+	if (!in_home())
 	{
-		string title = kv["title"];
-		int rows = stoi(kv["rows"]);
-		int cols = stoi(kv["cols"]);
-		string actor = actorId_;
-
-		asio::post(world.state_strand(), [this, self = shared_from_this(), title = move(title), rows, cols]()
-			{
-				auto roomId = world.create_room(actorId_, title, rows, cols);
-				write_line("RES_CREATE_ROOM roomId=" + roomId + " master=" + actorId_ + " title=" + title);
-				world.broadcast_create_room(roomId);
-				roomId_ = roomId;
-			});
+		post_home([this, self = shared_from_this(), s = move(s)]() mutable { write_line(move(s)); });
 		return;
 	}
-
-	if (cmd == "REQ_ENTER_ROOM")
+	if (rpc_)
 	{
-		string roomId = kv["roomId"];
-		roomId_ = roomId;
-		asio::post(world.state_strand(), [this, self = shared_from_this(), roomId = move(roomId)]()
-			{
-				if (!world.join_room(roomId, actorId_))
-				{
-					write_line("ERR code=ROOM_NOT_FOUND roomId=" + roomId);
-					return;
-				}
-				auto snap = world.snapshot(roomId);
-				world.cast_enter_room(roomId, snap);
-				world.broadcast_enter_room(roomId, snap.title);
-			});
+		// 게이트웨이 링크에는 라인 대신 이벤트 프레임으로
+		if (!s.empty() && s.back() == '\n')
+			s.pop_back();
+		string f;
+		rpc::append(f, rpc::Type::Event, 0, s);
+		enqueue(move(f));
 		return;
 	}
-	if (cmd == "REQ_CHANGE_READY")
-	{
-		string roomId = kv["roomId"];
-		bool isReady = kv["isReady"] == "True";
+	bool coalesce = proto::coalescable(s);
+	s.push_back('\n');
+	enqueue(move(s), coalesce);
+}
 
-		asio::post(world.state_strand(), [this, self = shared_from_this(), roomId = move(roomId), isReady]()
-			{
-				world.change_ready(roomId, isReady);
-				world.cast_change_ready(roomId, isReady);
-			});
-		return;
-	}
-	if (cmd == "REQ_GAME_START")
+void TcpSession::write_frame(rpc::Type t, uint32_t id, string payload)
+{
+	if (!in_home())
 	{
-		string roomId = kv["roomId"];
-		asio::post(world.state_strand(), [this, self = shared_from_this(), roomId = move(roomId)]()
-			{
-				if (world.check_ready(roomId))
-				{
-					world.game_start(roomId);
-					world.cast_game_start(roomId);
-				}
-			});
+		post_home([this, self = shared_from_this(), t, id, p = move(payload)]() mutable { write_frame(t, id, move(p)); });
 		return;
 	}
-	if (cmd == "REQ_FIRST_FLIP_END")
-	{
-		string roomId = kv["roomId"];
-		string actor = kv["actor"];
+	string f;
+	f.reserve(rpc::kHeader + payload.size());
+	rpc::append(f, t, id, payload);
+	enqueue(move(f));
+}
 
-		auto self = shared_from_this();
-		asio::post(world.state_strand(), [this, self, roomId = move(roomId), actor = move(actor)] {
-			if (world.game_peek_end(roomId, actor))
-			{
-				world.cast_game_peek_end(roomId);
-			}
-			});
-		return;
-	}
-	if (cmd == "REQ_FLIP")
+// 관전 이벤트처럼 여러 세션이 같이 쓰는 버퍼는 복사하지 않고 참조를 큐에 넣는다
+void TcpSession::write_shared(shared_ptr<const string> bytes)
+{
+	if (!in_home())
 	{
-		string roomId = kv["roomId"];
-		string actor = kv["actor"];
-		int idx = stoi(kv["index"]);
-		asio::post(world.state_strand(), [this, self = shared_from_this(), roomId = move(roomId), actor, idx]()
-			{
-				world.flip_card(roomId, actor, idx);
-				if (world.check_end_game(roomId))
-					world.cast_end_game(roomId, idx);
-				else
-					world.cast_flip_result(roomId, idx);
-			});
+		post_home([this, self = shared_from_this(), b = move(bytes)]() mutable { write_shared(move(b)); });
 		return;
 	}
-	if (cmd == "REQ_ROOM_EXIT")
+	if (rpc_)
 	{
-		string roomId = kv["roomId"];
-		string actor = kv["actor"];
-		asio::post(world.state_strand(), [this, self = shared_from_this(), roomId = move(roomId), actor]()
-			{
-				auto snap = world.snapshot(roomId);
-
-				if (snap.phase == 1)
-					world.cast_forced_end_game(roomId);
-
-				world.cast_exit_room(roomId, snap.master, actor);
-				if (world.check_exit_room_master(roomId, actor))
-				{
-					world.change_room_master(roomId);
-					world.broadcast_change_room_master(roomId);
-				}
-				else
-				{
-					world.exit_room_challenger(roomId);
-					world.broadcast_exit_room(roomId);
-				}
-
-				if (world.check_exit_room_count(roomId) == 0)
-				{
-					if (snap.master == actor)
-					{
-						world.delete_room(roomId);
-						world.broadcast_delete_room(roomId, actor);
-					}
-				}
-				roomId_ = "";
-			});
+		ControlSession::write_shared(move(bytes));
 		return;
 	}
-	if (cmd == "REQ_CHANGE_RULE")
-	{
-		string roomId = kv["roomId"];
-		string master = kv["master"];
-		int cols = stoi(kv["cols"]);
-		int rows = stoi(kv["rows"]);
-		asio::post(world.state_strand(), [this, self = shared_from_this(), roomId = move(roomId), master = move(master), cols, rows]()
-			{
-				if (world.change_rule(roomId, master, cols, rows))
-					world.cast_change_rule(roomId);
-			});
+	if (closed_)
 		return;
-	}
-	static const string err = "ERR code=UNKNOWN\n";
-	asio::async_write(sock, asio::buffer(err), [](auto, auto) {});
+	queued(writeQueue.push_shared(move(bytes), &net::write_limits()));
 }
 
-void TcpSession::write_line(string s)
+void TcpSession::enqueue(string bytes, bool coalesce)
 {
-	s.push_back('\n');
-	bool writing = !writeQueue.empty();
-	writeQueue.emplace_back(move(s));
-	if (writing) 
+	if (closed_)
 		return;
-
-	auto self = shared_from_this();
-	asio::async_write(sock, asio::buffer(writeQueue.front()), [this, self](error_code ec, size_t)
-		{
-			if (ec)
-			{
-				on_close(); 
-				return;
-			}
-			writeQueue.pop_front();
-			if (!writeQueue.empty()) 
-				write_more();
-		});
+	queued(writeQueue.push(move(bytes), coalesce, rpc_ ? nullptr : &net::write_limits()));
 }
 
-void TcpSession::write_more()
+void TcpSession::queued(net::WriteQueue::Push r)
 {
-	auto self = shared_from_this();
-	asio::async_write(sock, asio::buffer(writeQueue.front()), [this, self](error_code ec, size_t)
-		{
-			if (ec) 
-			{
-				on_close();
-				return; 
-			}
-			writeQueue.pop_front();
-			if (!writeQueue.empty())
-				write_more();
-		});
+	if (r == net::WriteQueue::Push::Overflow)
+	{
+		// 못 따라오는 클라이언트 하나가 월드 메모리를 키우지 않게 끊는다
+		common::log("WORLD", "slow consumer closed actor=" + actorId_);
+		on_close();
+		return;
+	}
+	if (r == net::WriteQueue::Push::Queued)
+		write_signal_.cancel_one();
 }
 
 void TcpSession::on_close()
 {
-	asio::post(world.state_strand(), [this, self = shared_from_this(), roomId = move(roomId_), actor = move(actorId_)]()
-		{
-			common::log("WORLD", "on_close " + actor);
-			if (actor != "")
-				world.broadcast_exit_server(actor, roomId, self.get());
-		});
+	if (closed_)
+		return;
+	closed_ = true;
+	if (counted_)
+	{
+		pool_->add_load(core_, -1);
+		counted_ = false;
+	}
+	on_disconnected();
+	if (admitted_)
+	{
+		net::admission().leave();
+		admitted_ = false;
+	}
 
 	error_code ec;
 	sock.close(ec);
+	write_signal_.cancel();
 }
-
-
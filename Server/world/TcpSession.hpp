@@ -1,33 +1,52 @@
 #pragma once
+#include "ControlSession.hpp"
+#include "../common/io_pool.hpp"
+#include "../common/write_queue.hpp"
+#include "../common/recv_buffer.hpp"
 #include <asio.hpp>
+#include <chrono>
 #include <deque>
 #include <memory>
 #include <string>
+#include <vector>
 
 using namespace std;
 
 class World; 
 
-class TcpSession : public enable_shared_from_this<TcpSession>
+class TcpSession : public ControlSession
 {
 public:
     using tcp = asio::ip::tcp;
 
-    TcpSession(tcp::socket s, World& w);
+    // pool 이 있으면 thread-per-core 모드: core 의 io_context 에서만 돈다
+    TcpSession(tcp::socket s, World& w, net::IoPool* pool = nullptr, int core = -1);
+    void reset(tcp::socket s);
     void start();
-    void write_line(string s);
+    void write_line(string s) override;
+    void write_frame(rpc::Type t, uint32_t id, string payload) override;
+    void write_shared(shared_ptr<const string> bytes) override;
     void on_close();
 
-    string actorId_="";
-    string roomId_="";
 private:
-    void read_line();
-    void handle(const string& line);
-    void write_more();
+    // 연결당 코루틴 두 개: 프레임이 self 를 들고 있어서 둘 다 끝나야 세션이 풀로 돌아간다
+    asio::awaitable<void> reader(shared_ptr<TcpSession> self);
+    asio::awaitable<void> writer(shared_ptr<TcpSession> self);
+    void enqueue(string bytes, bool coalesce = false);
+    void queued(net::WriteQueue::Push r);
+    bool in_home() const;
+    template <class F> void post_home(F&& f);
 
 private:
     tcp::socket sock;
-    asio::streambuf buf;
-    World& world;
-    deque<string> writeQueue;
-};
\ No newline at end of file
+    asio::strand<asio::any_io_executor> strand_;
+    net::IoPool* pool_;
+    int core_;
+    bool counted_ = false;
+    bool admitted_ = false; // 클라이언트로 동시 연결 수에 들어가 있다 (게이트웨이 링크는 세지 않는다)
+    bool closed_ = false;
+    net::RecvBuffer buf; // 클라이언트는 max_line, 게이트웨이 링크로 바뀌면 최대 프레임 크기
+    net::WriteQueue writeQueue; // 클라이언트 연결은 한도 적용, 게이트웨이 링크(rpc_)는 무제한
+    vector<asio::const_buffer> batch_; // 큐에 쌓인 것을 한 번의 write 로 묶는다
+    asio::steady_timer write_signal_; // writer 깨우기 용 (만료 없음, cancel 로 깨운다)
+};
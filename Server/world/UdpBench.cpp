@@ -0,0 +1,127 @@
+#include "UdpBench.hpp"
+#include "UdpTransport.hpp"
+#include "../common/common.hpp"
+#include "../common/stats.hpp"
+#include <asio.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+using asio::ip::udp;
+using namespace std;
+
+namespace
+{
+	// 현재 스레드가 쓴 CPU 시간 (초). 리눅스 외에는 0
+	double thread_cpu_s()
+	{
+#if defined(__linux__)
+		rusage ru{};
+		getrusage(RUSAGE_THREAD, &ru);
+		return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+#else
+		return 0.0;
+#endif
+	}
+}
+
+UdpBench::UdpBench(const unordered_map<string, string>& opts)
+	: backend_(opts.count("udp") ? opts.at("udp") : "asio")
+	, seconds_(max(1, common::opt_int(opts, "seconds", 5)))
+	, senders_(max(1, common::opt_int(opts, "senders", 4)))
+	, window_(max(1, common::opt_int(opts, "window", 32)))
+	, payload_(max(1, common::opt_int(opts, "payload", 600)))
+	, port_(common::opt_int(opts, "port", 9101))
+{
+}
+
+int UdpBench::run()
+{
+	asio::io_context io;
+	auto udp_t = make_udp_transport(io, static_cast<unsigned short>(port_), backend_);
+	asio::strand<UdpTransport::Executor> strand(io.get_executor());
+
+	// 1024 패킷마다 새 스냅샷으로 바꿔서 슬롯 교체 경로도 같이 돈다
+	uint64_t rx = 0;
+	auto snapshot = make_shared<const string>(payload_, 'S');
+	udp_t->start(strand, [&](const char*, size_t, const udp::endpoint& from)
+		{
+			if (++rx % 1024 == 0)
+				snapshot = make_shared<const string>(payload_, char('A' + rx / 1024 % 26));
+			udp_t->send_to(snapshot, from);
+		});
+
+	double server_cpu = 0;
+	thread server([&]
+		{
+			double c0 = thread_cpu_s();
+			io.run();
+			server_cpu = thread_cpu_s() - c0;
+		});
+
+	atomic<bool> stop{ false };
+	atomic<uint64_t> sent{ 0 }, replies{ 0 };
+	vector<thread> senders;
+	for (int i = 0; i < senders_; i++)
+	{
+		senders.emplace_back([&, i]
+			{
+				asio::io_context cio;
+				udp::socket s(cio, udp::endpoint(udp::v4(), 0));
+				s.non_blocking(true);
+				udp::endpoint to(asio::ip::make_address_v4("127.0.0.1"), static_cast<unsigned short>(port_));
+				string move_pkt = "MOVE seq=0 x=1.000000 y=2.000000 actor=bench" + to_string(i);
+				vector<char> buf(65536);
+				while (!stop.load(memory_order_relaxed))
+				{
+					for (int k = 0; k < window_; k++)
+					{
+						error_code ec;
+						s.send_to(asio::buffer(move_pkt), to, 0, ec);
+						if (!ec) sent.fetch_add(1, memory_order_relaxed);
+					}
+					// 응답을 window 만큼 받거나 5ms 가 지나면 다음 묶음
+					int got = 0;
+					auto until = chrono::steady_clock::now() + chrono::milliseconds(5);
+					while (got < window_ && chrono::steady_clock::now() < until)
+					{
+						error_code ec;
+						udp::endpoint from;
+						s.receive_from(asio::buffer(buf), from, 0, ec);
+						if (ec == asio::error::would_block)
+						{
+							this_thread::yield();
+							continue;
+						}
+						if (!ec) got++;
+					}
+					replies.fetch_add(got, memory_order_relaxed);
+				}
+			});
+	}
+
+	auto t0 = chrono::steady_clock::now();
+	this_thread::sleep_for(chrono::seconds(seconds_));
+	stop = true;
+	for (auto& t : senders)
+		t.join();
+	double wall = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+	asio::post(strand, [&] { io.stop(); });
+	server.join();
+
+	common::log("BENCH", "udp=" + backend_ + " senders=" + to_string(senders_) + " window=" + to_string(window_)
+		+ " payload=" + to_string(payload_) + " wall_s=" + to_string(wall));
+	common::log("BENCH", "sent=" + to_string(sent.load()) + " server_rx=" + to_string(rx)
+		+ " replies=" + to_string(replies.load())
+		+ " rx_pps=" + to_string(uint64_t(rx / wall))
+		+ " reply_pps=" + to_string(uint64_t(replies.load() / wall)));
+	common::log("BENCH", "server_cpu_s=" + to_string(server_cpu)
+		+ " pkts_per_cpu_ms=" + to_string(server_cpu > 0 ? (rx + replies.load()) / (server_cpu * 1000) : 0.0));
+	common::log("BENCH", "stats " + stats::dump());
+	return 0;
+}
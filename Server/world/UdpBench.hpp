@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+// UDP 백엔드 부하 측정 (asio/epoll vs io_uring)
+// 송신 스레드들이 MOVE 크기 패킷을 window 만큼씩 쏘고, 서버 쪽 transport 는 패킷마다
+// 공유 스냅샷 payload 로 답한다 (월드 브로드캐스트와 같은 send_to 경로)
+// 사용: world_server udpbench udp=uring seconds=5 senders=4 window=32 payload=600 port=9101
+class UdpBench
+{
+public:
+    explicit UdpBench(const unordered_map<string, string>& opts);
+
+    int run();
+
+private:
+    string backend_;
+    int seconds_;
+    int senders_;
+    int window_;   // 송신 스레드당 응답을 기다리기 전에 쏘는 패킷 수
+    int payload_;  // 응답(스냅샷) 크기
+    int port_;
+};
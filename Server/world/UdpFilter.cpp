@@ -0,0 +1,98 @@
+#include "UdpFilter.hpp"
+#include "../common/stats.hpp"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+using udp = asio::ip::udp;
+
+UdpFilter::UdpFilter(const WorldClock& clock, const UdpSessionManager& sessions)
+    : clock_(clock)
+    , sessions_(sessions)
+{
+}
+
+UdpFilter::Kind UdpFilter::admit(const char* data, size_t n, const udp::endpoint& from)
+{
+    static auto& junk = stats::counter("udp.drop_junk");
+    static auto& unknown = stats::counter("udp.drop_unknown");
+    static auto& move_rate = stats::counter("udp.drop_move_rate");
+    static auto& hello_rate = stats::counter("udp.drop_hello_rate");
+    static auto& hello_table = stats::counter("udp.drop_hello_table");
+
+    bool is_move = n >= 5 && memcmp(data, "MOVE ", 5) == 0;
+    if (is_move || (n >= 5 && memcmp(data, "PONG ", 5) == 0))
+    {
+        auto it = move_.find(from);
+        if (it == move_.end())
+        {
+            if (!sessions_.known(from))
+            {
+                unknown.add();
+                return Kind::Drop;
+            }
+            it = move_.emplace(from, Bucket{ double(limits_.move_burst), clock_.now() }).first;
+        }
+        if (!take(it->second, limits_.move_rate, limits_.move_burst, clock_.now()))
+        {
+            move_rate.add();
+            return Kind::Drop;
+        }
+        return is_move ? Kind::Move : Kind::Pong;
+    }
+    if (n >= 6 && memcmp(data, "HELLO ", 6) == 0)
+    {
+        uint64_t key = address_key(from.address());
+        auto it = hello_.find(key);
+        if (it == hello_.end())
+        {
+            if (hello_.size() >= limits_.hello_sources)
+            {
+                hello_table.add();
+                return Kind::Drop;
+            }
+            it = hello_.emplace(key, Bucket{ double(limits_.hello_burst), clock_.now() }).first;
+        }
+        if (!take(it->second, limits_.hello_rate, limits_.hello_burst, clock_.now()))
+        {
+            hello_rate.add();
+            return Kind::Drop;
+        }
+        return Kind::Hello;
+    }
+    junk.add();
+    return Kind::Drop;
+}
+
+void UdpFilter::sweep()
+{
+    auto now = clock_.now();
+    for (auto it = move_.begin(); it != move_.end(); )
+        it = sessions_.known(it->first) ? next(it) : move_.erase(it);
+    for (auto it = hello_.begin(); it != hello_.end(); )
+    {
+        double refilled = it->second.tokens + chrono::duration<double>(now - it->second.last).count() * limits_.hello_rate;
+        it = (refilled >= limits_.hello_burst) ? hello_.erase(it) : next(it);
+    }
+}
+
+bool UdpFilter::take(Bucket& b, double rate, double burst, WorldClock::TimePoint now)
+{
+    b.tokens = min(burst, b.tokens + chrono::duration<double>(now - b.last).count() * rate);
+    b.last = now;
+    if (b.tokens < 1)
+        return false;
+    b.tokens -= 1;
+    return true;
+}
+
+uint64_t UdpFilter::address_key(const asio::ip::address& a)
+{
+    if (a.is_v4())
+        return a.to_v4().to_uint();
+    // v6 는 /64 단위로 묶는다 (한 호스트가 보통 /64 를 받는다). 최상위 비트로 v4 와 구분
+    auto bytes = a.to_v6().to_bytes();
+    uint64_t k;
+    memcpy(&k, bytes.data(), sizeof(k));
+    return k | (uint64_t(1) << 63);
+}
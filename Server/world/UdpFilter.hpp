@@ -0,0 +1,57 @@
+#pragma once
+#include <asio.hpp>
+#include <cstdint>
+#include <unordered_map>
+#include "UdpSessionManager.hpp"
+#include "WorldClock.hpp"
+
+using namespace std;
+
+// UDP 수신 앞단 필터. 문자열 복사나 파싱 전에 앞 몇 바이트와 보낸 주소만 보고 버린다
+//  - HELLO 가 아닌데 모르는 endpoint 면 버린다
+//  - MOVE/PONG 은 endpoint 마다 토큰 버킷
+//  - HELLO 는 보낸 IP 마다 토큰 버킷 (IP 표 크기에 상한이 있다)
+// state strand 에서만 호출된다
+class UdpFilter
+{
+public:
+    struct Limits
+    {
+        int move_rate = 120;        // udp_move_rate=  endpoint 당 초당 MOVE (+PONG)
+        int move_burst = 60;        // udp_move_burst=
+        int hello_rate = 2;         // udp_hello_rate= IP 당 초당 HELLO
+        int hello_burst = 10;       // udp_hello_burst=
+        size_t hello_sources = 65536; // udp_hello_sources= 기억하는 IP 수 (넘으면 새 IP 의 HELLO 는 버린다)
+    };
+
+    enum class Kind
+    {
+        Drop,
+        Hello,
+        Move,
+        Pong,
+    };
+
+    UdpFilter(const WorldClock& clock, const UdpSessionManager& sessions);
+
+    void set_limits(const Limits& l) { limits_ = l; }
+    Kind admit(const char* data, size_t n, const asio::ip::udp::endpoint& from);
+
+    // 세션이 없어진 endpoint 와 버킷이 다시 가득 찬 (한동안 조용한) IP 를 지운다
+    void sweep();
+
+private:
+    struct Bucket
+    {
+        double tokens;
+        WorldClock::TimePoint last;
+    };
+    static bool take(Bucket& b, double rate, double burst, WorldClock::TimePoint now);
+    static uint64_t address_key(const asio::ip::address& a);
+
+    const WorldClock& clock_;
+    const UdpSessionManager& sessions_;
+    Limits limits_;
+    unordered_map<asio::ip::udp::endpoint, Bucket, UdpEndpointHash> move_; // 세션 있는 endpoint
+    unordered_map<uint64_t, Bucket> hello_;                               // IP
+};
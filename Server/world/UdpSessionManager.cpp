@@ -1,88 +1,72 @@
 #include "UdpSessionManager.hpp"
 #include "../common/common.hpp"
+#include "../common/stats.hpp"
+#include "../common/udp_token.hpp"
 
 using namespace std;
 using udp = asio::ip::udp;
-using Clock = chrono::steady_clock;
 
-UdpSessionManager::UdpSessionManager(asio::strand<Executor>& strand)
-    : strand_(strand)
+UdpSessionManager::UdpSessionManager(const WorldClock& clock, string key, int world_id)
+    : clock_(clock)
+    , key_(move(key))
+    , world_id_(world_id)
 {
 }
 
-void UdpSessionManager::register_udp_token_async(string token, string actor, int ttl_ms)
-{
-    asio::post(strand_, [this, token = move(token), actor, ttl_ms]
-        {
-            token_table_[token] = { actor, Clock::now() + chrono::milliseconds(ttl_ms) };
-            common::log("WORLD", "REGISTER token=" + token + " actor=" + actor);
-        });
-}
-
 bool UdpSessionManager::on_udp_hello(const string& tok,  string actor, const udp::endpoint& ep)
 {
-    auto it = token_table_.find(tok);
-    if (it == token_table_.end()) return false;
-    if (it->second.actor.compare(actor)) return false;
-    if (it->second.expires < Clock::now()) 
+    static auto& ok = stats::counter("udp.hello_ok");
+    static auto& bad = stats::counter("udp.hello_bad");
+    static auto& expired = stats::counter("udp.hello_expired");
+
+    auto r = udptoken::verify(key_, tok, actor, world_id_, clock_.unix_ms());
+    if (r != udptoken::Check::Ok)
     {
-        token_table_.erase(it); 
-        return false; 
+        (r == udptoken::Check::Expired ? expired : bad).add();
+        return false;
     }
 
-    ep_to_actor_[ep] = actor;
-    actors_.try_emplace(actor, ActorState{});
-    token_table_.erase(it);
+    ok.add();
+    uint32_t s = actors_.add(actor);
+    auto [it, added] = ep_to_slot_.try_emplace(ep, s);
+    if (added || it->second != s)
+    {
+        it->second = s;
+        ep_version_++;
+    }
     return true;
 }
 
 bool UdpSessionManager::on_move(const udp::endpoint& ep, uint32_t seq, float x, float y)
 {
-    auto it = ep_to_actor_.find(ep);
-    if (it == ep_to_actor_.end()) return false;
+    auto it = ep_to_slot_.find(ep);
+    if (it == ep_to_slot_.end()) return false;
 
-    auto& st = actors_[it->second];
-    if (seq <= st.last_seq) return false;
-    st.last_seq = seq;
+    uint32_t s = it->second;
+    if (seq <= actors_.seq(s)) return false;
+    actors_.seq(s) = seq;
 
-    const float dx = x - st.x, dy = y - st.y;
-    if (hypot(dx, dy) < 5.0f) 
-    {
-        st.x = x; 
-        st.y = y; 
-    }
+    const float dx = x - actors_.x(s), dy = y - actors_.y(s);
+    if (hypot(dx, dy) < 5.0f && (dx != 0.f || dy != 0.f))
+        actors_.move(s, x, y); // dirty: 다음 스냅샷에서 이 actor 만 다시 인코딩한다
     return true;
 }
 
-void UdpSessionManager::copy_snapshot(vector<pair<string, ActorState>>& out) const
+void UdpSessionManager::copy_endpoints(vector<pair<udp::endpoint, uint32_t>>& out) const
 {
     out.clear(); 
-    out.reserve(actors_.size());
-    for (const auto& kv : actors_) 
+    out.reserve(ep_to_slot_.size());
+    for (const auto& kv : ep_to_slot_) 
         out.emplace_back(kv.first, kv.second);
 }
-
-void UdpSessionManager::copy_endpoints(vector<udp::endpoint>& out) const
-{
-    out.clear(); 
-    out.reserve(ep_to_actor_.size());
-    for (const auto& kv : ep_to_actor_) 
-        out.emplace_back(kv.first);
-}
 void UdpSessionManager::remove_actor(const string& actor)
 {
-    actors_.erase(actor);
+    uint32_t s;
+    if (!actors_.find(actor, s))
+        return;
+    actors_.remove(s);
 
-    for (auto it = token_table_.begin(); it != token_table_.end(); )
-        it = (it->second.actor == actor) ? token_table_.erase(it) : next(it);
-
-    for (auto it = ep_to_actor_.begin(); it != ep_to_actor_.end(); )
-        it = (it->second == actor) ? ep_to_actor_.erase(it) : next(it);
-}
-
-void UdpSessionManager::sweep()
-{
-    auto now = Clock::now();
-    for (auto it = token_table_.begin(); it != token_table_.end(); )
-        it = (it->second.expires <= now) ? token_table_.erase(it) : next(it);
+    for (auto it = ep_to_slot_.begin(); it != ep_to_slot_.end(); )
+        it = (it->second == s) ? ep_to_slot_.erase(it) : next(it);
+    ep_version_++;
 }
@@ -4,21 +4,27 @@
 #include <vector>
 #include <string>
 #include <chrono>
+#include "ActorStore.hpp"
+#include "WorldClock.hpp"
 
 using namespace std;
 
-struct ActorState
-{
-    float x = 0.f, y = 0.f;
-    uint32_t last_seq = 0;
-};
-
-// UDP endpoint 해시 (ip:port 를 키로)
+// UDP endpoint 해시 (ip:port 를 키로). 패킷마다 불리므로 주소를 문자열로 만들지 않는다
 struct UdpEndpointHash
 {
     size_t operator()(const asio::ip::udp::endpoint& ep) const noexcept
     {
-        return hash<string>{}(ep.address().to_string()) ^ (ep.port() << 16);
+        const auto& a = ep.address();
+        uint64_t h = 0;
+        if (a.is_v4())
+            h = a.to_v4().to_uint();
+        else
+        {
+            auto b = a.to_v6().to_bytes();
+            for (auto c : b)
+                h = h * 131 + c;
+        }
+        return size_t((h << 16 | ep.port()) * 0x9E3779B97F4A7C15ull);
     }
 };
 
@@ -26,26 +32,26 @@ class UdpSessionManager
 {
 public:
     using Executor = asio::io_context::executor_type;
-    explicit UdpSessionManager(asio::strand<Executor>& strand); 
+    // key: 게이트웨이와 공유하는 토큰 키, world_id: 이 월드의 id (둘 다 토큰 서명에 들어간다)
+    UdpSessionManager(const WorldClock& clock, string key, int world_id);
 
     bool on_udp_hello(const string& token, string actor, const asio::ip::udp::endpoint& ep);
     bool on_move(const asio::ip::udp::endpoint& ep, uint32_t seq, float x, float y);
-
-    void register_udp_token_async(string token, string actor, int ttl_ms);
-    void copy_snapshot(vector<pair<string, ActorState>>& out) const;
-    void copy_endpoints(vector<asio::ip::udp::endpoint>& out) const;
+    bool known(const asio::ip::udp::endpoint& ep) const { return ep_to_slot_.count(ep) != 0; }
+    size_t endpoint_count() const { return ep_to_slot_.size(); }
+
+    void copy_snapshot(ActorSnapshot& out) const { actors_.snapshot(out); }
+    // (endpoint, 그 endpoint 의 actor slot)
+    void copy_endpoints(vector<pair<asio::ip::udp::endpoint, uint32_t>>& out) const;
+    // endpoint 가 붙거나 떨어질 때마다 오른다 (목록은 이게 바뀔 때만 다시 만든다)
+    uint64_t endpoints_version() const { return ep_version_; }
     void remove_actor(const string& actor);
-    void sweep();
 
 private:
-    struct TokenRow
-    {
-        string actor = "";
-        chrono::steady_clock::time_point expires;
-    };
-
-    asio::strand<Executor>& strand_; // world
-    unordered_map<string, TokenRow> token_table_; // token, TokenRow
-    unordered_map<asio::ip::udp::endpoint, string, UdpEndpointHash> ep_to_actor_; // endpoint Hash, actorId
-    unordered_map<string, ActorState> actors_; // actorId, ActorState
+    const WorldClock& clock_;
+    string key_;
+    int world_id_;
+    unordered_map<asio::ip::udp::endpoint, uint32_t, UdpEndpointHash> ep_to_slot_; // endpoint, actor slot
+    uint64_t ep_version_ = 0;
+    ActorStore actors_;
 };
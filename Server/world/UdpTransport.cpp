@@ -0,0 +1,64 @@
+#include "UdpTransport.hpp"
+#include "UringUdpTransport.hpp"
+#include "../common/handler_alloc.hpp"
+#include "../common/common.hpp"
+
+using asio::ip::udp;
+using namespace std;
+
+AsioUdpTransport::AsioUdpTransport(asio::io_context& io, unsigned short port)
+    : sock_(io, udp::endpoint(udp::v4(), port))
+{
+}
+
+AsioUdpTransport::AsioUdpTransport(udp::socket sock)
+    : sock_(move(sock))
+{
+}
+
+void AsioUdpTransport::start(asio::strand<Executor>& strand, RecvHandler on_recv)
+{
+    strand_ = &strand;
+    on_recv_ = move(on_recv);
+    recv();
+}
+
+void AsioUdpTransport::recv()
+{
+    sock_.async_receive_from(asio::buffer(buf_), remote_,
+        asio::bind_executor(*strand_, net::recycled([this](error_code ec, size_t n)
+            {
+                if (!ec && n > 0)
+                    on_recv_(buf_.data(), n, remote_);
+                recv();
+            })
+        )
+    );
+}
+
+void AsioUdpTransport::send_to(shared_ptr<const string> msg, const udp::endpoint& ep)
+{
+    sock_.async_send_to(asio::buffer(*msg), ep, net::recycled([msg](auto, auto) {}));
+}
+
+unique_ptr<UdpTransport> make_udp_transport(asio::io_context& io, unsigned short port, const string& backend)
+{
+    if (backend == "uring")
+    {
+#if defined(CARDFLIP_IO_URING) && defined(__linux__)
+        try
+        {
+            auto t = make_unique<UringUdpTransport>(io, port);
+            common::log("WORLD", "udp backend=io_uring");
+            return t;
+        }
+        catch (const system_error& e)
+        {
+            common::log("WORLD", string("io_uring unavailable, using asio: ") + e.what());
+        }
+#else
+        common::log("WORLD", "built without CARDFLIP_IO_URING, using asio");
+#endif
+    }
+    return make_unique<AsioUdpTransport>(io, port);
+}
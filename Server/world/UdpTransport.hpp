@@ -0,0 +1,45 @@
+#pragma once
+#include <asio.hpp>
+#include <array>
+#include <functional>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+// 월드 UDP 송수신 추상화 (실소켓 / 시뮬레이션 교체용)
+class UdpTransport
+{
+public:
+    using Executor = asio::io_context::executor_type;
+    using RecvHandler = function<void(const char* data, size_t n, const asio::ip::udp::endpoint& from)>;
+
+    virtual ~UdpTransport() = default;
+
+    // 수신 핸들러는 strand 위에서 호출된다
+    virtual void start(asio::strand<Executor>& strand, RecvHandler on_recv) = 0;
+    virtual void send_to(shared_ptr<const string> msg, const asio::ip::udp::endpoint& ep) = 0;
+};
+
+class AsioUdpTransport : public UdpTransport
+{
+public:
+    AsioUdpTransport(asio::io_context& io, unsigned short port);
+    // 이미 열린 소켓을 넘겨받는다 (uring 백엔드가 실행 중에 asio 로 내려올 때)
+    explicit AsioUdpTransport(asio::ip::udp::socket sock);
+
+    void start(asio::strand<Executor>& strand, RecvHandler on_recv) override;
+    void send_to(shared_ptr<const string> msg, const asio::ip::udp::endpoint& ep) override;
+
+private:
+    void recv();
+
+    asio::ip::udp::socket sock_;
+    asio::ip::udp::endpoint remote_;
+    array<char, 1500> buf_{};
+    asio::strand<Executor>* strand_ = nullptr;
+    RecvHandler on_recv_;
+};
+
+// backend: "asio"(기본) / "uring" (CARDFLIP_IO_URING 빌드에서만, 초기화 실패 시 asio 로 대체)
+unique_ptr<UdpTransport> make_udp_transport(asio::io_context& io, unsigned short port, const string& backend);
@@ -0,0 +1,395 @@
+#include "UringUdpTransport.hpp"
+#if defined(CARDFLIP_IO_URING) && defined(__linux__)
+#include "../common/handler_alloc.hpp"
+#include "../common/stats.hpp"
+#include "../common/common.hpp"
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+using asio::ip::udp;
+using namespace std;
+
+namespace
+{
+    int uring_setup(unsigned entries, io_uring_params* p)
+    {
+        return (int)syscall(__NR_io_uring_setup, entries, p);
+    }
+    int uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+    {
+        return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0);
+    }
+    int uring_register(int fd, unsigned op, void* arg, unsigned nr)
+    {
+        return (int)syscall(__NR_io_uring_register, fd, op, arg, nr);
+    }
+    [[noreturn]] void fail(const char* what)
+    {
+        throw system_error(errno, system_category(), what);
+    }
+    void* map_anon(size_t n)
+    {
+        void* p = mmap(nullptr, n, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) fail("mmap");
+        return p;
+    }
+}
+
+UringUdpTransport::UringUdpTransport(asio::io_context& io, unsigned short port)
+    : io_(io)
+    , sock_(io, udp::endpoint(udp::v4(), port))
+    , ev_(io)
+{
+    io_uring_params p{};
+    p.flags = IORING_SETUP_CQSIZE;
+    p.cq_entries = kEntries * 4;
+    ring_fd_ = uring_setup(kEntries, &p);
+    if (ring_fd_ < 0) fail("io_uring_setup");
+    try
+    {
+        init(p);
+    }
+    catch (...)
+    {
+        release(); // 생성자가 던지면 소멸자가 불리지 않는다 (eventfd 는 ev_ 에 넘긴 뒤라 멤버 소멸자가 닫는다)
+        throw;
+    }
+}
+
+void UringUdpTransport::init(const io_uring_params& p)
+{
+    if (!(p.features & IORING_FEAT_SINGLE_MMAP))
+        throw system_error(make_error_code(errc::function_not_supported), "io_uring single mmap");
+
+    ring_sz_ = max<size_t>(p.sq_off.array + p.sq_entries * sizeof(unsigned), p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe));
+    ring_mem_ = mmap(nullptr, ring_sz_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (ring_mem_ == MAP_FAILED) fail("mmap sq ring");
+    sqes_sz_ = p.sq_entries * sizeof(io_uring_sqe);
+    void* sq = mmap(nullptr, sqes_sz_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sq == MAP_FAILED) fail("mmap sqes");
+    sqes_ = static_cast<io_uring_sqe*>(sq);
+
+    char* base = static_cast<char*>(ring_mem_);
+    sq_head_ = reinterpret_cast<unsigned*>(base + p.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(base + p.sq_off.tail);
+    sq_array_ = reinterpret_cast<unsigned*>(base + p.sq_off.array);
+    sq_mask_ = *reinterpret_cast<unsigned*>(base + p.sq_off.ring_mask);
+    sq_entries_ = p.sq_entries;
+    sq_local_tail_ = sq_submitted_ = *sq_tail_;
+    cq_head_ = reinterpret_cast<unsigned*>(base + p.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(base + p.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(base + p.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(base + p.cq_off.cqes);
+    addrs_.resize(sq_entries_);
+
+    // 수신 버퍼 링 (provided buffers): 커널이 패킷마다 빈 버퍼를 골라 쓴다
+    br_ = static_cast<io_uring_buf_ring*>(map_anon(kRecvBufs * sizeof(io_uring_buf)));
+    recv_mem_ = static_cast<char*>(map_anon(size_t(kRecvBufs) * kRecvBufSize));
+    io_uring_buf_reg reg{};
+    reg.ring_addr = reinterpret_cast<uint64_t>(br_);
+    reg.ring_entries = kRecvBufs;
+    reg.bgid = kBgid;
+    if (uring_register(ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) fail("register pbuf ring");
+    for (unsigned bid = 0; bid < kRecvBufs; bid++)
+    {
+        io_uring_buf& b = ring_bufs()[(br_tail_ + bid) & (kRecvBufs - 1)];
+        b.addr = reinterpret_cast<uint64_t>(recv_mem_ + size_t(bid) * kRecvBufSize);
+        b.len = kRecvBufSize;
+        b.bid = (uint16_t)bid;
+    }
+    br_tail_ += kRecvBufs;
+    __atomic_store_n(&br_->tail, (uint16_t)br_tail_, __ATOMIC_RELEASE);
+
+    // 송신 슬롯 (registered buffers): 페이지 고정/매핑 비용을 등록 시 한 번만 낸다
+    slot_mem_ = static_cast<char*>(map_anon(size_t(kSlots) * kSlotSize));
+    vector<iovec> iov(kSlots);
+    slots_.resize(kSlots);
+    for (unsigned i = 0; i < kSlots; i++)
+    {
+        slots_[i].data = slot_mem_ + size_t(i) * kSlotSize;
+        iov[i] = { slots_[i].data, kSlotSize };
+    }
+    if (uring_register(ring_fd_, IORING_REGISTER_BUFFERS, iov.data(), kSlots) < 0) fail("register buffers");
+
+    int efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (efd < 0) fail("eventfd");
+    ev_.assign(efd);
+    if (uring_register(ring_fd_, IORING_REGISTER_EVENTFD, &efd, 1) < 0) fail("register eventfd");
+
+    // multishot recvmsg 의 헤더: 주소 길이만 알려주면 커널이 버퍼 앞에 out/주소를 채운다
+    rmsg_.msg_namelen = sizeof(sockaddr_in6);
+    rmsg_.msg_controllen = 0;
+}
+
+UringUdpTransport::~UringUdpTransport()
+{
+    error_code ec;
+    ev_.close(ec);
+    sock_.close(ec);
+    release();
+}
+
+void UringUdpTransport::release()
+{
+    if (sqes_) munmap(sqes_, sqes_sz_);
+    if (ring_mem_ && ring_mem_ != MAP_FAILED) munmap(ring_mem_, ring_sz_);
+    if (ring_fd_ >= 0) close(ring_fd_);
+    if (br_) munmap(br_, kRecvBufs * sizeof(io_uring_buf));
+    if (recv_mem_) munmap(recv_mem_, size_t(kRecvBufs) * kRecvBufSize);
+    if (slot_mem_) munmap(slot_mem_, size_t(kSlots) * kSlotSize);
+    sqes_ = nullptr;
+    ring_mem_ = nullptr;
+    ring_fd_ = -1;
+    br_ = nullptr;
+    recv_mem_ = nullptr;
+    slot_mem_ = nullptr;
+}
+
+void UringUdpTransport::start(asio::strand<Executor>& strand, RecvHandler on_recv)
+{
+    strand_ = &strand;
+    on_recv_ = move(on_recv);
+    {
+        lock_guard<mutex> lk(m_);
+        arm_recv();
+        submit();
+    }
+    wait_cq();
+}
+
+// C++ 에서는 헤더의 flex array 앞 빈 struct 가 1바이트를 차지해서 br_->bufs 가 8바이트 밀린다
+// 링 시작 주소를 그대로 버퍼 배열로 본다 (tail 은 0번 항목의 resv 자리)
+io_uring_buf* UringUdpTransport::ring_bufs()
+{
+    return reinterpret_cast<io_uring_buf*>(br_);
+}
+
+io_uring_sqe* UringUdpTransport::get_sqe()
+{
+    unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    if (sq_local_tail_ - head >= sq_entries_)
+    {
+        submit();
+        head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+        if (sq_local_tail_ - head >= sq_entries_)
+            return nullptr;
+    }
+    unsigned idx = sq_local_tail_ & sq_mask_;
+    sq_array_[idx] = idx;
+    sq_local_tail_++;
+    io_uring_sqe* sqe = &sqes_[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+void UringUdpTransport::submit()
+{
+    static auto& submits = stats::counter("udp.uring_submits");
+    unsigned n = sq_local_tail_ - sq_submitted_;
+    if (n == 0) return;
+    __atomic_store_n(sq_tail_, sq_local_tail_, __ATOMIC_RELEASE);
+    int r = uring_enter(ring_fd_, n, 0, 0);
+    if (r > 0)
+        sq_submitted_ += (unsigned)r;
+    submits.add();
+}
+
+// 한 핸들러 안에서 이어지는 send_to 들을 모아서 syscall 한 번으로 제출
+void UringUdpTransport::schedule_flush()
+{
+    if (flush_posted_) return;
+    flush_posted_ = true;
+    asio::post(io_, net::recycled([this]
+        {
+            lock_guard<mutex> lk(m_);
+            flush_posted_ = false;
+            submit();
+        }));
+}
+
+void UringUdpTransport::arm_recv()
+{
+    io_uring_sqe* sqe = get_sqe();
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = sock_.native_handle();
+    sqe->addr = reinterpret_cast<uint64_t>(&rmsg_);
+    sqe->len = 1;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kBgid;
+    sqe->user_data = kRecvTag;
+}
+
+void UringUdpTransport::wait_cq()
+{
+    ev_.async_read_some(asio::buffer(&ev_val_, sizeof(ev_val_)),
+        asio::bind_executor(*strand_, net::recycled([this](error_code ec, size_t)
+            {
+                if (ec == asio::error::operation_aborted)
+                    return;
+                drain();
+                wait_cq();
+            })
+        )
+    );
+}
+
+void UringUdpTransport::drain()
+{
+    static auto& recvs = stats::counter("udp.uring_recv");
+    static auto& nobufs = stats::counter("udp.uring_nobufs");
+    static auto& send_err = stats::counter("udp.uring_send_err");
+
+    bool rearm = false;
+    int recv_fatal = 0;
+    ready_.clear();
+    {
+        lock_guard<mutex> lk(m_);
+        unsigned head = *cq_head_;
+        unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++)
+        {
+            const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+            if (cqe.user_data == kRecvTag)
+            {
+                if (cqe.flags & IORING_CQE_F_BUFFER)
+                    ready_.push_back({ cqe.flags >> IORING_CQE_BUFFER_SHIFT, cqe.res > 0 ? (unsigned)cqe.res : 0 });
+                else if (cqe.res == -ENOBUFS)
+                    nobufs.add();
+                else if (cqe.res == -EINVAL || cqe.res == -EOPNOTSUPP)
+                    recv_fatal = -cqe.res; // multishot recvmsg 미지원 (5.19 등): 다시 걸어도 같은 결과
+                else if (cqe.res < 0)
+                    common::log("WORLD", string("uring recv: ") + strerror(-cqe.res));
+                if (!(cqe.flags & IORING_CQE_F_MORE))
+                    rearm = true;
+                continue;
+            }
+
+            // SEND_ZC: 결과 CQE 다음에 F_NOTIF 가 오면 그때 버퍼를 돌려받는다
+            Slot& s = slots_[cqe.user_data & 0xffffffffu];
+            if (!(cqe.flags & IORING_CQE_F_NOTIF) && cqe.res < 0)
+            {
+                send_err.add();
+                if (cqe.res == -EINVAL || cqe.res == -EOPNOTSUPP)
+                    zc_ok_ = false; // 커널이 fixed SEND_ZC 를 못 하면 이후로는 sendto
+            }
+            if ((cqe.flags & IORING_CQE_F_NOTIF) || !(cqe.flags & IORING_CQE_F_MORE))
+            {
+                if (--s.refs == 0 && cur_slot_ != int(&s - slots_.data()))
+                    s.src.reset();
+            }
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    }
+
+    for (const auto& r : ready_)
+    {
+        if (r.len < sizeof(io_uring_recvmsg_out)) continue;
+        const char* buf = recv_mem_ + size_t(r.bid) * kRecvBufSize;
+        const auto* out = reinterpret_cast<const io_uring_recvmsg_out*>(buf);
+        const char* name = buf + sizeof(*out);
+        const char* payload = name + rmsg_.msg_namelen + rmsg_.msg_controllen;
+        if (out->flags & MSG_TRUNC) continue;
+        udp::endpoint from;
+        memcpy(from.data(), name, min<size_t>(out->namelen, sizeof(sockaddr_in6)));
+        from.resize(min<size_t>(out->namelen, sizeof(sockaddr_in6)));
+        recvs.add();
+        on_recv_(payload, out->payloadlen, from);
+    }
+
+    lock_guard<mutex> lk(m_);
+    for (const auto& r : ready_)
+    {
+        io_uring_buf& b = ring_bufs()[br_tail_ & (kRecvBufs - 1)];
+        b.addr = reinterpret_cast<uint64_t>(recv_mem_ + size_t(r.bid) * kRecvBufSize);
+        b.len = kRecvBufSize;
+        b.bid = (uint16_t)r.bid;
+        br_tail_++;
+    }
+    __atomic_store_n(&br_->tail, (uint16_t)br_tail_, __ATOMIC_RELEASE);
+    if (recv_fatal && !fallback_)
+        fall_back(recv_fatal);
+    else if (rearm && !fallback_)
+        arm_recv();
+    submit();
+}
+
+// m_ 를 잡은 채로 state strand 에서 불린다. 남은 SEND_ZC 완료는 계속 drain 에서 거둔다
+void UringUdpTransport::fall_back(int err)
+{
+    static auto& fallbacks = stats::counter("udp.uring_fallback");
+    fallbacks.add();
+    common::log("WORLD", string("uring recvmsg multishot unsupported (") + strerror(err) + "), using asio");
+    fallback_ = make_unique<AsioUdpTransport>(move(sock_));
+    fallback_->start(*strand_, on_recv_);
+}
+
+// 같은 payload 면 지금 슬롯을 그대로 쓰고, 아니면 빈 슬롯에 한 번 복사한다
+int UringUdpTransport::slot_for(const shared_ptr<const string>& msg)
+{
+    if (cur_slot_ >= 0 && slots_[cur_slot_].src == msg)
+        return cur_slot_;
+    if (msg->size() > kSlotSize)
+        return -1;
+    for (unsigned i = 0; i < kSlots; i++)
+    {
+        if (slots_[i].refs != 0) continue;
+        if (cur_slot_ >= 0 && slots_[cur_slot_].refs == 0)
+            slots_[cur_slot_].src.reset();
+        memcpy(slots_[i].data, msg->data(), msg->size());
+        slots_[i].src = msg;
+        cur_slot_ = (int)i;
+        return cur_slot_;
+    }
+    return -1;
+}
+
+void UringUdpTransport::send_plain(const string& msg, const udp::endpoint& ep)
+{
+    static auto& fallback = stats::counter("udp.uring_send_fallback");
+    fallback.add();
+    ::sendto(sock_.native_handle(), msg.data(), msg.size(), MSG_DONTWAIT, ep.data(), (socklen_t)ep.size());
+}
+
+void UringUdpTransport::send_to(shared_ptr<const string> msg, const udp::endpoint& ep)
+{
+    static auto& zc = stats::counter("udp.uring_send_zc");
+    lock_guard<mutex> lk(m_);
+    if (fallback_)
+    {
+        fallback_->send_to(move(msg), ep);
+        return;
+    }
+    int slot = zc_ok_ ? slot_for(msg) : -1;
+    io_uring_sqe* sqe = slot >= 0 ? get_sqe() : nullptr;
+    if (!sqe)
+    {
+        send_plain(*msg, ep);
+        return;
+    }
+    unsigned idx = (sq_local_tail_ - 1) & sq_mask_;
+    memcpy(&addrs_[idx], ep.data(), ep.size());
+    sqe->opcode = IORING_OP_SEND_ZC;
+    sqe->fd = sock_.native_handle();
+    sqe->addr = reinterpret_cast<uint64_t>(slots_[slot].data);
+    sqe->len = (uint32_t)msg->size();
+    sqe->ioprio = IORING_RECVSEND_FIXED_BUF;
+    sqe->buf_index = (uint16_t)slot;
+    sqe->addr2 = reinterpret_cast<uint64_t>(&addrs_[idx]);
+    sqe->addr_len = (uint16_t)ep.size();
+    sqe->user_data = kSendTag | (uint64_t)slot;
+    slots_[slot].refs++;
+    zc.add();
+    if (sq_local_tail_ - sq_submitted_ >= 64)
+        submit();
+    else
+        schedule_flush();
+}
+#endif
@@ -0,0 +1,104 @@
+#pragma once
+#include "UdpTransport.hpp"
+#if defined(CARDFLIP_IO_URING) && defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+// io_uring UDP 백엔드 (빌드 옵션 CARDFLIP_IO_URING, 실행 옵션 udp=uring)
+// liburing 없이 syscall 을 직접 쓴다
+//  - 수신: multishot recvmsg + provided buffer ring. 한 번 걸어두면 패킷마다 재무장하지 않는다
+//  - 송신: 스냅샷 payload 를 등록 버퍼 슬롯에 한 번만 복사하고 모든 endpoint 에 SEND_ZC(fixed) 로 보낸다
+//  - 완료 통지는 eventfd 로 받아서 기존 asio reactor 에 얹는다 (TCP 제어 채널은 그대로 asio)
+class UringUdpTransport : public UdpTransport
+{
+public:
+    // 커널이 기능을 지원하지 않으면 system_error. multishot recvmsg 는 첫 CQE 에서야 알 수 있어서
+    // 그때 거부되면 소켓을 AsioUdpTransport 에 넘기고 이후 송수신을 모두 그쪽으로 보낸다
+    UringUdpTransport(asio::io_context& io, unsigned short port);
+    ~UringUdpTransport() override;
+
+    void start(asio::strand<Executor>& strand, RecvHandler on_recv) override;
+    void send_to(shared_ptr<const string> msg, const asio::ip::udp::endpoint& ep) override;
+
+private:
+    // 등록 버퍼 한 칸. 같은 msg 를 여러 endpoint 에 보내는 동안 refs 만 올라간다
+    struct Slot
+    {
+        char* data = nullptr;
+        shared_ptr<const string> src;
+        int refs = 0;
+    };
+
+    void init(const io_uring_params& p);
+    void release();
+    io_uring_buf* ring_bufs();
+    io_uring_sqe* get_sqe();
+    void submit();
+    void schedule_flush();
+    void arm_recv();
+    void wait_cq();
+    void drain();
+    int slot_for(const shared_ptr<const string>& msg);
+    void send_plain(const string& msg, const asio::ip::udp::endpoint& ep);
+    void fall_back(int err);
+
+    static constexpr unsigned kEntries = 1024;
+    static constexpr unsigned kRecvBufs = 512;
+    static constexpr unsigned kRecvBufSize = 2048; // recvmsg_out + 주소 + MTU payload
+    static constexpr unsigned kSlots = 16;
+    static constexpr unsigned kSlotSize = 64 * 1024;
+    static constexpr uint16_t kBgid = 1;
+    static constexpr uint64_t kRecvTag = 1;
+    static constexpr uint64_t kSendTag = uint64_t(2) << 32;
+
+    asio::io_context& io_;
+    asio::ip::udp::socket sock_;
+    asio::posix::stream_descriptor ev_;
+    uint64_t ev_val_ = 0;
+    asio::strand<Executor>* strand_ = nullptr;
+    RecvHandler on_recv_;
+
+    mutex m_; // SQ, 슬롯, 버퍼 링 (send 는 tx strand, 수신은 state strand 에서 온다)
+    int ring_fd_ = -1;
+    void* ring_mem_ = nullptr;
+    size_t ring_sz_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_sz_ = 0;
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_entries_ = 0;
+    unsigned sq_local_tail_ = 0;
+    unsigned sq_submitted_ = 0;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+    bool flush_posted_ = false;
+    bool zc_ok_ = true;
+
+    io_uring_buf_ring* br_ = nullptr;
+    char* recv_mem_ = nullptr;
+    unsigned br_tail_ = 0;
+    msghdr rmsg_{};
+
+    char* slot_mem_ = nullptr;
+    vector<Slot> slots_;
+    int cur_slot_ = -1;
+    vector<sockaddr_in6> addrs_; // SQE 인덱스별 목적지 주소 (submit 시점까지 살아 있어야 함)
+
+    struct Ready
+    {
+        unsigned bid;
+        unsigned len;
+    };
+    vector<Ready> ready_;
+    unique_ptr<AsioUdpTransport> fallback_; // 있으면 sock_ 은 이쪽으로 옮겨갔다
+};
+#endif
@@ -0,0 +1,51 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+using namespace std;
+
+// 월드 로직이 보는 시계 (실서버: steady_clock, 시뮬레이션: 가상 시계)
+class WorldClock
+{
+public:
+    using TimePoint = chrono::steady_clock::time_point;
+
+    virtual ~WorldClock() = default;
+    virtual TimePoint now() const = 0;
+    // 프로세스 밖과 비교하는 시각 (UDP 토큰 만료 등), 유닉스 ms
+    virtual int64_t unix_ms() const = 0;
+
+    static WorldClock& steady();
+};
+
+class SteadyClock : public WorldClock
+{
+public:
+    TimePoint now() const override { return chrono::steady_clock::now(); }
+    int64_t unix_ms() const override
+    {
+        return chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+    }
+};
+
+class VirtualClock : public WorldClock
+{
+public:
+    TimePoint now() const override { return now_; }
+    // 생성 시점의 실제 시각에서 출발해서 advance 만큼만 흐른다
+    int64_t unix_ms() const override
+    {
+        return base_unix_ms_ + chrono::duration_cast<chrono::milliseconds>(now_.time_since_epoch()).count();
+    }
+    void advance(chrono::milliseconds d) { now_ += d; }
+
+private:
+    TimePoint now_{};
+    int64_t base_unix_ms_ = chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+};
+
+inline WorldClock& WorldClock::steady()
+{
+    static SteadyClock clock;
+    return clock;
+}
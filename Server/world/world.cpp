@@ -1,13 +1,37 @@
 ﻿#include "../common/common.hpp"
 #include "../common/net.hpp"
+#include "../common/handler_alloc.hpp"
+#include "../common/stats.hpp"
+#include "../common/cpu_time.hpp"
+#include "../common/udp_token.hpp"
+#include "../common/link_auth.hpp"
+#include "../common/protocol.hpp"
+#include "../common/write_queue.hpp"
+#include "../common/recv_buffer.hpp"
+#include "../common/admission.hpp"
+#include "../common/triple_buffer.hpp"
 #include "world.hpp"
 #include "UdpSessionManager.hpp"
+#include "UdpFilter.hpp"
+#include "SnapshotPacker.hpp"
+#include "SnapshotKernels.hpp"
 #include "TcpAcceptor.hpp"
 #include "TcpSession.hpp"
+#include "ShmAcceptor.hpp"
+#include "ProxySession.hpp"
+#include "ControlSession.hpp"
+#include "UdpTransport.hpp"
+#include "WorldClock.hpp"
+#include "Simulation.hpp"
+#include "UdpBench.hpp"
+#include "SnapshotBench.hpp"
+#include "CoreBench.hpp"
 #include "Room.hpp"
+#include <algorithm>
 #include <unordered_map>
 #include <memory>
 #include <array>
+#include <charconv>
 #include <cmath>
 #include <string>
 #include <asio.hpp>
@@ -17,110 +41,347 @@
 using asio::ip::udp;
 using Executor = asio::io_context::executor_type;
 
-World::World(asio::io_context& io, unsigned short udp_port, int tick_ms)
+namespace
+{
+	// 게이트웨이 연결 중 살아 있는 첫 번째 (죽은 것은 정리). 같은 게이트웨이로 가는 건 모두 이 연결로 보내 순서를 지킨다
+	shared_ptr<ControlSession> live_front(vector<weak_ptr<ControlSession>>& list)
+	{
+		list.erase(remove_if(list.begin(), list.end(), [](const weak_ptr<ControlSession>& w) { return w.expired(); }), list.end());
+		return list.empty() ? nullptr : list.front().lock();
+	}
+}
+
+World::World(asio::io_context& io, unsigned short udp_port, string udp_key, int world_id, const string& udp_backend)
+	: World(io, make_udp_transport(io, udp_port, udp_backend), WorldClock::steady(), move(udp_key), world_id)
+{
+}
+
+World::World(asio::io_context& io, unique_ptr<UdpTransport> udp, WorldClock& clock, string udp_key, int world_id)
 	: io_(io)
-	, sock_(io, udp::endpoint(udp::v4(), udp_port))
+	, udp_(move(udp))
+	, clock_(clock)
 	, tick_(io)
 	, sweep_timer_(io)
-	, tick_ms_(tick_ms)
 	, strand_state_(io.get_executor())
 	, strand_tx_(io.get_executor())
-	, sessions_(make_unique<UdpSessionManager>(strand_state_))
+	, packer_(make_unique<SnapshotPacker>())
+	, snapshots_(make_unique<net::TripleBuffer<SnapshotFrame>>())
+	, sessions_(make_unique<UdpSessionManager>(clock_, udp_key, world_id))
+	, udp_filter_(make_unique<UdpFilter>(clock_, *sessions_))
+	, world_id_(world_id)
+	, link_key_(move(udp_key))
+{
+	udp_->start(strand_state_, [this](const char* data, size_t n, const udp::endpoint& from)
+		{
+			on_datagram(data, n, from);
+		});
+}
+
+World::~World() = default;
+
+bool World::verify_gateway(const string& gw, const string& mac) const
 {
-	recv();
+	return linkauth::verify(link_key_, gw, mac);
+}
+
+void World::set_advertise(string name, string host, int tcp_port, int udp_port)
+{
+	name_ = move(name);
+	host_ = move(host);
+	tcp_port_ = tcp_port;
+	udp_port_ = udp_port;
+}
+
+void World::set_tick_limits(const unordered_map<string, string>& opts)
+{
+	tick_ms_ = max(1, common::opt_int(opts, "tick_ms", tick_ms_));
+	tick_idle_ms_ = max(tick_ms_, common::opt_int(opts, "tick_idle_ms", tick_idle_ms_));
+	tick_catchup_ = max(0, common::opt_int(opts, "tick_catchup", tick_catchup_));
+	tick_budget_pct_ = min(100, max(1, common::opt_int(opts, "tick_budget_pct", tick_budget_pct_)));
+	common::log("WORLD", "tick_ms=" + to_string(tick_ms_) + " idle_ms=" + to_string(tick_idle_ms_)
+		+ " catchup=" + to_string(tick_catchup_) + " budget_pct=" + to_string(tick_budget_pct_));
+}
+
+void World::start()
+{
+	tick_timer_ = true;
+	tick_due_ = chrono::steady_clock::now() + chrono::milliseconds(tick_ms_);
 	schedule_tick();
 	schedule_sweep();
 }
 
-World::~World() = default;
+void World::set_udp_limits(const unordered_map<string, string>& opts)
+{
+	UdpFilter::Limits l;
+	l.move_rate = common::opt_int(opts, "udp_move_rate", l.move_rate);
+	l.move_burst = common::opt_int(opts, "udp_move_burst", l.move_burst);
+	l.hello_rate = common::opt_int(opts, "udp_hello_rate", l.hello_rate);
+	l.hello_burst = common::opt_int(opts, "udp_hello_burst", l.hello_burst);
+	l.hello_sources = size_t(common::opt_int(opts, "udp_hello_sources", int(l.hello_sources)));
+	udp_filter_->set_limits(l);
+}
 
-void World::register_udp_token_async(string token, string actor, int ttl_ms)
+void World::set_snapshot_limits(const unordered_map<string, string>& opts)
 {
-	sessions_->register_udp_token_async(move(token), actor, ttl_ms);
+	SnapshotPacker::Limits l;
+	l.mtu = size_t(max(256, common::opt_int(opts, "snap_mtu", int(l.mtu))));
+	l.bound = float(max(1, common::opt_int(opts, "snap_bound", int(l.bound))));
+	// 소수점 아래 자리수로 찍으므로 10 의 거듭제곱만 (가장 가까운 값으로 맞춘다, 최대 1e6)
+	int scale = max(1, common::opt_int(opts, "snap_scale", int(l.scale)));
+	l.scale = float(pow(10.0, min(6.0, round(log10(double(scale))))));
+	if (int(l.scale) != scale)
+		common::log("WORLD", "snap_scale=" + to_string(scale) + " rounded to " + to_string(int(l.scale)));
+	l.repeat = min(255, max(0, common::opt_int(opts, "snap_repeat", l.repeat)));
+	// 양자화 값이 int32 에 들어가야 한다
+	if (double(l.bound) * l.scale >= 2e9)
+		l.bound = float(2e9 / l.scale);
+	packer_->set_limits(l);
+	simd::set_level(opts.count("simd") ? opts.at("simd") : "auto");
+	common::log("WORLD", string("snapshot kernels=") + simd::name(simd::level()) + " scale=" + to_string(int(l.scale)));
+
+	LinkMonitor::Limits k;
+	k.ping_ms = max(50, common::opt_int(opts, "ping_ms", k.ping_ms));
+	// budget 이 패킷 하나보다 작으면 아무것도 못 보내고 우선순위만 계속 오른다
+	k.max_budget = max(l.mtu, size_t(max(0, common::opt_int(opts, "snap_budget", int(k.max_budget)))));
+	k.min_budget = min(k.max_budget, max(l.mtu, size_t(max(0, common::opt_int(opts, "snap_budget_min", int(k.min_budget))))));
+	int snap_hz_min = max(1, common::opt_int(opts, "snap_hz_min", 2));
+	k.max_every = max(1, 1000 / (tick_ms_ * snap_hz_min));
+	k.rtt_hi = common::opt_int(opts, "link_rtt_hi", k.rtt_hi);
+	k.jitter_hi = common::opt_int(opts, "link_jitter_hi", k.jitter_hi);
+	k.loss_hi = common::opt_int(opts, "link_loss_pct", int(k.loss_hi * 100)) / 100.f;
+	packer_->links().set_limits(k);
 }
 
-void World::recv()
+void World::on_datagram(const char* data, size_t n, const udp::endpoint& from)
 {
-	sock_.async_receive_from(asio::buffer(buf_), remote_,
-		asio::bind_executor(strand_state_, [this](error_code ec, size_t n)
+	// 모르는 곳에서 온 패킷, 폭주하는 MOVE/HELLO 는 복사/파싱 전에 버린다
+	auto kind = udp_filter_->admit(data, n, from);
+	if (kind == UdpFilter::Kind::Drop)
+		return;
+	string s(data, n);
+	if (kind == UdpFilter::Kind::Pong)
+	{
+		// 받은 시각은 여기서 잰다 (strand_tx 대기 시간이 RTT 에 섞이지 않게)
+		// 아는 endpoint 에서 왔어도 내용은 믿지 않는다: 숫자가 아니면 버린다 (예외를 strand 로 던지지 않게)
+		auto m = net::kvparse(s.substr(5));
+		const string& v = m["seq"];
+		uint32_t seq = 0;
+		auto [end, ec] = from_chars(v.data(), v.data() + v.size(), seq);
+		if (ec != errc() || end != v.data() + v.size())
+		{
+			static auto& bad = stats::counter("udp.drop_bad_pong");
+			bad.add();
+			return;
+		}
+		int64_t now_ms = clock_.unix_ms();
+		asio::post(strand_tx_, net::recycled([this, from, seq, now_ms]
 			{
-				if (!ec && n > 0)
-				{
-					string s(buf_.data(), n);
-					if (s.rfind("HELLO", 0) == 0)
-					{
-						auto m = net::kvparse(s.substr(6));
-						const string tok = m["token"];
-						string actor = m["actor"];
-						sessions_->on_udp_hello(tok, actor, remote_);
-					}
-					else if (s.rfind("MOVE", 0) == 0)
-					{
-						auto m = net::kvparse(s.substr(5));
-						uint32_t seq = m.count("seq") ? static_cast<uint32_t>(stoul(m["seq"])) : 0;
-						float x = m.count("x") ? stof(m["x"]) : 0.f;
-						float y = m.count("y") ? stof(m["y"]) : 0.f;
-						sessions_->on_move(remote_, seq, x, y);
-					}
-				}
-				recv();
-			}
-		)
-	);
+				packer_->links().on_pong(from, seq, now_ms);
+			})
+		);
+	}
+	else if (kind == UdpFilter::Kind::Hello)
+	{
+		auto m = net::kvparse(s.substr(6));
+		const string tok = m["token"];
+		string actor = m["actor"];
+		sessions_->on_udp_hello(tok, actor, from);
+		wake_tick();
+	}
+	else
+	{
+		// PONG 과 같이 숫자가 아니거나 유한하지 않은 값이 하나라도 있으면 버린다 (없는 키는 0)
+		auto m = net::kvparse(s.substr(5));
+		auto num = [&m](const char* key, auto& out)
+			{
+				auto it = m.find(key);
+				if (it == m.end())
+					return true;
+				const string& v = it->second;
+				auto [end, ec] = from_chars(v.data(), v.data() + v.size(), out);
+				return ec == errc() && end == v.data() + v.size();
+			};
+		uint32_t seq = 0;
+		float x = 0.f, y = 0.f;
+		if (!num("seq", seq) || !num("x", x) || !num("y", y) || !isfinite(x) || !isfinite(y))
+		{
+			static auto& bad = stats::counter("udp.drop_bad_move");
+			bad.add();
+			return;
+		}
+		sessions_->on_move(from, seq, x, y);
+	}
 }
 
-void World::schedule_tick()
+// 단계별로 시간을 잰다. 입력(UDP/TCP)은 도착할 때 바로 state 에서 처리하므로 tick 에는 스냅샷, heartbeat, 로비/관전 변화만 있다
+void World::tick()
 {
-	tick_.expires_after(chrono::milliseconds(tick_ms_));
-	tick_.async_wait(asio::bind_executor(strand_state_, [this](error_code)
+	static auto& snapshot_us = stats::histogram("tick.snapshot_us");
+	static auto& heartbeat_us = stats::histogram("tick.heartbeat_us");
+	static auto& lobby_us = stats::histogram("tick.lobby_us");
+	static auto& watch_us = stats::histogram("tick.watch_us");
+	static auto& work_us = stats::histogram("tick.work_us");
+	static auto& over_budget = stats::counter("tick.over_budget");
+
+	auto t0 = chrono::steady_clock::now();
+	broadcast_snapshot_fast();
+	auto t1 = chrono::steady_clock::now();
+	tcp_heart_beat();
+	auto t2 = chrono::steady_clock::now();
+	flush_lobby();
+	auto t3 = chrono::steady_clock::now();
+	flush_watch();
+	auto t4 = chrono::steady_clock::now();
+
+	auto us = [](auto d) { return int64_t(chrono::duration_cast<chrono::microseconds>(d).count()); };
+	snapshot_us.record(us(t1 - t0));
+	heartbeat_us.record(us(t2 - t1));
+	lobby_us.record(us(t3 - t2));
+	watch_us.record(us(t4 - t3));
+	work_us.record(us(t4 - t0));
+	if (us(t4 - t0) * 100 > int64_t(tick_ms_) * 1000 * tick_budget_pct_)
+		over_budget.add();
+}
+
+void World::sweep()
+{
+	static auto& expired = stats::counter("world.reserve_expired");
+	auto now = clock_.now();
+	for (auto it = reserved_.begin(); it != reserved_.end(); )
+	{
+		if (it->second.until > now)
 		{
-			broadcast_snapshot_fast();
-			tcp_heart_beat();
-			schedule_tick();
+			++it;
+			continue;
 		}
+		// HELLO 없이 끝난 입장: 예약한 게이트웨이가 actor 자리를 풀도록 알린다
+		expired.add();
+		auto g = gateway_sessions_.find(it->second.gw);
+		if (g != gateway_sessions_.end())
+			if (auto p = live_front(g->second))
+				p->write_line(proto::copy_line(proto::build(proto::msg::EXIT_USER, it->first)));
+		it = reserved_.erase(it);
+	}
+	close_orphan_proxies();
+	udp_filter_->sweep();
+	report_load();
+	if (++sweep_count_ % 30 == 0)
+		common::log("WORLD", "stats " + stats::dump());
+}
+
+void World::schedule_tick()
+{
+	tick_.expires_at(tick_due_);
+	tick_.async_wait(asio::bind_executor(strand_state_, net::recycled([this, gen = tick_gen_](error_code)
+		{
+			if (gen != tick_gen_)
+				return; // 그 사이 다시 걸었다
+			on_tick_timer();
+		})
 	)
 	);
 }
 
+// 예정 시각은 절대 시각으로 주기만큼 더한다 (작업 시간이 주기에 더해지지 않는다)
+// 늦으면 tick_catchup 번까지는 바로 이어서 돌려 따라잡고, 그보다 밀리면 놓친 tick 은 건너뛰고 다음 예정 시각에 맞춘다
+void World::on_tick_timer()
+{
+	static auto& late_us = stats::histogram("tick.late_us");
+	static auto& skipped = stats::counter("tick.skipped");
+	static auto& idle_ticks = stats::counter("tick.idle");
+
+	auto start = chrono::steady_clock::now();
+	late_us.record(chrono::duration_cast<chrono::microseconds>(start - tick_due_).count());
+	tick();
+	auto now = chrono::steady_clock::now();
+	// 예정 시각부터 tick 이 끝날 때까지 한 주기를 넘기면 밀린 것
+	if (now - tick_due_ > chrono::milliseconds(tick_ms_))
+		tick_overruns_++;
+
+	// 아무도 없으면 느리게 돈다 (누가 들어오면 wake_tick 이 바로 깨운다)
+	tick_idle_ = idle();
+	if (tick_idle_)
+		idle_ticks.add();
+	auto period = chrono::milliseconds(tick_idle_ ? tick_idle_ms_ : tick_ms_);
+	tick_due_ += period;
+	if (tick_due_ > now)
+		tick_behind_ = 0;
+	else if (++tick_behind_ > tick_catchup_)
+	{
+		auto missed = (now - tick_due_) / period + 1;
+		tick_due_ += missed * period;
+		skipped.add(int64_t(missed));
+		tick_behind_ = 0;
+	}
+	schedule_tick();
+}
+
+bool World::idle() const
+{
+	return sessions_->endpoint_count() == 0 && ctrl_sessions_.empty() && proxies_.empty();
+}
+
+// idle 주기로 자고 있으면 바로 다시 건다 (state 에서)
+void World::wake_tick()
+{
+	if (!tick_timer_ || !tick_idle_)
+		return;
+	tick_idle_ = false;
+	tick_gen_++;
+	tick_behind_ = 0;
+	tick_due_ = chrono::steady_clock::now();
+	schedule_tick();
+}
+
 void World::schedule_sweep()
 {
 	sweep_timer_.expires_after(chrono::seconds(1));
-	sweep_timer_.async_wait(asio::bind_executor(strand_state_, [this](error_code)
+	sweep_timer_.async_wait(asio::bind_executor(strand_state_, net::recycled([this](error_code)
 		{
-			sessions_->sweep();
+			sweep();
 			schedule_sweep();
-		}
+		})
 	)
 	);
 }
 
 void World::broadcast_snapshot_fast()
 {
-	vector<pair<string, ActorState>> actors;
-	vector<udp::endpoint> eps;
-	sessions_->copy_snapshot(actors);
-	sessions_->copy_endpoints(eps);
+	static auto& skipped = stats::counter("snap.skipped");
 
-	asio::post(strand_tx_, [this, actors = move(actors), eps = move(eps)]
+	// 돌려 쓰는 버퍼에 채운다 (위치 배열 memcpy, 이름은 slot 주인이 바뀐 곳만)
+	auto& f = snapshots_->back();
+	sessions_->copy_snapshot(f.actors);
+	if (sessions_->endpoints_version() != snap_clients_version_)
+	{
+		auto eps = make_shared<vector<pair<udp::endpoint, uint32_t>>>();
+		sessions_->copy_endpoints(*eps);
+		snap_clients_ = move(eps);
+		snap_clients_version_ = sessions_->endpoints_version();
+	}
+	f.clients = snap_clients_;
+	f.clients_version = snap_clients_version_;
+	f.now_ms = clock_.unix_ms();
+	if (snapshots_->publish())
+		skipped.add(); // tx 가 밀려서 이전 tick 은 건너뛴다
+
+	// 한 데이터그램에 다 넣으면 1500 을 넘어 IP 조각이 나고, 조각 하나만 잃어도 전부 잃는다
+	// 클라이언트마다 MTU 패킷으로 나누고 링크 품질로 정한 주기/예산 안에서 우선순위 순으로 보낸다
+	if (tx_posted_.exchange(true, memory_order_acq_rel))
+		return;
+	asio::post(strand_tx_, net::recycled([this]
 		{
-			string payload;
-			payload.reserve(actors.size() * 40);
-			for (const auto& kv : actors)
-			{
-				payload += "ACTOR_POS id=" + kv.first
-					+ " x=" + to_string(kv.second.x)
-					+ " y=" + to_string(kv.second.y) + "\n";
-			}
-			auto msg = make_shared<string>(move(payload));
-			for (const auto& ep : eps)
-				sock_.async_send_to(asio::buffer(*msg), ep, [msg](auto, auto) {});
-		}
+			tx_posted_.store(false, memory_order_release);
+			if (!snapshots_->acquire())
+				return;
+			packer_->pack(snapshots_->front(), *udp_);
+		})
 	);
 }
 
 void World::tcp_heart_beat()
 {
-	string line = "BROADCAST_HEART_BEAT";
+	string line = proto::HEART_BEAT;
 	send_tcp_to_all(line);
 }
 
@@ -130,57 +391,210 @@ inline void World::send_tcp_to(const string& actor, const string& line)
 	if (it == ctrl_sessions_.end()) return;
 	if (auto s = it->second.lock())
 	{
-		s->write_line(line);
+		s->write_line(proto::copy_line(line));
 	}
 }
 
-inline void World::send_tcp_to_room(const string& roomId, const string& line)
+// 프록시 클라이언트는 게이트웨이별로 모아서 Fanout 프레임 하나로 보낸다
+// 플레이어에게는 바로, 관전자에게는 tick 에 모아서 (관전자가 많아도 플레이어 응답은 늦어지지 않는다)
+inline void World::send_tcp_to_room(const string& roomId, const string& line, const string& watch_line)
 {
 	auto rit = rooms_.find(roomId);
 	if (rit == rooms_.end()) return;
+	watch_delta(rit->second, watch_line.empty() ? line : watch_line);
 	for (const auto& actor : rit->second.members)
 	{
-		send_tcp_to(actor, line);
+		auto it = ctrl_sessions_.find(actor);
+		if (it == ctrl_sessions_.end()) continue;
+		auto s = it->second.lock();
+		if (!s) continue;
+		if (s->proxied())
+			add_fanout(s->gateway(), actor);
+		else
+			s->write_line(proto::copy_line(line));
 	}
+	flush_fanout(line);
 }
 
 inline void World::send_tcp_to_all(const string& line)
 {
 	for (auto& [actor, wp] : ctrl_sessions_)
 	{
-		if (auto s = wp.lock())
-			s->write_line(line);
+		auto s = wp.lock();
+		if (!s) continue;
+		if (s->proxied())
+			add_fanout(s->gateway(), "*");
+		else
+			s->write_line(proto::copy_line(line));
 	}
+	flush_fanout(line);
+}
+
+void World::add_fanout(const string& gw, const string& actor)
+{
+	auto it = find_if(fanout_.begin(), fanout_.end(), [&](const pair<string, string>& f) { return f.first == gw; });
+	if (it == fanout_.end())
+	{
+		fanout_.emplace_back(gw, actor);
+		return;
+	}
+	if (it->second == "*")
+		return;
+	it->second += ',';
+	it->second += actor;
+}
+
+void World::flush_fanout(const string& line)
+{
+	static auto& frames = stats::counter("proxy.fanout_frames");
+	for (auto& [gw, targets] : fanout_)
+	{
+		string payload;
+		payload.reserve(targets.size() + 1 + line.size());
+		payload += targets;
+		payload += ' ';
+		payload += line;
+		send_gateway_frame(gw, rpc::Type::Fanout, payload);
+		frames.add();
+	}
+	fanout_.clear();
 }
 
 void World::send_to_gateway(const string& line)
 {
-	if (auto p = gateway_session_.lock())
-		p->write_line(move(line));
+	// 게이트웨이마다 살아 있는 연결 하나로
+	for (auto& [gw, list] : gateway_sessions_)
+		if (auto p = live_front(list))
+			p->write_line(line);
+}
+
+void World::send_gateway_frame(const string& gw, rpc::Type t, const string& payload)
+{
+	auto it = gateway_sessions_.find(gw);
+	if (it == gateway_sessions_.end())
+		return;
+	if (auto p = live_front(it->second))
+		p->write_frame(t, 0, payload);
+}
+
+void World::send_to_client(const string& gw, const string& actor, const string& line)
+{
+	send_gateway_frame(gw, rpc::Type::Client, actor + " " + line);
 }
 
-void World::bind_session(const string& actor, shared_ptr<TcpSession> s)
+void World::on_proxy_line(const string& gw, const string& actor, const string& line)
+{
+	auto it = proxies_.find(actor);
+	if (line == proto::CLIENT_BYE)
+	{
+		if (it != proxies_.end() && it->second->gateway() == gw)
+		{
+			auto p = static_pointer_cast<ProxySession>(move(it->second));
+			proxies_.erase(it);
+			p->close();
+		}
+		return;
+	}
+	if (it == proxies_.end())
+	{
+		it = proxies_.emplace(actor, make_shared<ProxySession>(*this, gw, actor)).first;
+		wake_tick();
+	}
+	else if (it->second->gateway() != gw)
+		return; // 다른 게이트웨이로 붙어 있는 actor
+	static_pointer_cast<ProxySession>(it->second)->feed(line);
+}
+
+// 게이트웨이 링크가 모두 끊기면 그 게이트웨이 뒤의 클라이언트도 끊긴 것으로 본다
+void World::close_orphan_proxies()
+{
+	for (auto it = proxies_.begin(); it != proxies_.end(); )
+	{
+		auto g = gateway_sessions_.find(it->second->gateway());
+		if (g != gateway_sessions_.end() && live_front(g->second))
+		{
+			++it;
+			continue;
+		}
+		auto p = static_pointer_cast<ProxySession>(move(it->second));
+		it = proxies_.erase(it);
+		p->close();
+	}
+}
+
+// 1초마다 게이트웨이에 부하 보고 (배치 판단용)
+void World::report_load()
+{
+	auto now = chrono::steady_clock::now();
+	double cpu = stats::process_cpu_s();
+	double wall = chrono::duration<double>(now - cpu_at_).count();
+	int pct = (cpu_at_ != chrono::steady_clock::time_point{} && wall > 0) ? int((cpu - cpu_s_) / wall * 100) : 0;
+	cpu_s_ = cpu;
+	cpu_at_ = now;
+
+	// state 큐가 밀렸거나 tick 이 계속 늦으면 과부하: 새 입장을 막아서 진행 중인 게임의 지연을 지킨다
+	static auto& overload_s = stats::counter("adm.overload_s");
+	int qdepth = state_pending_.load(memory_order_relaxed);
+	bool over = qdepth > overload_queue_ || tick_overruns_ >= overload_overruns_;
+	if (over != overloaded_)
+		common::log("WORLD", string(over ? "overload on" : "overload off") + " qdepth=" + to_string(qdepth) + " overrun=" + to_string(tick_overruns_));
+	overloaded_ = over;
+	if (over)
+		overload_s.add();
+
+	send_to_gateway(proto::build(proto::msg::WORLD_LOAD, world_id_, ctrl_sessions_.size() + reserved_.size(),
+		rooms_.size(), tick_overruns_, pct, qdepth, over ? 1 : 0));
+	tick_overruns_ = 0;
+}
+
+void World::bind_session(const string& actor, shared_ptr<ControlSession> s)
 {
 	ctrl_sessions_[actor] = move(s);
+	wake_tick();
+	reserved_.erase(actor);
 }
 
-void World::on_disconnect(const string& actor, TcpSession* s)
+bool World::reserve_actor(const string& actor, const string& gw)
+{
+	auto it = ctrl_sessions_.find(actor);
+	if (it != ctrl_sessions_.end() && !it->second.expired())
+		return false;
+	auto now = clock_.now();
+	auto r = reserved_.find(actor);
+	if (r != reserved_.end() && r->second.until > now && r->second.gw != gw)
+		return false;
+	reserved_[actor] = Reservation{ now + chrono::seconds(10), gw };
+	return true;
+}
+
+void World::on_disconnect(const string& actor, ControlSession* s)
 {
 	auto it = ctrl_sessions_.find(actor);
 	if (it != ctrl_sessions_.end())
 	{
 		if (auto cur = it->second.lock())
 		{
-			if (cur.get() == s) ctrl_sessions_.erase(it);
+			if (cur.get() == s)
+			{
+				ctrl_sessions_.erase(it);
+				lobby_.erase(actor);
+			}
 		}
 		else {
 			ctrl_sessions_.erase(it);
+			lobby_.erase(actor);
 		}
 	}
 }
-void World::bind_gateway_session(shared_ptr<TcpSession>& s)
+void World::bind_gateway_session(shared_ptr<ControlSession>& s, const string& gw)
 {
-	gateway_session_ = s;
+	post_state([this, s, gw]
+		{
+			gateway_sessions_[gw].push_back(s);
+			// 등록은 연결마다 (게이트웨이가 연결별로 월드를 알아야 한다)
+			s->write_line(proto::copy_line(proto::build(proto::msg::WORLD_REGISTER, world_id_, name_, host_, udp_port_, tcp_port_)));
+			report_load();
+		});
 }
 
 // 룸/게임 도메인
@@ -198,7 +612,7 @@ string World::create_room(const string& master, const string& title, int rows, i
 	r.cols = cols;
 	r.members.insert(master);
 
-	rooms_.emplace(roomId, move(r));
+	index_room(rooms_.emplace(roomId, move(r)).first->second);
 	return roomId;
 }
 
@@ -206,8 +620,10 @@ bool World::join_room(const string& roomId, const string& actor)
 {
 	auto it = rooms_.find(roomId);
 	if (it == rooms_.end()) return false;
+	it->second.watchers.erase(actor); // 보던 룸에 들어가면 플레이어로만 받는다
 	it->second.members.insert(actor);
 	it->second.challenger = actor;
+	index_room(it->second);
 	return true;
 }
 bool World::change_ready(const string& roomId, const bool& isReady)
@@ -228,6 +644,7 @@ bool World::game_start(const string& roomId)
 	auto it = rooms_.find(roomId);
 	if (it == rooms_.end()) return false;
 	it->second.start_game();
+	index_room(it->second);
 	return true;
 }
 bool World::game_peek_end(const string& roomId, const string& actor)
@@ -242,7 +659,9 @@ bool World::flip_card(const string& roomId, const string& actor, int index)
 	auto it = rooms_.find(roomId);
 	if (it == rooms_.end()) return false;
 
-	return it->second.card_flip(actor, index);
+	bool ok = it->second.card_flip(actor, index);
+	index_room(it->second);
+	return ok;
 }
 bool World::check_end_game(const string& roomId)
 {
@@ -260,7 +679,13 @@ bool World::delete_room(const string& roomId)
 {
 	auto it = rooms_.find(roomId);
 	if (it == rooms_.end()) return false;
-	rooms_.erase(roomId);
+	unindex_room(it->second);
+	if (!it->second.watchers.empty())
+	{
+		watch_delta(it->second, proto::build(proto::msg::CAST_WATCH_END, roomId));
+		flush_watchers(it->second);
+	}
+	rooms_.erase(it);
 	return true;
 }
 bool World::check_exit_room_master(const string& roomId, const string& actor)
@@ -277,6 +702,7 @@ bool World::change_room_master(const string& roomId)
 	it->second.members.erase(it->second.master);
 	it->second.master = it->second.challenger;
 	it->second.challenger = "";
+	index_room(it->second);
 	return true;
 }
 bool World::exit_room_challenger(const string& roomId)
@@ -286,6 +712,7 @@ bool World::exit_room_challenger(const string& roomId)
 	it->second.score.erase(it->second.challenger);
 	it->second.members.erase(it->second.challenger);
 	it->second.challenger = "";
+	index_room(it->second);
 	return true;
 }
 bool World::change_rule(const string& roomId, const string& master, int cols, int rows)
@@ -302,9 +729,223 @@ int World::change_room_phase(const string& roomId, const int phase)
 	auto it = rooms_.find(roomId);
 	if (it == rooms_.end()) return 0;
 	it->second.phase = (Phase)phase;
+	index_room(it->second);
 	return phase;
 }
 
+// 목록 키 (phase, 찬 자리 수) 가 바뀌었으면 다시 넣는다
+void World::index_room(Room& r)
+{
+	int phase = int(r.phase), taken = int(r.members.size());
+	if (phase == r.listed_phase && taken == r.listed_taken)
+		return;
+	unindex_room(r);
+	room_index_.emplace(phase, taken, r.roomId);
+	r.listed_phase = phase;
+	r.listed_taken = taken;
+}
+
+void World::unindex_room(Room& r)
+{
+	if (r.listed_phase >= 0)
+		room_index_.erase({ r.listed_phase, r.listed_taken, r.roomId });
+	r.listed_phase = r.listed_taken = -1;
+}
+
+string World::room_list(int phase, int free, int page, int size) const
+{
+	static constexpr int kSeats = 2;
+	// 조건에 맞는 구간: phase 마다 (phase, 0) 부터 (phase, kSeats - free) 까지 (찬 자리가 적은 순)
+	vector<pair<set<tuple<int, int, string>>::const_iterator, set<tuple<int, int, string>>::const_iterator>> ranges;
+	for (int p = 0; p <= int(Phase::END); p++)
+	{
+		if (phase >= 0 && p != phase)
+			continue;
+		auto b = room_index_.lower_bound({ p, 0, string() });
+		auto e = free > 0 ? room_index_.lower_bound({ p, kSeats - free + 1, string() }) : room_index_.lower_bound({ p + 1, 0, string() });
+		if (b != e)
+			ranges.emplace_back(b, e);
+	}
+	size_t total = 0;
+	for (const auto& [b, e] : ranges)
+		total += size_t(distance(b, e));
+
+	size_t skip = size_t(page) * size_t(size);
+	string out;
+	out.reserve(64 + size_t(size) * 96);
+	size_t count = 0;
+	string items;
+	for (const auto& [b, e] : ranges)
+	{
+		for (auto it = b; it != e && count < size_t(size); ++it)
+		{
+			if (skip > 0)
+			{
+				skip--;
+				continue;
+			}
+			const Room& r = rooms_.at(get<2>(*it));
+			items += '\n';
+			items += proto::build(proto::msg::ROOM_ITEM, r.roomId, r.title, r.master, r.challenger, int(r.phase),
+				max(0, kSeats - int(r.members.size())));
+			count++;
+		}
+	}
+	size_t pages = (total + size_t(size) - 1) / size_t(size);
+	out += proto::build(proto::msg::RES_ROOM_LIST, page, pages, total, count);
+	out += items;
+	return out;
+}
+
+void World::lobby_subscribe(const string& actor, bool on)
+{
+	if (actor.empty())
+		return; // HELLO 전
+	if (!on)
+	{
+		lobby_.erase(actor);
+		return;
+	}
+	flush_lobby();
+	lobby_.insert(actor);
+}
+
+void World::lobby_delta(const string& line)
+{
+	static auto& deltas = stats::counter("lobby.deltas");
+	deltas.add();
+	if (lobby_.empty())
+		return; // 새 구독자는 구독 뒤의 변화만 받으므로 버려도 된다
+	if (!lobby_batch_.empty())
+		lobby_batch_ += '\n';
+	lobby_batch_ += line;
+}
+
+// 모인 로비 변화를 구독자에게 한 번에 (세션마다 쓰기 한 번, 게이트웨이마다 Fanout 프레임 하나)
+void World::flush_lobby()
+{
+	static auto& batches = stats::counter("lobby.batches");
+	static auto& sent = stats::counter("lobby.sent");
+	if (lobby_batch_.empty())
+		return;
+	for (auto it = lobby_.begin(); it != lobby_.end(); )
+	{
+		auto cit = ctrl_sessions_.find(*it);
+		auto s = cit == ctrl_sessions_.end() ? nullptr : cit->second.lock();
+		if (!s)
+		{
+			it = lobby_.erase(it);
+			continue;
+		}
+		if (s->proxied())
+			add_fanout(s->gateway(), *it);
+		else
+			s->write_line(proto::copy_line(lobby_batch_));
+		sent.add();
+		++it;
+	}
+	flush_fanout(lobby_batch_);
+	batches.add();
+	lobby_batch_.clear();
+}
+
+bool World::watch_room(const string& roomId, const string& actor, string& reply)
+{
+	static auto& joined = stats::counter("watch.joined");
+	static auto& rejected = stats::counter("watch.rejected");
+	auto it = rooms_.find(roomId);
+	if (it == rooms_.end() || actor.empty())
+	{
+		reply = proto::copy_line(proto::build(proto::msg::ERR_ROOM, "ROOM_NOT_FOUND", roomId));
+		return false;
+	}
+	Room& r = it->second;
+	if (r.members.count(actor))
+	{
+		reply = proto::copy_line(proto::build(proto::msg::ERR_ROOM, "IN_ROOM", roomId));
+		return false;
+	}
+	if (!r.watchers.count(actor) && int(r.watchers.size()) >= watch_limit_)
+	{
+		rejected.add();
+		reply = proto::copy_line(proto::build(proto::msg::ERR_ROOM, "ROOM_FULL", roomId));
+		return false;
+	}
+	// 상태 줄보다 먼저 일어난 이벤트는 그 전 관전자에게만 (새 관전자가 같은 변화를 두 번 받지 않게)
+	flush_watchers(r);
+	r.watchers.insert(actor);
+	joined.add();
+
+	vector<int> board(r.deck.cards.size(), -1);
+	for (size_t i = 0; i < board.size(); i++)
+		if ((i < r.deck.peek_cards.size() && r.deck.peek_cards[i]) || int(i) == r.firstIndex)
+			board[i] = r.deck.cards[i];
+	auto score = [&](const string& a) { auto s = r.score.find(a); return s == r.score.end() ? 0 : s->second; };
+	reply = proto::copy_line(proto::build(proto::msg::RES_WATCH_ROOM, r.roomId, r.title, r.master, r.challenger, r.rows, r.cols,
+		int(r.phase), r.turn, score(r.master), score(r.challenger), board, r.firstIndex, r.watchers.size()));
+	return true;
+}
+
+void World::unwatch_room(const string& roomId, const string& actor)
+{
+	auto it = rooms_.find(roomId);
+	if (it != rooms_.end())
+		it->second.watchers.erase(actor);
+}
+
+void World::watch_delta(Room& r, const string& line)
+{
+	if (r.watchers.empty())
+		return;
+	if (r.watch_batch.empty())
+		watch_dirty_.push_back(r.roomId);
+	else
+		r.watch_batch += '\n';
+	r.watch_batch += line;
+}
+
+void World::flush_watch()
+{
+	for (const auto& roomId : watch_dirty_)
+	{
+		auto it = rooms_.find(roomId);
+		if (it != rooms_.end())
+			flush_watchers(it->second);
+	}
+	watch_dirty_.clear();
+}
+
+// 모인 이벤트를 한 번만 만들어서 관전자 모두의 송신 큐가 같은 버퍼를 가리키게 한다 (게이트웨이마다는 Fanout 프레임 하나)
+void World::flush_watchers(Room& r)
+{
+	static auto& batches = stats::counter("watch.batches");
+	static auto& sent = stats::counter("watch.sent");
+	if (r.watch_batch.empty())
+		return;
+	r.watch_batch += '\n';
+	auto buf = make_shared<const string>(move(r.watch_batch));
+	r.watch_batch = string();
+	for (auto it = r.watchers.begin(); it != r.watchers.end(); )
+	{
+		auto cit = ctrl_sessions_.find(*it);
+		auto s = cit == ctrl_sessions_.end() ? nullptr : cit->second.lock();
+		if (!s)
+		{
+			it = r.watchers.erase(it);
+			continue;
+		}
+		if (s->proxied())
+			add_fanout(s->gateway(), *it);
+		else
+			s->write_shared(buf);
+		sent.add();
+		++it;
+	}
+	if (!fanout_.empty())
+		flush_fanout(buf->substr(0, buf->size() - 1));
+	batches.add();
+}
+
 World::RoomSnapshot World::snapshot(const string& roomId) const
 {
 	RoomSnapshot snap;
@@ -327,25 +968,18 @@ void World::broadcast_create_room(const string& roomId)
 	if (it == rooms_.end()) return;
 	const Room& r = it->second;
 
-	string line = "BROADCAST_CREATE_ROOM roomId=" + r.roomId + " master=" + r.master + " title=" + r.title;
-	send_tcp_to_all(line);
+	lobby_delta(proto::build(proto::msg::BROADCAST_CREATE_ROOM, r.roomId, r.master, r.title));
 }
 
 void World::cast_enter_room(const string& roomId, const RoomSnapshot snap)
 {
-	auto it = rooms_.find(roomId);
-	if (it == rooms_.end()) return;
-	const Room& r = it->second;
-
-	string line = "CAST_ENTER_ROOM roomId=" + roomId + " master=" + snap.master + " challenger=" + snap.challenger +
-		" title=" + snap.title + " rows=" + to_string(snap.rows) + " cols=" + to_string(snap.cols);
-	send_tcp_to_room(roomId, line);
+	if (rooms_.find(roomId) == rooms_.end()) return;
+	send_tcp_to_room(roomId, proto::build(proto::msg::CAST_ENTER_ROOM, roomId, snap.master, snap.challenger, snap.title, snap.rows, snap.cols));
 }
 
 void World::broadcast_enter_room(const string& roomId, const string& roomTitle)
 {
-	string line = "BROADCAST_ENTER_ROOM roomId=" + roomId + " title=" + roomTitle;
-	send_tcp_to_all(line);
+	lobby_delta(proto::build(proto::msg::BROADCAST_ENTER_ROOM, roomId, roomTitle));
 }
 
 void World::cast_change_ready(const string& roomId, const bool& isReady)
@@ -353,9 +987,7 @@ void World::cast_change_ready(const string& roomId, const bool& isReady)
 	auto it = rooms_.find(roomId);
 	if (it == rooms_.end()) return;
 	const Room& r = it->second;
-	string ready = isReady ? "True" : "False";
-	string line = "CAST_CHANGE_READY roomId=" + r.roomId + " isReady=" + ready;
-	send_tcp_to_room(roomId, line);
+	send_tcp_to_room(roomId, proto::build(proto::msg::CAST_CHANGE_READY, r.roomId, isReady));
 }
 
 void World::cast_game_start(const string& roomId)
@@ -363,15 +995,11 @@ void World::cast_game_start(const string& roomId)
 	auto it = rooms_.find(roomId);
 	if (it == rooms_.end()) return;
 	const Room& r = it->second;
-	string line = "CAST_GAME_START roomId=" + r.roomId;
-	string s = " cards=";
-	for (size_t i = 0; i < r.deck.cards.size(); i++) {
-		if (i) s += ",";
-		s += to_string(r.deck.cards[i]);
-	}
-	line += s;
-	line += " dur=500 all_dur=500 phase=1";
-	send_tcp_to_room(roomId, line);
+	// 관전자에게는 RES_WATCH_ROOM 과 같은 규칙으로 덱을 가린다 (뒤집힌 카드는 CAST_FLIP_RESULT 로 알게 된다)
+	string watch_line;
+	if (!r.watchers.empty())
+		watch_line = proto::build(proto::msg::CAST_GAME_START, r.roomId, vector<int>(r.deck.cards.size(), -1), 500, 500, 1);
+	send_tcp_to_room(roomId, proto::build(proto::msg::CAST_GAME_START, r.roomId, r.deck.cards, 500, 500, 1), watch_line);
 }
 
 void World::cast_game_peek_end(const string& roomId)
@@ -379,9 +1007,8 @@ void World::cast_game_peek_end(const string& roomId)
 	auto it = rooms_.find(roomId);
 	if (it == rooms_.end()) return;
 	const Room& r = it->second;
-	string line = "CAST_FIRST_FLIP_END roomId=" + r.roomId + " turn=" + r.turn +
-		" masterScore=" + to_string(r.score.at(r.master)) + " challengerScore=" + to_string(r.score.at(r.challenger));
-	send_tcp_to_room(roomId, line);
+	send_tcp_to_room(roomId, proto::build(proto::msg::CAST_FIRST_FLIP_END, r.roomId, r.turn,
+		r.score.at(r.master), r.score.at(r.challenger)));
 }
 
 void World::cast_flip_result(const string& roomId, int index)
@@ -390,10 +1017,8 @@ void World::cast_flip_result(const string& roomId, int index)
 	if (it == rooms_.end()) return;
 	const Room& r = it->second;
 	int value = r.deck.cards[index];
-	string line = "CAST_FLIP_RESULT roomId=" + roomId + " index=" + to_string(index) + " card=" + to_string(value) +
-		" turn=" + r.turn + " masterScore=" + to_string(r.score.at(r.master)) +
-		" challengerScore=" + to_string(r.score.at(r.challenger));
-	send_tcp_to_room(roomId, line);
+	send_tcp_to_room(roomId, proto::build(proto::msg::CAST_FLIP_RESULT, roomId, index, value, r.turn,
+		r.score.at(r.master), r.score.at(r.challenger)));
 }
 
 void World::cast_end_game(const string& roomId, int index)
@@ -403,20 +1028,15 @@ void World::cast_end_game(const string& roomId, int index)
 	const Room& r = it->second;
 
 	int value = r.deck.cards[index];
-	string winner = r.score.at(r.master) > r.score.at(r.challenger) ? r.master : r.challenger;
-	if (r.score.at(r.master) == r.score.at(r.challenger))
-		winner = "-";
+	int ms = r.score.at(r.master), cs = r.score.at(r.challenger);
+	string_view winner = ms == cs ? string_view("-") : ms > cs ? string_view(r.master) : string_view(r.challenger);
 
-	string line = "CAST_END_GAME roomId=" + roomId + " index=" + to_string(index) + " card=" + to_string(value) +
-		" turn=" + r.turn + " masterScore=" + to_string(r.score.at(r.master)) +
-		" challengerScore=" + to_string(r.score.at(r.challenger)) + " winner=" + winner;
-	send_tcp_to_room(roomId, line);
+	send_tcp_to_room(roomId, proto::build(proto::msg::CAST_END_GAME, roomId, index, value, r.turn, ms, cs, winner));
 }
 
 void World::broadcast_delete_room(const string& roomId, const string& master)
 {
-	string line = "BROADCAST_DELETE_ROOM roomId=" + roomId + " master=" + master;
-	send_tcp_to_all(line);
+	lobby_delta(proto::build(proto::msg::BROADCAST_DELETE_ROOM, roomId, master));
 }
 
 void World::broadcast_change_room_master(const string& roomId)
@@ -424,22 +1044,19 @@ void World::broadcast_change_room_master(const string& roomId)
 	auto it = rooms_.find(roomId);
 	if (it == rooms_.end()) return;
 	const Room& r = it->second;
-	string line = "BROADCAST_CHANGE_ROOM_MASTER roomId=" + roomId + " master=" + r.master;
-	send_tcp_to_all(line);
+	lobby_delta(proto::build(proto::msg::BROADCAST_CHANGE_ROOM_MASTER, roomId, r.master));
 }
 void World::broadcast_exit_room(const string& roomId)
 {
 	auto it = rooms_.find(roomId);
 	if (it == rooms_.end()) return;
 	const Room& r = it->second;
-	string line = "BROADCAST_EXIT_ROOM roomId=" + roomId + " title=" + r.title;
-	send_tcp_to_all(line);
+	lobby_delta(proto::build(proto::msg::BROADCAST_EXIT_ROOM, roomId, r.title));
 }
 
 void World::cast_exit_room(const string& roomId, const string& master, const string& exitActor)
 {
-	string line = "CAST_EXIT_ROOM roomId=" + roomId + " master=" + master + " exitActor=" + exitActor;
-	send_tcp_to_room(roomId, line);
+	send_tcp_to_room(roomId, proto::build(proto::msg::CAST_EXIT_ROOM, roomId, master, exitActor));
 }
 
 void World::cast_change_rule(const string& roomId)
@@ -447,23 +1064,19 @@ void World::cast_change_rule(const string& roomId)
 	auto it = rooms_.find(roomId);
 	if (it == rooms_.end()) return;
 	const Room& r = it->second;
-	string line = "CAST_CHANGE_RULE roomId=" + roomId + " cols=" + to_string(r.cols) + " rows=" + to_string(r.rows);
-	send_tcp_to_room(roomId, line);
+	send_tcp_to_room(roomId, proto::build(proto::msg::CAST_CHANGE_RULE, roomId, r.cols, r.rows));
 }
 
 void World::cast_forced_end_game(const string& roomId)
 {
-	auto it = rooms_.find(roomId);
-	if (it == rooms_.end()) return;
-	const Room& r = it->second;
+	if (rooms_.find(roomId) == rooms_.end()) return;
 
 	int phase = change_room_phase(roomId, (int)Phase::END);
 
-	string line = "CAST_FORCED_END_GAME roomId=" + roomId + " phase=" + to_string(phase);
-	send_tcp_to_room(roomId, line);
+	send_tcp_to_room(roomId, proto::build(proto::msg::CAST_FORCED_END_GAME, roomId, phase));
 }
 
-void World::broadcast_exit_server(const string& actor, const string& roomId, TcpSession* s)
+void World::broadcast_exit_server(const string& actor, const string& roomId, ControlSession* s)
 {
 	auto it = rooms_.find(roomId);
 	if (it != rooms_.end())
@@ -494,22 +1107,84 @@ void World::broadcast_exit_server(const string& actor, const string& roomId, Tcp
 		}
 	}
 	on_disconnect(actor, s);
-	string line = "BROADCAST_EXIT_SERVER actor=" + actor;
-	send_tcp_to_all(line);
+	send_tcp_to_all(proto::build(proto::msg::BROADCAST_EXIT_SERVER, actor));
 	sessions_->remove_actor(actor);
-	send_to_gateway("EXIT_USER id=" + actor + "\n");
+	send_to_gateway(proto::build(proto::msg::EXIT_USER, actor));
 }
 
 int main(int argc, char* argv[])
 {
 	common::title("WORLD");
+	if (argc > 1 && string(argv[1]) == "sim")
+		return Simulation(common::options(argc, argv, 2)).run();
+	if (argc > 1 && string(argv[1]) == "udpbench")
+		return UdpBench(common::options(argc, argv, 2)).run();
+	if (argc > 1 && string(argv[1]) == "snapbench")
+		return SnapshotBench(common::options(argc, argv, 2)).run();
+	if (argc > 1 && string(argv[1]) == "corebench")
+		return CoreBench(common::options(argc, argv, 2)).run();
+
 	int tcp = common::to_int(argc > 1 ? argv[1] : nullptr, 7100);
 	int udp_port = common::to_int(argc > 2 ? argv[2] : nullptr, 9001);
 
+	auto opts = common::options(argc, argv, 1);
+	net::set_write_limits(opts); // 클라이언트 송신 큐 한도 (wq_soft/wq_hard/wq_msgs)
+	net::set_recv_limits(opts);  // 클라이언트 수신 버퍼 = 한 줄 최대 길이 (max_line)
+	net::set_admission(opts, 2000, 0); // max_conns, accept_rate/burst (로그인 제한은 게이트웨이에서)
+	int overload_queue = common::opt_int(opts, "overload_queue", 5000);
+	int overload_overruns = common::opt_int(opts, "overload_overrun", 3);
+	int room_watchers = common::opt_int(opts, "room_watchers", 500); // 룸당 관전자 수
+	int n = common::opt_int(opts, "threads", max(1u, thread::hardware_concurrency()));
+	int world_id = common::opt_int(opts, "world", 1);
+	// UDP 토큰 서명 키는 게이트웨이와 같은 값을 명시해야 한다 (소스에 있는 개발용 키로는 누구나 토큰을 만들 수 있다)
+	if (opts["udp_key"].empty())
+	{
+		common::log("WORLD", "udp_key= is required (same value as the gateway)");
+		return 1;
+	}
+	string udp_key = opts["udp_key"];
+	string name = opts.count("name") ? opts["name"] : "World" + to_string(world_id);
+	string host = opts.count("host") ? opts["host"] : "127.0.0.1";
+	if (opts["io"] == "percore")
+	{
+		// 코어당 io_context: 코어 0 이 state/UDP/타이머, 세션은 accept 시 코어에 배정
+		net::IoPool pool(n, common::opt_int(opts, "pin", 0) != 0, opts["place"] == "least");
+		World w(pool.io(0), static_cast<unsigned short>(udp_port), udp_key, world_id, opts["udp"]);
+		w.set_advertise(name, host, tcp, udp_port);
+		w.set_overload_limits(overload_queue, overload_overruns);
+		w.set_watch_limit(room_watchers);
+		w.set_tick_limits(opts);
+		w.set_udp_limits(opts);
+		w.set_snapshot_limits(opts);
+		w.use_io_pool(&pool);
+		w.start();
+		TcpAcceptor tm(pool.io(0), tcp, w, &pool);
+#if defined(__linux__)
+		// 같은 호스트 게이트웨이용 공유 메모리 링크 (gateway worlds=shm:<path>)
+		unique_ptr<ShmAcceptor> shm_acc;
+		if (opts.count("shm"))
+			shm_acc = make_unique<ShmAcceptor>(pool.io(0), opts["shm"], w);
+#endif
+		common::log("WORLD", "io=percore cores=" + to_string(pool.size()));
+		pool.run();
+		return 0;
+	}
+
 	asio::io_context io;
-	World w(io, static_cast<unsigned short>(udp_port));
+	World w(io, static_cast<unsigned short>(udp_port), udp_key, world_id, opts["udp"]);
+	w.set_advertise(name, host, tcp, udp_port);
+	w.set_overload_limits(overload_queue, overload_overruns);
+	w.set_watch_limit(room_watchers);
+	w.set_tick_limits(opts);
+	w.set_udp_limits(opts);
+	w.set_snapshot_limits(opts);
+	w.start();
 	TcpAcceptor tm(io, tcp, w);
-	int n = max(1u, thread::hardware_concurrency());
+#if defined(__linux__)
+	unique_ptr<ShmAcceptor> shm_acc;
+	if (opts.count("shm"))
+		shm_acc = make_unique<ShmAcceptor>(io, opts["shm"], w);
+#endif
 	net::run_io_threads(io, n);
 	return 0;
 }
\ No newline at end of file
@@ -1,16 +1,28 @@
 #pragma once
 #include <iostream>
 #include <asio.hpp>
+#include "../common/handler_alloc.hpp"
+#include "../common/io_pool.hpp"
+#include "../common/rpc.hpp"
 #include <array>
+#include <atomic>
 #include <string>
 #include <chrono>
+#include <set>
+#include <tuple>
 #include <unordered_set>
 #include <vector>
 
 using namespace std;
 
 class UdpSessionManager;
-class TcpSession;
+class UdpFilter;
+class SnapshotPacker;
+struct SnapshotFrame;
+namespace net { template <class T> class TripleBuffer; }
+class UdpTransport;
+class ControlSession;
+class WorldClock;
 class Room;
 
 class World
@@ -25,21 +37,73 @@ public:
 		int phase;
 	};
 
-	unordered_map<string, weak_ptr<TcpSession>> ctrl_sessions_; // actor, session
+	unordered_map<string, weak_ptr<ControlSession>> ctrl_sessions_; // actor, session
 	unordered_map<string, Room> rooms_; // roomId, Room
 	uint64_t room_seq_ = 1;
 
 public:
-	World(asio::io_context& io, unsigned short udp_port, int tick_ms = 100);
+	World(asio::io_context& io, unsigned short udp_port, string udp_key, int world_id, const string& udp_backend = "asio");
+	World(asio::io_context& io, unique_ptr<UdpTransport> udp, WorldClock& clock, string udp_key, int world_id);
 	~World();
 
-	void register_udp_token_async(string token, string actor, int ttl_ms);
+	// GW_HELLO  mac  udp_key  ´ (¾ƾ Ʈ ũ Ѵ)
+	bool verify_gateway(const string& gw, const string& mac) const;
+
+	// Ʈ  Ͽ ö  (WORLD_REGISTER)
+	void set_advertise(string name, string host, int tcp_port, int udp_port);
+	//  : state  и ۾ ,   (1) tick и Ƚ
+	void set_overload_limits(int queue, int overruns) { overload_queue_ = queue; overload_overruns_ = overruns; }
+	// ϸ  (ENTER)  ʴ´ (state )
+	bool overloaded() const { return overloaded_; }
+	// UDP մ  ѵ (udp_move_rate/udp_move_burst/udp_hello_rate/udp_hello_burst/udp_hello_sources)
+	void set_udp_limits(const unordered_map<string, string>& opts);
+	// tick ֱ и  å (tick_ms/tick_idle_ms/tick_catchup/tick_budget_pct). set_snapshot_limits  
+	//  ɼ̴:  ߿ ٲ ʴ´
+	void set_tick_limits(const unordered_map<string, string>& opts);
+	//  Ŷ ũ ũ ǰ  Ŭ̾Ʈ ֱ/ 
+	// (snap_mtu/snap_bound/snap_scale/snap_repeat/simd, snap_budget/snap_budget_min/snap_hz_min/ping_ms/link_rtt_hi/link_jitter_hi/link_loss_pct)
+	void set_snapshot_limits(const unordered_map<string, string>& opts);
+	// tick/sweep Ÿ̸Ӹ Ǵ. set_*_limits    ڿ (ùķ̼ θ ʰ tick   )
+	void start();
 	asio::strand<Executor>& state_strand() { return strand_state_; }
+	void use_io_pool(net::IoPool* pool) { pool_ = pool; }
+
+	// state  ۾  (ھ : state ھ(0)  mailbox,  : strand)
+	// з ִ ۾   Ǵܿ 
+	template <class F>
+	void post_state(F&& f)
+	{
+		state_pending_.fetch_add(1, memory_order_relaxed);
+		auto task = [this, f = forward<F>(f)]() mutable
+			{
+				state_pending_.fetch_sub(1, memory_order_relaxed);
+				f();
+			};
+		if (pool_)
+			pool_->post(0, move(task));
+		else
+			asio::post(strand_state_, net::recycled(move(task)));
+	}
+	const WorldClock& clock() const { return clock_; }
+	int tick_ms() const { return tick_ms_; }
+
+	// Ÿ̸/  (state strand  ȣ, ùķ̼  ȣ)
+	void tick();
+	void sweep();
+	void on_datagram(const char* data, size_t n, const asio::ip::udp::endpoint& from);
 
 	//  ε/ (TCP Ʈ  ) 
-	void bind_session(const string& actor, shared_ptr<TcpSession> s);
-	void on_disconnect(const string& actor, TcpSession* s);
-	void bind_gateway_session(shared_ptr<TcpSession>& s);
+	void bind_session(const string& actor, shared_ptr<ControlSession> s);
+	void on_disconnect(const string& actor, ControlSession* s);
+	// Ʈ ũ  .  gw   ϳ , ˸   ִ ϳ 
+	void bind_gateway_session(shared_ptr<ControlSession>& s, const string& gw);
+	// Ʈ ENTER û:  ̰ų ٸ Ʈ̰  actor  false, ƴϸ  
+	//  gw  û(ũ ) true
+	bool reserve_actor(const string& actor, const string& gw);
+	// Ʈ Ͻ : Ʈ gw    Ŭ̾Ʈ actor   (CLIENT_BYE  )
+	void on_proxy_line(const string& gw, const string& actor, const string& line);
+	// Ͻ Ŭ̾Ʈ ϳ    Ʈ ũ
+	void send_to_client(const string& gw, const string& actor, const string& line);
 
 	// / 
 	string create_room(const string& master, const string& title, int rows, int cols);
@@ -75,36 +139,110 @@ public:
 	void cast_exit_room(const string& roomId, const string& master, const string& exitActor);
 	void cast_change_rule(const string& roomId);
 	void cast_forced_end_game(const string& roomId);
-	void broadcast_exit_server(const string& actor,const string& roomId, TcpSession* s);
+	void broadcast_exit_server(const string& actor,const string& roomId, ControlSession* s);
+
+	// κ :   ȭ(BROADCAST_*_ROOM)  actor Ը tick  Ƽ 
+	//      ȭ    ڰ  ȭ  ʰ Ѵ
+	void lobby_subscribe(const string& actor, bool on);
+	//    : "RES_ROOM_LIST page= pages= total= count="  ROOM_ITEM ٵ (  )
+	// phase < 0 ̸ , free  ּ  ڸ .  phase ȿ  ڸ  , ״  
+	string room_list(int phase, int free, int page, int size) const;
+
+	// : phase     (RES_WATCH_ROOM) ް,    ̺Ʈ tick  Ƽ ޴´
+	// 븶 ڴ set_watch_limit  ( ERR code=ROOM_FULL). reply    
+	bool watch_room(const string& roomId, const string& actor, string& reply);
+	void unwatch_room(const string& roomId, const string& actor);
+	void set_watch_limit(int n) { watch_limit_ = max(0, n); }
     
 private:
-	void recv();
 	void schedule_tick();
+	void on_tick_timer();
+	void wake_tick();
+	bool idle() const;
 	void schedule_sweep();
 	void broadcast_snapshot_fast();
 	void tcp_heart_beat();
+	void flush_lobby();
+	void lobby_delta(const string& line);
+	void flush_watch();
+	void watch_delta(Room& r, const string& line);
+	void flush_watchers(Room& r);
+	void index_room(Room& r);
+	void unindex_room(Room& r);
 
 	void send_tcp_to(const string& actor, const string& line);
-	void send_tcp_to_room(const string& roomId, const string& line);
+	// watch_line     ڿԴ line  װ  ( ī)
+	void send_tcp_to_room(const string& roomId, const string& line, const string& watch_line = string());
 	void send_tcp_to_all(const string& line);
 	void send_to_gateway(const string& line);
+	void send_gateway_frame(const string& gw, rpc::Type t, const string& payload);
+	void add_fanout(const string& gw, const string& actor);
+	void flush_fanout(const string& line);
+	void close_orphan_proxies();
+	void report_load();
 private:
 	// I/O
 	asio::io_context& io_;
-	asio::ip::udp::socket sock_;
-	asio::ip::udp::endpoint remote_;
-	array<char, 1500> buf_{};
+	net::IoPool* pool_ = nullptr;
+	unique_ptr<UdpTransport> udp_;
+	WorldClock& clock_;
 
 	// Ÿ̸
 	asio::steady_timer  tick_;
 	asio::steady_timer sweep_timer_;
-	int tick_ms_;
+	int tick_ms_ = 100;
+	int tick_idle_ms_ = 1000;   // UDP endpoint  ǵ   ֱ
+	int tick_catchup_ = 2;      //  tick    ٷ ̾  ( ģ tick  ǳʶڴ)
+	int tick_budget_pct_ = 50;  // tick ۾ ֱ  %    ʰ 
+	bool tick_timer_ = false;   // Ÿ̸ӷ tick   (ùķ̼  ȣ)
+	bool tick_idle_ = false;    //  ɸ Ÿ̸Ӱ idle ֱΰ
+	uint64_t tick_gen_ = 0;     // Ÿ̸Ӹ ٽ ɸ ٲ (  )
+	int tick_behind_ = 0;       // ޾  tick 
+	uint64_t sweep_count_ = 0;
+	chrono::steady_clock::time_point tick_due_; //   ð (۾ ðŭ и ʴ´)
+	int tick_overruns_ = 0; //    
+	atomic<int> state_pending_{ 0 };
+	int overload_queue_ = 5000;
+	int overload_overruns_ = 3;
+	bool overloaded_ = false;
+	double cpu_s_ = 0;      //     μ CPU ð
+	chrono::steady_clock::time_point cpu_at_;
 
 	// ȭ strand
 	asio::strand<Executor> strand_state_;
 	asio::strand<Executor> strand_tx_;
+	unique_ptr<SnapshotPacker> packer_; // strand_tx 
+	// state -> tx   (state  ۸ ä ͸ ٲٰ, tx    д´)
+	unique_ptr<net::TripleBuffer<SnapshotFrame>> snapshots_;
+	shared_ptr<const vector<pair<asio::ip::udp::endpoint, uint32_t>>> snap_clients_;
+	uint64_t snap_clients_version_ = ~0ull;
+	atomic<bool> tx_posted_{ false };
 
 	// /ū 
 	unique_ptr<UdpSessionManager> sessions_; 
-	weak_ptr<TcpSession> gateway_session_;
+	unique_ptr<UdpFilter> udp_filter_; // Ľ   Ŷ Ÿ
+	unordered_map<string, vector<weak_ptr<ControlSession>>> gateway_sessions_; // gw id, ũ 
+	int world_id_ = 1;
+	string link_key_; // GW_HELLO  (UDP ū  Ű)
+	string name_ = "World1";
+	string host_ = "127.0.0.1";
+	int tcp_port_ = 7100;
+	int udp_port_ = 9001;
+	struct Reservation
+	{
+		chrono::steady_clock::time_point until;
+		string gw;
+	};
+	unordered_map<string, Reservation> reserved_; // ENTER Ȯ  Ʈ HELLO  (actor, )
+	unordered_map<string, shared_ptr<ControlSession>> proxies_; // actor, Ʈ Ͻ Ŭ̾Ʈ
+	vector<pair<string, string>> fanout_; // Ʈ̺   ("a,b" Ǵ "*"). /ü   
+
+	// κ
+	set<tuple<int, int, string>> room_index_; // (phase,  ڸ , roomId)
+	unordered_set<string> lobby_;             //  actor
+	string lobby_batch_;                      // ̹ tick   ȭ ٵ ('\n'  մ´)
+
+	// 
+	vector<string> watch_dirty_; // ̹ tick   ̺Ʈ  
+	int watch_limit_ = 500;      //    (room_watchers)
 };